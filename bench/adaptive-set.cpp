@@ -0,0 +1,43 @@
+// Many small ordered sets: AVLTree<int> versus AdaptiveAVLTree<int>, which
+// keeps up to 64 keys in an inline sorted array.
+//
+//   g++ -std=c++17 -O2 bench/adaptive-set.cpp -o adaptive-set && ./adaptive-set
+
+#include "common.h"
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+template <typename Tree>
+void run(const char *name, int sets, int keysPerSet) {
+  std::mt19937 rng(42);
+  std::vector<Tree> trees(sets);
+
+  double insertMs = timeMs([&] {
+    for (int k = 0; k < keysPerSet; k++)
+      for (Tree &tree : trees)
+        tree.insert(static_cast<int>(rng() % 1000));
+  });
+
+  long found = 0;
+  double searchMs = timeMs([&] {
+    for (int round = 0; round < 4; round++)
+      for (Tree &tree : trees)
+        for (int k = 0; k < keysPerSet; k++)
+          found += tree.search(static_cast<int>(rng() % 1000)) != nullptr;
+  });
+
+  std::cout << name << ": insert " << insertMs << " ms, search " << searchMs
+            << " ms (found " << found << ")\n";
+}
+
+int main() {
+  const int sets = 200000;
+  for (int keysPerSet : {8, 32, 60}) {
+    std::cout << sets << " sets x " << keysPerSet << " keys\n";
+    run<avl::AVLTree<int>>("  AVLTree", sets, keysPerSet);
+    run<avl::AdaptiveAVLTree<int>>("  AdaptiveAVLTree", sets, keysPerSet);
+  }
+  return 0;
+}
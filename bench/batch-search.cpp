@@ -0,0 +1,65 @@
+// Lookup throughput of a loop over search() versus searchBatch() for the AVL
+// tree and the (randomly built, so roughly balanced) binary search tree.
+//
+//   g++ -std=c++17 -O2 bench/batch-search.cpp -o batch-search && ./batch-search
+
+#include "common.h"
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+namespace bst {
+#include "../source/bs-tree.cpp"
+}
+
+template <typename Tree>
+void run(const char *name, const std::vector<int> &keys,
+         const std::vector<int> &lookups) {
+  Tree tree;
+  for (int k : keys)
+    tree.insert(k);
+
+  long found = 0;
+  double loopMs = timeMs([&] {
+    for (int q : lookups)
+      found += tree.search(q) != nullptr;
+  });
+
+  // Request-sized batches, as a handler would issue them.
+  const size_t batch = 256;
+  std::vector<int> chunk;
+  std::vector<int *> out;
+  double batchMs = timeMs([&] {
+    for (size_t base = 0; base < lookups.size(); base += batch) {
+      size_t end = std::min(lookups.size(), base + batch);
+      chunk.assign(lookups.begin() + base, lookups.begin() + end);
+      tree.searchBatch(chunk, out);
+      for (int *p : out)
+        found += p != nullptr;
+    }
+  });
+
+  std::cout << name << ": search loop " << loopMs << " ms, searchBatch "
+            << batchMs << " ms (found " << found << ")\n";
+}
+
+int main() {
+  const int n = 4000000;
+  const int queries = 4000000;
+  std::mt19937 rng(42);
+
+  std::vector<int> keys(n);
+  for (int i = 0; i < n; ++i)
+    keys[i] = 2 * i;
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  std::vector<int> lookups(queries);
+  for (int &q : lookups)
+    q = static_cast<int>(rng() % (2 * n));
+
+  std::cout << "n = " << n << ", queries = " << queries << "\n";
+  run<avl::AVLTree<int>>("AVLTree", keys, lookups);
+  run<bst::BST<int>>("BST", keys, lookups);
+  return 0;
+}
@@ -0,0 +1,44 @@
+// Shared setup for the benchmarks. Every snippet in source/ is a standalone
+// file with its own Node and main(), so a benchmark includes each snippet
+// inside its own namespace. All standard headers the snippets use must be
+// included here first: their include guards then keep them out of those
+// namespaces.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+template <typename Fn> double timeMs(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
@@ -0,0 +1,72 @@
+// Memory footprint and speed of AVLTree<int> (one heap-allocated Node per
+// key) versus CompactAVLTree<int> (32-bit indices into one node array).
+// Each variant runs in a forked child so freed memory of one does not hide
+// the footprint of the next. Resident memory is read from /proc/self/statm,
+// so this runs on Linux only.
+//
+//   g++ -std=c++17 -O2 bench/compact-avl.cpp -o compact-avl && ./compact-avl
+
+#include "common.h"
+
+#include <fstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+namespace compact {
+#include "../source/compact-avl.cpp"
+}
+
+long residentBytes() {
+  long pages = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+template <typename Tree>
+void run(const char *name, const std::vector<int> &keys) {
+  if (fork() != 0) {
+    wait(nullptr);
+    return;
+  }
+
+  long before = residentBytes();
+  Tree tree;
+  double insertMs = timeMs([&] {
+    for (int k : keys)
+      tree.insert(k);
+  });
+  long used = residentBytes() - before;
+
+  long found = 0;
+  double searchMs = timeMs([&] {
+    for (int k : keys)
+      found += tree.search(k) != nullptr;
+  });
+
+  std::cout << name << ": " << static_cast<double>(used) / keys.size()
+            << " bytes/key, insert " << insertMs << " ms, search " << searchMs
+            << " ms (found " << found << ")" << std::endl;
+  _exit(0);
+}
+
+int main() {
+  const int n = 4000000;
+  std::mt19937 rng(42);
+
+  std::vector<int> keys(n);
+  for (int i = 0; i < n; ++i)
+    keys[i] = i;
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  std::cout << "n = " << n << ", sizeof(Node<int>) = " << sizeof(avl::Node<int>)
+            << ", sizeof(CompactNode<int>) = "
+            << sizeof(compact::CompactNode<int>) << std::endl;
+  run<avl::AVLTree<int>>("AVLTree", keys);
+  run<compact::CompactAVLTree<int>>("CompactAVLTree", keys);
+  return 0;
+}
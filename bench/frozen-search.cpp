@@ -0,0 +1,46 @@
+// Lookup throughput of AVLTree::search versus the Eytzinger array returned by
+// AVLTree::freeze().
+//
+//   g++ -std=c++17 -O2 bench/frozen-search.cpp -o frozen-search && ./frozen-search
+
+#include "common.h"
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+int main() {
+  const int n = 4000000;
+  const int queries = 4000000;
+  std::mt19937 rng(42);
+
+  std::vector<int> keys(n);
+  for (int i = 0; i < n; ++i)
+    keys[i] = 2 * i;
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  std::vector<int> lookups(queries);
+  for (int &q : lookups)
+    q = static_cast<int>(rng() % (2 * n));
+
+  avl::AVLTree<int> tree;
+  for (int k : keys)
+    tree.insert(k);
+  auto frozen = tree.freeze();
+
+  long found = 0;
+  double treeMs = timeMs([&] {
+    for (int q : lookups)
+      found += tree.search(q) != nullptr;
+  });
+  double frozenMs = timeMs([&] {
+    for (int q : lookups)
+      found += frozen.search(q) != nullptr;
+  });
+
+  std::cout << "n = " << n << ", queries = " << queries << "\n";
+  std::cout << "AVLTree::search: " << treeMs << " ms\n";
+  std::cout << "FrozenTree::search: " << frozenMs << " ms\n";
+  std::cout << "(found " << found << ")\n";
+  return 0;
+}
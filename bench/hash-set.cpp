@@ -0,0 +1,64 @@
+// Membership tests: HashSet<int> versus AVLTree<int> and std::unordered_set.
+// Half of the lookups hit, half miss.
+//
+//   g++ -std=c++17 -O2 bench/hash-set.cpp -o hash-set && ./hash-set
+
+#include "common.h"
+
+#include <unordered_set>
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+namespace hash {
+#include "../source/hash-set.cpp"
+}
+
+struct StdSet {
+  std::unordered_set<int> set;
+  void insert(int val) { set.insert(val); }
+  const int *search(int val) {
+    auto it = set.find(val);
+    return it == set.end() ? nullptr : &*it;
+  }
+};
+
+template <typename Set>
+void run(const char *name, const std::vector<int> &keys,
+         const std::vector<int> &lookups) {
+  Set set;
+  double insertMs = timeMs([&] {
+    for (int k : keys)
+      set.insert(k);
+  });
+
+  long found = 0;
+  double searchMs = timeMs([&] {
+    for (int q : lookups)
+      found += set.search(q) != nullptr;
+  });
+
+  std::cout << name << ": insert " << insertMs << " ms, search " << searchMs
+            << " ms (found " << found << ")\n";
+}
+
+int main() {
+  const int n = 2000000;
+  std::mt19937 rng(42);
+
+  std::vector<int> keys(n);
+  for (int i = 0; i < n; ++i)
+    keys[i] = 2 * i;
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  std::vector<int> lookups(2 * n);
+  for (int &q : lookups)
+    q = static_cast<int>(rng() % (2 * n));
+
+  std::cout << "n = " << n << ", lookups = " << lookups.size() << "\n";
+  run<hash::HashSet<int>>("HashSet", keys, lookups);
+  run<StdSet>("std::unordered_set", keys, lookups);
+  run<avl::AVLTree<int>>("AVLTree", keys, lookups);
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Bulk construction and traversal on a ThreadPool, from one thread up to all
+// hardware threads: AVLTree::buildParallel (parallel sort plus balanced
+// build), AVLTree::reduceParallel (sum over the keys) and
+// Heap::buildParallel (level-parallel heapify). The sequential baselines are
+// one insert() per key and sort plus assignSorted().
+//
+//   g++ -std=c++17 -O2 -pthread bench/parallel-build.cpp -o parallel-build &&
+//   ./parallel-build
+
+#include "common.h"
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+namespace heap {
+#include "../source/heap.cpp"
+}
+
+int main() {
+  const int n = 4000000;
+  std::mt19937 rng(42);
+
+  std::vector<int> keys(n);
+  for (int &k : keys)
+    k = static_cast<int>(rng() % (2 * n));
+
+  std::cout << "n = " << n << "\n";
+
+  double insertMs = timeMs([&] {
+    avl::AVLTree<int> tree;
+    for (int k : keys)
+      tree.insert(k);
+  });
+  double sortedMs = timeMs([&] {
+    std::vector<int> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    avl::AVLTree<int> tree;
+    tree.assignSorted(sorted);
+  });
+  double heapInsertMs = timeMs([&] {
+    heap::MinHeap<int> h;
+    for (int k : keys)
+      h.insert(k);
+  });
+  std::cout << "AVL insert loop " << insertMs << " ms, sort + assignSorted "
+            << sortedMs << " ms, heap insert loop " << heapInsertMs
+            << " ms\n";
+
+  int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+  if (maxThreads < 1)
+    maxThreads = 1;
+  std::vector<int> counts;
+  for (int t = 1; t < maxThreads; t *= 2)
+    counts.push_back(t);
+  counts.push_back(maxThreads);
+
+  double baseBuild = 0, baseReduce = 0, baseHeap = 0;
+  for (int threads : counts) {
+    avl::ThreadPool treePool(threads);
+    heap::ThreadPool heapPool(threads);
+
+    avl::AVLTree<int> tree;
+    double buildMs = timeMs([&] { tree.buildParallel(keys, treePool); });
+
+    long long sum = 0;
+    double reduceMs = timeMs([&] {
+      sum = tree.reduceParallel(
+          treePool, 0LL,
+          [](const int &k) { return static_cast<long long>(k); },
+          [](long long a, long long b) { return a + b; });
+    });
+
+    heap::MinHeap<int> h;
+    double heapMs = timeMs([&] { h.buildParallel(keys, heapPool); });
+
+    if (threads == 1) {
+      baseBuild = buildMs;
+      baseReduce = reduceMs;
+      baseHeap = heapMs;
+    }
+    std::cout << threads << " threads: AVL build " << buildMs << " ms (x"
+              << baseBuild / buildMs << "), reduce " << reduceMs << " ms (x"
+              << baseReduce / reduceMs << "), heapify " << heapMs << " ms (x"
+              << baseHeap / heapMs << ") (sum " << sum << ", root "
+              << h.peek() << ")\n";
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+// Write-throughput comparison of source/avl-tree.cpp and source/rb-tree.cpp.
+//
+//   g++ -std=c++17 -O2 bench/rb-vs-avl.cpp -o rb-vs-avl && ./rb-vs-avl
+
+#include "common.h"
+
+namespace avl {
+#include "../source/avl-tree.cpp"
+}
+
+namespace rb {
+#include "../source/rb-tree.cpp"
+}
+
+template <typename Tree>
+double run(const std::vector<int> &keys, const std::vector<int> &removals) {
+  return timeMs([&] {
+    Tree tree;
+    for (int k : keys)
+      tree.insert(k);
+    for (int k : removals)
+      tree.remove(k);
+    for (int k : keys)
+      tree.insert(k);
+  });
+}
+
+int main() {
+  const int n = 1000000;
+  std::mt19937 rng(42);
+
+  std::vector<int> sorted(n);
+  for (int i = 0; i < n; ++i)
+    sorted[i] = i;
+
+  std::vector<int> shuffled = sorted;
+  std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+  std::vector<int> removals = shuffled;
+  std::shuffle(removals.begin(), removals.end(), rng);
+  removals.resize(n / 2);
+
+  std::cout << "n = " << n << " (insert all, remove half, reinsert all)"
+            << "\n";
+  std::cout << "random keys: AVL " << run<avl::AVLTree<int>>(shuffled, removals)
+            << " ms, RB " << run<rb::RBTree<int>>(shuffled, removals)
+            << " ms\n";
+  std::cout << "sorted keys: AVL " << run<avl::AVLTree<int>>(sorted, removals)
+            << " ms, RB " << run<rb::RBTree<int>>(sorted, removals) << " ms\n";
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Connection timeouts on TimingWheel versus a MinHeap timer queue. One tick
+// is 1 ms. Every tick a few hundred random connections see activity, which
+// cancels their pending timer and arms a new one: mostly 10 s idle
+// timeouts, some short retransmit timers that often fire, and a few
+// day-long session expiries. Three wheel levels cover 2^24 ms, about 4.6
+// hours, so the session expiries overflow into the wheel's heap. The heap
+// queue cancels lazily, the usual way with a binary heap: a generation per
+// connection, with stale entries dropped when they reach the root.
+//
+//   g++ -std=c++17 -O2 -pthread bench/timing-wheel.cpp -o timing-wheel &&
+//   ./timing-wheel
+
+#include "common.h"
+
+namespace heap {
+#include "../source/heap.cpp"
+}
+
+const int connections = 200000;
+const int ticks = 60000;
+const int activityPerTick = 400;
+
+struct HeapEntry {
+  uint64_t deadline;
+  uint32_t conn;
+  uint32_t generation;
+
+  bool operator<(const HeapEntry &other) const {
+    return deadline < other.deadline;
+  }
+};
+
+struct HeapTimers {
+  heap::MinHeap<HeapEntry> queue;
+  std::vector<uint32_t> generation = std::vector<uint32_t>(connections);
+  std::vector<bool> armed = std::vector<bool>(connections);
+
+  bool cancel(uint32_t conn) {
+    bool was = armed[conn];
+    armed[conn] = false;
+    generation[conn]++;
+    return was;
+  }
+
+  void schedule(uint64_t deadline, uint32_t conn) {
+    armed[conn] = true;
+    queue.insert({deadline, conn, generation[conn]});
+  }
+
+  template <typename Fn> void advance(uint64_t now, Fn fire) {
+    while (!queue.empty() && queue.peek().deadline <= now) {
+      HeapEntry entry = queue.popRoot();
+      if (entry.generation == generation[entry.conn]) {
+        armed[entry.conn] = false;
+        fire(entry.conn);
+      }
+    }
+  }
+};
+
+struct WheelTimers {
+  using Wheel = heap::TimingWheel<uint32_t, 3>;
+  Wheel wheel;
+  std::vector<Wheel::TimerId> ids = std::vector<Wheel::TimerId>(connections);
+
+  bool cancel(uint32_t conn) { return ids[conn] && wheel.cancel(ids[conn]); }
+
+  void schedule(uint64_t deadline, uint32_t conn) {
+    ids[conn] = wheel.schedule(deadline, conn);
+  }
+
+  template <typename Fn> void advance(uint64_t now, Fn fire) {
+    wheel.advance(now, fire);
+  }
+};
+
+template <typename Timers> void run(const char *name) {
+  Timers timers;
+  std::mt19937 rng(42);
+  long armed = 0, cancelled = 0, fired = 0;
+
+  double ms = timeMs([&] {
+    for (uint64_t now = 1; now <= ticks; now++) {
+      for (int i = 0; i < activityPerTick; i++) {
+        uint32_t conn = rng() % connections;
+        uint32_t kind = rng() % 100;
+        uint64_t delay;
+        if (kind < 80) {
+          delay = 10000 + rng() % 2000;
+        } else if (kind < 98) {
+          delay = 200 + rng() % 800;
+        } else {
+          delay = 86400000 + rng() % 3600000;
+        }
+        cancelled += timers.cancel(conn);
+        timers.schedule(now + delay, conn);
+        armed++;
+      }
+      timers.advance(now, [&](uint32_t) { fired++; });
+    }
+  });
+
+  std::cout << name << ": " << ms << " ms, "
+            << ms * 1e6 / (armed + cancelled + fired) << " ns/op (armed "
+            << armed << ", cancelled " << cancelled << ", fired " << fired
+            << ")\n";
+}
+
+int main() {
+  std::cout << connections << " connections, " << ticks << " ticks, "
+            << activityPerTick << " events per tick\n";
+  run<HeapTimers>("MinHeap, lazy cancel");
+  run<WheelTimers>("TimingWheel");
+  return 0;
+}
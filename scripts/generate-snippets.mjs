@@ -0,0 +1,148 @@
+// Builds src/snippets.ts from the C++ sources in source/, so the extension
+// always inserts the maintained code. Each snippet is its source file with
+// the demo (main() and the helpers written only for it) stripped. The
+// option fragments in source/options/ are copied along for the variants
+// that src/variants.ts assembles. Runs as part of `npm run compile`.
+import { readFileSync, writeFileSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+const root = join(dirname(fileURLToPath(import.meta.url)), '..');
+
+// demoFrom: first line of demo-only code placed before main().
+// arrayBacked: the array-backed alternative, either another file or the
+// part of the same file starting at a line.
+// threadSafe: whether to offer the Locked wrapper. Queue already has
+// BlockingQueue, and the persistent tree and mapped set are immutable
+// snapshots that readers may share.
+const manifest = [
+	{ label: 'AVL Tree', file: 'avl-tree.cpp', arrayBacked: { file: 'compact-avl.cpp' }, threadSafe: true },
+	{ label: 'Binary Search Tree', file: 'bs-tree.cpp', threadSafe: true },
+	{ label: 'Red-Black Tree', file: 'rb-tree.cpp', threadSafe: true },
+	{ label: 'Persistent AVL Tree', file: 'persistent-avl.cpp', threadSafe: false },
+	{ label: 'Compact AVL Tree', file: 'compact-avl.cpp', threadSafe: true },
+	{ label: 'Mapped Set', file: 'mapped-set.cpp', threadSafe: false },
+	{ label: 'Heap', file: 'heap.cpp', threadSafe: true },
+	{ label: 'Stack', file: 'stack.cpp', threadSafe: true },
+	{ label: 'Queue', file: 'queue.cpp', demoFrom: '// Minimal fire-and-forget coroutine type for the demo.', threadSafe: false },
+	{ label: 'Deque', file: 'deque.cpp', arrayBacked: { from: 'template <typename T> struct Segment {' }, threadSafe: true },
+	{ label: 'Hash Set', file: 'hash-set.cpp', threadSafe: true },
+	{ label: 'Intrusive Containers', file: 'intrusive.cpp', demoFrom: 'struct Job {', threadSafe: true },
+];
+
+// Definitions copied into several files, since each snippet is inserted on
+// its own. comment: whether the doc comment above must match as well.
+// end: closing line, `};` unless given.
+const sharedCode = [
+	{ start: 'class ThreadPool {', files: ['avl-tree.cpp', 'heap.cpp'], comment: true },
+	{ start: 'class FrozenTree {', files: ['avl-tree.cpp', 'bs-tree.cpp'], comment: true },
+	{ start: 'struct DumpHeader {', files: ['avl-tree.cpp', 'bs-tree.cpp', 'heap.cpp', 'mapped-set.cpp'], comment: false },
+	{
+		start: 'bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {',
+		files: ['avl-tree.cpp', 'bs-tree.cpp', 'heap.cpp'],
+		comment: true,
+		end: '}',
+	},
+];
+
+const fragmentFiles = {
+	nodePool: 'node-pool.h',
+	locked: 'locked.h',
+	instrumentation: 'instrumentation.h',
+};
+
+function readLines(path) {
+	return readFileSync(join(root, path), 'utf8').replace(/\s+$/, '').split('\n');
+}
+
+function findLine(lines, text, file) {
+	const index = lines.findIndex(line => line === text);
+	if (index < 0) {
+		throw new Error(`${file}: line not found: ${text}`);
+	}
+	return index;
+}
+
+// Index where the demo starts: at demoFrom or main(), moved back over the
+// blank lines, includes and #if lines that only the demo needs.
+function demoStart(lines, file, demoFrom) {
+	let end = demoFrom !== undefined
+		? findLine(lines, demoFrom, file)
+		: lines.findIndex(line => line.startsWith('int main('));
+	if (end < 0) {
+		return lines.length;
+	}
+	while (end > 0 && /^(\s*$|#include |#if )/.test(lines[end - 1])) {
+		end--;
+	}
+	return end;
+}
+
+function libraryLines(file, demoFrom) {
+	const lines = readLines(join('source', file));
+	return lines.slice(0, demoStart(lines, file, demoFrom));
+}
+
+// Leading includes of the file followed by the lines from `from` on.
+function tailLines(lines, from, file) {
+	const start = findLine(lines, from, file);
+	let includes = 0;
+	while (includes < lines.length && /^(#include |#if |#endif)/.test(lines[includes])) {
+		includes++;
+	}
+	return [...lines.slice(0, includes), '', ...lines.slice(start)];
+}
+
+// Lines from `start` to the closing line, preceded by its template line and,
+// if asked, its doc comment.
+function definition(file, start, comment, close = '};') {
+	const lines = readLines(join('source', file));
+	let begin = findLine(lines, start, file);
+	const end = lines.indexOf(close, begin);
+	if (end < 0) {
+		throw new Error(`${file}: no closing line for: ${start}`);
+	}
+	if (begin > 0 && lines[begin - 1].startsWith('template <')) {
+		begin--;
+	}
+	while (comment && begin > 0 && lines[begin - 1].startsWith('//')) {
+		begin--;
+	}
+	return lines.slice(begin, end + 1).join('\n');
+}
+
+for (const { start, files, comment, end } of sharedCode) {
+	const [first, ...rest] = files;
+	const expected = definition(first, start, comment, end);
+	for (const file of rest) {
+		if (definition(file, start, comment, end) !== expected) {
+			throw new Error(`source/${file}: ${start} differs from the copy in source/${first}`);
+		}
+	}
+}
+
+const snippets = manifest.map(entry => {
+	const body = libraryLines(entry.file, entry.demoFrom);
+	const snippet = { label: entry.label, body, threadSafe: entry.threadSafe };
+	if (entry.arrayBacked?.file) {
+		snippet.arrayBacked = libraryLines(entry.arrayBacked.file);
+	} else if (entry.arrayBacked?.from) {
+		snippet.arrayBacked = tailLines(body, entry.arrayBacked.from, entry.file);
+	}
+	return snippet;
+});
+
+const fragments = Object.fromEntries(Object.entries(fragmentFiles).map(
+	([name, file]) => [name, readLines(join('source', 'options', file))]));
+
+const output = `// Generated by scripts/generate-snippets.mjs from source/. Do not edit:
+// run \`npm run compile\` after changing the C++ sources.
+import type { Fragments, SnippetTemplate } from './variants';
+
+export const snippets: SnippetTemplate[] = ${JSON.stringify(snippets, null, 4)};
+
+export const fragments: Fragments = ${JSON.stringify(fragments, null, 4)};
+`;
+
+writeFileSync(join(root, 'src', 'snippets.ts'), output);
+console.log(`Generated ${snippets.length} snippets into src/snippets.ts`);
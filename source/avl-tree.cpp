@@ -1,4 +1,19 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 template <typename T>
 struct Node {
@@ -7,7 +22,219 @@ struct Node {
   Node *right = nullptr;
   int height = 1;
 
-  Node(T v) : val(v) {}
+  Node(T v) : val(std::move(v)) {}
+};
+
+// Binary dump layout: header followed by `count` raw elements. T must be
+// trivially copyable, so the file can also be mmapped and searched in place.
+struct DumpHeader {
+  char magic[4];
+  uint32_t elemSize;
+  uint64_t count;
+};
+
+// Reads the `count` elements that follow a DumpHeader into out. count comes
+// from the file, so it is checked against the bytes left in the stream
+// before out is sized. A stream that cannot seek is read in bounded steps
+// instead, so a corrupt count ends in a short read, not a huge allocation.
+template <typename T>
+bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {
+  uint64_t step = count;
+  std::streampos here = in.tellg();
+  if (here != std::streampos(-1) && in.seekg(0, std::ios::end)) {
+    uint64_t left = static_cast<uint64_t>(in.tellg() - here);
+    in.seekg(here);
+    if (count > left / sizeof(T))
+      return false;
+  } else {
+    in.clear();
+    step = 1 << 16;
+  }
+  out.clear();
+  while (out.size() < count) {
+    size_t done = out.size();
+    size_t n = static_cast<size_t>(std::min<uint64_t>(step, count - done));
+    out.resize(done + n);
+    in.read(reinterpret_cast<char *>(out.data() + done), n * sizeof(T));
+    if (!in)
+      return false;
+  }
+  return true;
+}
+
+// Immutable search array in Eytzinger (BFS) order produced by freeze(). Node
+// k has children 2k and 2k + 1, so the top levels share a few cache lines and
+// lookup is a branchless descent that prefetches four levels ahead.
+template <typename T, bool (*Comp)(const T &, const T &)>
+class FrozenTree {
+public:
+  explicit FrozenTree(const std::vector<T> &sorted) {
+    arr.resize(sorted.size() + 1);
+    int pos = 0;
+    build(sorted, pos, 1);
+  }
+
+  const T *search(const T &val) const {
+    const int n = size();
+    const int block = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+    int k = 1;
+    while (k <= n) {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(arr.data() + static_cast<size_t>(k) * block);
+#endif
+      k = 2 * k + Comp(arr[k], val);
+    }
+    // undo the trailing right turns to get the lower bound
+    while (k & 1)
+      k >>= 1;
+    k >>= 1;
+    if (k == 0 || Comp(val, arr[k]))
+      return nullptr;
+    return &arr[k];
+  }
+
+  int size() const { return static_cast<int>(arr.size()) - 1; }
+  bool empty() const { return size() == 0; }
+
+private:
+  std::vector<T> arr; // arr[0] unused
+
+  void build(const std::vector<T> &sorted, int &pos, int k) {
+    if (k > size())
+      return;
+    build(sorted, pos, 2 * k);
+    arr[k] = sorted[pos++];
+    build(sorted, pos, 2 * k + 1);
+  }
+};
+
+// Fixed set of worker threads for the parallel bulk operations. run() is a
+// fork-join step: the calling thread takes part, and it returns once every
+// task is done. Tasks of one run() must not call run() on the same pool.
+class ThreadPool {
+public:
+  // threads counts the calling thread, so ThreadPool(1) runs tasks inline.
+  explicit ThreadPool(
+      int threads = static_cast<int>(std::thread::hardware_concurrency())) {
+    job = nullptr;
+    jobSize = 0;
+    next = 0;
+    pending = 0;
+    active = 0;
+    generation = 0;
+    stopping = false;
+    for (int i = 1; i < threads; i++) {
+      workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Calls fn(i) for every i in [0, count), spread over the pool. The first
+  // exception thrown by a task is rethrown here after all tasks finished.
+  template <typename Fn> void run(int count, Fn fn) {
+    if (count <= 0)
+      return;
+    if (workers.empty() || count == 1) {
+      for (int i = 0; i < count; i++) {
+        fn(i);
+      }
+      return;
+    }
+
+    std::function<void(int)> task = fn;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &task;
+      jobSize = count;
+      next = 0;
+      pending = count;
+      error = nullptr;
+      generation++;
+    }
+    wake.notify_all();
+    work(task, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0 && active == 0; });
+    job = nullptr;
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const std::function<void(int)> *job;
+  int jobSize;
+  std::atomic<int> next; // next task index to hand out
+  int pending;           // tasks not finished yet
+  int active;            // workers inside work(), run() waits for them too
+  uint64_t generation;
+  bool stopping;
+  std::exception_ptr error;
+
+  void workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+      const std::function<void(int)> *task;
+      int count;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+          return;
+        seen = generation;
+        if (job == nullptr)
+          continue;
+        task = job;
+        count = jobSize;
+        active++;
+      }
+      work(*task, count);
+      std::lock_guard<std::mutex> lock(mutex);
+      active--;
+      if (pending == 0 && active == 0)
+        done.notify_all();
+    }
+  }
+
+  void work(const std::function<void(int)> &task, int count) {
+    int finished = 0;
+    for (int i; (i = next.fetch_add(1)) < count;) {
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+      finished++;
+    }
+    if (finished > 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending -= finished;
+      if (pending == 0 && active == 0)
+        done.notify_all();
+    }
+  }
 };
 
 template <typename T, bool (*Comp)(const T &, const T &)>
@@ -15,25 +242,282 @@ class AVLAbstract {
 public:
   AVLAbstract() { root = nullptr; }
 
+  // Deep copy with the same shape as other, see cloneTree.
+  AVLAbstract(const AVLAbstract &other) { root = cloneTree(other.root); }
+
+  AVLAbstract(AVLAbstract &&other) noexcept {
+    root = other.root;
+    other.root = nullptr;
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  AVLAbstract &operator=(AVLAbstract other) noexcept {
+    swap(other);
+    return *this;
+  }
+
   ~AVLAbstract() { clear(root); }
 
-  void insert(T val) { root = insertNode(root, val); }
-  T *search(T val) { return searchNode(root, val); }
-  bool remove(T val) {
+  void swap(AVLAbstract &other) noexcept { std::swap(root, other.root); }
+
+  // Returns false if an equal key was already present.
+  bool insert(const T &val) {
+    bool inserted = false;
+    root = insertNode(root, val, inserted);
+    return inserted;
+  }
+  bool insert(T &&val) {
+    bool inserted = false;
+    root = insertNode(root, std::move(val), inserted);
+    return inserted;
+  }
+  T *search(const T &val) { return searchNode(root, val); }
+  bool remove(const T &val) {
     bool removed = false;
     root = removeNode(root, val, removed);
     return removed;
   }
 
-  void print() {
-    print(root, 0);
-    std::cout << std::endl;
+  // Looks up every key in keys and stores the result (or nullptr) at the same
+  // index of out. Descents run in groups that advance one level per round, so
+  // the cache misses of different keys overlap instead of queueing up.
+  void searchBatch(const std::vector<T> &keys, std::vector<T *> &out) {
+    const size_t group = 16;
+    Node<T> *cursor[group];
+    out.assign(keys.size(), nullptr);
+
+    for (size_t base = 0; base < keys.size(); base += group) {
+      size_t n = std::min(group, keys.size() - base);
+      for (size_t i = 0; i < n; i++) {
+        cursor[i] = root;
+      }
+
+      size_t active = n;
+      while (active > 0) {
+        active = 0;
+        for (size_t i = 0; i < n; i++) {
+          Node<T> *node = cursor[i];
+          if (!node)
+            continue;
+
+          int r = compare(keys[base + i], node->val);
+          if (r == 0) {
+            out[base + i] = &(node->val);
+            cursor[i] = nullptr;
+            continue;
+          }
+
+          node = r < 0 ? node->left : node->right;
+#if defined(__GNUC__) || defined(__clang__)
+          if (node)
+            __builtin_prefetch(node);
+#endif
+          cursor[i] = node;
+          if (node)
+            active++;
+        }
+      }
+    }
+  }
+
+  // Formats the whole tree into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    std::vector<std::pair<Node<T> *, int>> stack;
+    Node<T> *node = root;
+    int depth = 0;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back({node, depth});
+        node = node->right;
+        depth++;
+      }
+      node = stack.back().first;
+      depth = stack.back().second;
+      stack.pop_back();
+
+      for (int i = 0; i < depth; i++) {
+        buffer << "   ";
+      }
+      buffer << node->val << '\n';
+
+      node = node->left;
+      depth++;
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(val) for every key in sorted order, without recursion.
+  template <typename Fn> void visitInOrder(Fn fn) const {
+    visitSubtree(root, fn);
+  }
+
+  // Calls fn(val) for every key, spread over the pool: the subtrees below
+  // the top levels are separate tasks. fn is called concurrently and in no
+  // particular order, so it must be thread-safe.
+  template <typename Fn> void visitParallel(ThreadPool &pool, Fn fn) const {
+    std::vector<Span> spans;
+    collectSpans(root, splitDepth(pool), spans);
+    pool.run(static_cast<int>(spans.size()), [&](int i) {
+      if (spans[i].whole) {
+        visitSubtree(spans[i].node, fn);
+      } else {
+        fn(spans[i].node->val);
+      }
+    });
+  }
+
+  // Folds combine(acc, map(val)) over the keys in sorted order, starting from
+  // identity. Each subtree below the top levels is folded as its own task
+  // and the partial results are combined in key order, so combine must be
+  // associative with identity as its neutral element, but need not be
+  // commutative. map is called concurrently.
+  template <typename R, typename Map, typename Combine>
+  R reduceParallel(ThreadPool &pool, R identity, Map map,
+                   Combine combine) const {
+    struct Partial {
+      R acc;
+    };
+    std::vector<Span> spans;
+    collectSpans(root, splitDepth(pool), spans);
+    std::vector<Partial> partial(spans.size(), Partial{identity});
+    pool.run(static_cast<int>(spans.size()), [&](int i) {
+      R &acc = partial[i].acc;
+      if (spans[i].whole) {
+        visitSubtree(spans[i].node, [&](const T &val) {
+          acc = combine(std::move(acc), map(val));
+        });
+      } else {
+        acc = combine(std::move(acc), map(spans[i].node->val));
+      }
+    });
+
+    R result = std::move(identity);
+    for (Partial &p : partial) {
+      result = combine(std::move(result), std::move(p.acc));
+    }
+    return result;
+  }
+
+  // Calls fn(val, depth) level by level, root first.
+  template <typename Fn> void visitLevelOrder(Fn fn) const {
+    std::vector<std::pair<Node<T> *, int>> level;
+    if (root)
+      level.push_back({root, 0});
+    for (size_t i = 0; i < level.size(); i++) {
+      Node<T> *node = level[i].first;
+      int depth = level[i].second;
+      fn(node->val, depth);
+      if (node->left)
+        level.push_back({node->left, depth + 1});
+      if (node->right)
+        level.push_back({node->right, depth + 1});
+    }
+  }
+
+  // Snapshot of the current keys for read-only phases, see FrozenTree.
+  FrozenTree<T, Comp> freeze() const {
+    std::vector<T> sorted;
+    collect(sorted);
+    return FrozenTree<T, Comp>(sorted);
+  }
+
+  // Writes the keys as a sorted array, see DumpHeader.
+  void serialize(std::ostream &out) const {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "serialize requires a trivially copyable T");
+    std::vector<T> sorted;
+    collect(sorted);
+    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(T), sorted.size()};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(sorted.data()),
+              sorted.size() * sizeof(T));
+    if (!out) {
+      throw std::runtime_error("Failed to write tree dump");
+    }
+  }
+
+  // Replaces the contents with a dump written by serialize(). The tree is
+  // built balanced from the sorted array in O(n), without re-inserting.
+  void deserialize(std::istream &in) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "deserialize requires a trivially copyable T");
+    DumpHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, "DSTR", 4) != 0 ||
+        header.elemSize != sizeof(T)) {
+      throw std::runtime_error("Invalid tree dump");
+    }
+    std::vector<T> sorted;
+    if (!readDumpElements(in, header.count, sorted)) {
+      throw std::runtime_error("Truncated tree dump");
+    }
+    for (size_t i = 1; i < sorted.size(); i++) {
+      if (!Comp(sorted[i - 1], sorted[i])) {
+        throw std::runtime_error("Unsorted tree dump");
+      }
+    }
+    assignSorted(sorted);
+  }
+
+  // Replaces the contents with the given strictly increasing keys, building a
+  // balanced tree in O(n). The new tree is built before the old one is freed,
+  // so if building throws the tree is left unchanged.
+  void assignSorted(const std::vector<T> &sorted) {
+    Node<T> *fresh = build(sorted, 0, static_cast<int>(sorted.size()));
+    clear(root);
+    root = fresh;
+  }
+
+  // Replaces the contents with the keys in data, which may be unsorted and
+  // hold duplicates. Chunks of data are sorted as pool tasks and merged
+  // pairwise; then the top levels of the balanced tree are laid out here and
+  // the subtrees below them are built as tasks. The result has the same
+  // shape as assignSorted on the sorted, deduplicated keys.
+  void buildParallel(std::vector<T> data, ThreadPool &pool) {
+    sortParallel(data, pool);
+    data.erase(std::unique(data.begin(), data.end(),
+                           [](const T &a, const T &b) { return !Comp(a, b); }),
+               data.end());
+
+    // Built aside like assignSorted, so a throw leaves the tree unchanged.
+    Node<T> *fresh = nullptr;
+    int split = splitDepth(pool);
+    std::vector<BuildTask> tasks;
+    try {
+      layoutTop(data, 0, static_cast<int>(data.size()), split, &fresh, tasks);
+      pool.run(static_cast<int>(tasks.size()), [&](int i) {
+        *tasks[i].slot = build(data, tasks[i].lo, tasks[i].hi);
+      });
+    } catch (...) {
+      clear(fresh);
+      throw;
+    }
+    updateTop(fresh, split);
+    clear(root);
+    root = fresh;
   }
 
 private:
   Node<T> *root;
 
-  int compare(T a, T b) { return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0); }
+  // Subtree over sorted[lo, hi) still to be built into *slot.
+  struct BuildTask {
+    Node<T> **slot;
+    int lo;
+    int hi;
+  };
+
+  // Piece of an in-order walk: one node alone, or the whole subtree under it.
+  struct Span {
+    Node<T> *node;
+    bool whole;
+  };
+
+  static int compare(const T &a, const T &b) {
+    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);
+  }
 
   int getHeight(Node<T> *node) { return node ? node->height : 0; }
 
@@ -109,16 +593,20 @@ private:
     return node;
   }
 
-  Node<T> *insertNode(Node<T> *node, T val) {
+  // U is T or const T&; val is moved into the new node, never copied on the
+  // way down.
+  template <typename U>
+  Node<T> *insertNode(Node<T> *node, U &&val, bool &inserted) {
     if (!node) {
-      return new Node<T>(val);
+      inserted = true;
+      return new Node<T>(std::forward<U>(val));
     }
 
     int r = compare(val, node->val);
     if (r < 0) {
-      node->left = insertNode(node->left, val);
+      node->left = insertNode(node->left, std::forward<U>(val), inserted);
     } else if (r > 0) {
-      node->right = insertNode(node->right, val);
+      node->right = insertNode(node->right, std::forward<U>(val), inserted);
     } else {
       return node;
     }
@@ -126,7 +614,7 @@ private:
     return balanceNode(node);
   }
 
-  T *searchNode(Node<T> *node, T val) {
+  T *searchNode(Node<T> *node, const T &val) {
     if (!node)
       return nullptr;
 
@@ -145,7 +633,7 @@ private:
     return node;
   }
 
-  Node<T> *removeNode(Node<T> *node, T val, bool &removed) {
+  Node<T> *removeNode(Node<T> *node, const T &val, bool &removed) {
     if (!node) {
       removed = false;
       return nullptr;
@@ -172,29 +660,164 @@ private:
       } else {
         Node<T> *successor = findMin(node->right);
         node->val = successor->val;
-        node->right = removeNode(node->right, successor->val, removed);
+        node->right = removeNode(node->right, node->val, removed);
       }
     }
 
     return balanceNode(node);
   }
 
-  void print(Node<T> *node, int depth) {
-    if (node == nullptr) {
+  void collect(std::vector<T> &out) const {
+    visitInOrder([&out](const T &val) { out.push_back(val); });
+  }
+
+  // Depth at which the parallel operations cut the tree into tasks: about
+  // four subtrees per thread, so uneven subtrees still balance out.
+  static int splitDepth(const ThreadPool &pool) {
+    int depth = 0;
+    while ((1 << depth) < 4 * pool.size())
+      depth++;
+    return depth;
+  }
+
+  // Sorts chunks of data as pool tasks, then merges neighbouring runs
+  // pairwise, one pool.run per round, until a single run is left. Small
+  // inputs are sorted inline.
+  static void sortParallel(std::vector<T> &data, ThreadPool &pool) {
+    size_t n = data.size();
+    size_t runs = n < 8192 ? 1 : static_cast<size_t>(pool.size());
+    std::vector<size_t> bounds(runs + 1);
+    for (size_t i = 0; i <= runs; i++) {
+      bounds[i] = n / runs * i + std::min(i, n % runs);
+    }
+    auto at = [&](size_t run) { return data.begin() + bounds[run]; };
+
+    pool.run(static_cast<int>(runs), [&](int i) {
+      std::sort(at(i), at(i + 1), Comp);
+    });
+    for (size_t width = 1; width < runs; width *= 2) {
+      int pairs = static_cast<int>((runs + 2 * width - 1) / (2 * width));
+      pool.run(pairs, [&](int p) {
+        size_t lo = p * 2 * width;
+        size_t mid = std::min(lo + width, runs);
+        size_t hi = std::min(lo + 2 * width, runs);
+        if (mid < hi)
+          std::inplace_merge(at(lo), at(mid), at(hi), Comp);
+      });
+    }
+  }
+
+  // Lays out the nodes of the balanced tree over sorted[lo, hi) that lie
+  // above depth `split`, and records each subtree at that depth as a task.
+  void layoutTop(const std::vector<T> &sorted, int lo, int hi, int split,
+                 Node<T> **slot, std::vector<BuildTask> &tasks) {
+    *slot = nullptr;
+    if (lo >= hi)
+      return;
+    if (split == 0) {
+      tasks.push_back({slot, lo, hi});
       return;
     }
+    int mid = lo + (hi - lo) / 2;
+    Node<T> *node = new Node<T>(sorted[mid]);
+    *slot = node;
+    layoutTop(sorted, lo, mid, split - 1, &node->left, tasks);
+    layoutTop(sorted, mid + 1, hi, split - 1, &node->right, tasks);
+  }
 
-    print(node->right, depth + 1);
+  // Recomputes the heights of the nodes laid out by layoutTop, once the
+  // subtrees under them are built.
+  void updateTop(Node<T> *node, int split) {
+    if (!node || split == 0)
+      return;
+    updateTop(node->left, split - 1);
+    updateTop(node->right, split - 1);
+    updateHeight(node);
+  }
 
-    for (int i = 0; i < depth; i++) {
-      std::cout << "   ";
+  static void collectSpans(Node<T> *node, int split, std::vector<Span> &spans) {
+    if (!node)
+      return;
+    if (split == 0) {
+      spans.push_back({node, true});
+      return;
     }
-    std::cout << node->val << std::endl;
+    collectSpans(node->left, split - 1, spans);
+    spans.push_back({node, false});
+    collectSpans(node->right, split - 1, spans);
+  }
 
-    print(node->left, depth + 1);
-  };
+  template <typename Fn> static void visitSubtree(Node<T> *node, Fn &&fn) {
+    std::vector<Node<T> *> stack;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back(node);
+        node = node->left;
+      }
+      node = stack.back();
+      stack.pop_back();
+      fn(node->val);
+      node = node->right;
+    }
+  }
+
+  // Balanced subtree over sorted[lo, hi). If allocating or copying a key
+  // throws, the part built so far is freed.
+  Node<T> *build(const std::vector<T> &sorted, int lo, int hi) {
+    if (lo >= hi)
+      return nullptr;
+    int mid = lo + (hi - lo) / 2;
+    Node<T> *node = new Node<T>(sorted[mid]);
+    try {
+      node->left = build(sorted, lo, mid);
+      node->right = build(sorted, mid + 1, hi);
+    } catch (...) {
+      clear(node);
+      throw;
+    }
+    updateHeight(node);
+    return node;
+  }
+
+  // Copies src node by node with an explicit stack, keeping its shape and
+  // heights, so no rebalancing happens. The stack is sized once from the
+  // height. If copying a value throws, the partial copy is freed.
+  static Node<T> *cloneTree(const Node<T> *src) {
+    if (!src)
+      return nullptr;
+
+    Node<T> *copy = cloneNode(src);
+    std::vector<std::pair<const Node<T> *, Node<T> *>> stack;
+    stack.reserve(src->height + 1);
+    stack.push_back({src, copy});
+    try {
+      while (!stack.empty()) {
+        const Node<T> *from = stack.back().first;
+        Node<T> *to = stack.back().second;
+        stack.pop_back();
+        if (from->right) {
+          to->right = cloneNode(from->right);
+          stack.push_back({from->right, to->right});
+        }
+        if (from->left) {
+          to->left = cloneNode(from->left);
+          stack.push_back({from->left, to->left});
+        }
+      }
+    } catch (...) {
+      clear(copy);
+      throw;
+    }
+    return copy;
+  }
+
+  static Node<T> *cloneNode(const Node<T> *src) {
+    Node<T> *node = new Node<T>(src->val);
+    node->height = src->height;
+    return node;
+  }
 
-  void clear(Node<T> *node) {
+  static void clear(Node<T> *node) {
     if (!node)
       return;
     clear(node->left);
@@ -203,8 +826,352 @@ private:
   }
 };
 
+template <typename T, bool (*Comp)(const T &, const T &)>
+void swap(AVLAbstract<T, Comp> &a, AVLAbstract<T, Comp> &b) noexcept {
+  a.swap(b);
+}
+
+// Ordered set with the AVLAbstract interface that keeps up to SmallSize keys
+// in a sorted array inside the object, so small sets need no allocation and
+// no pointer chasing. Inserting past SmallSize moves the keys into an
+// AVLAbstract; dropping to SmallSize / 2 moves them back (the gap avoids
+// converting back and forth around the threshold). T must be default
+// constructible. Pointers from search() are invalidated by insert and remove.
+template <typename T, bool (*Comp)(const T &, const T &), int SmallSize = 64>
+class AdaptiveAVLAbstract {
+public:
+  AdaptiveAVLAbstract() {
+    tree = nullptr;
+    count = 0;
+  }
+
+  AdaptiveAVLAbstract(const AdaptiveAVLAbstract &other) {
+    tree = other.tree ? new AVLAbstract<T, Comp>(*other.tree) : nullptr;
+    count = other.count;
+    if (!tree)
+      std::copy(other.small, other.small + count, small);
+  }
+
+  // O(1) once the keys live in a tree; a small set moves its keys one by one.
+  AdaptiveAVLAbstract(AdaptiveAVLAbstract &&other) noexcept {
+    tree = other.tree;
+    count = other.count;
+    if (!tree)
+      std::move(other.small, other.small + count, small);
+    other.tree = nullptr;
+    other.count = 0;
+  }
+
+  AdaptiveAVLAbstract &operator=(AdaptiveAVLAbstract other) {
+    swap(other);
+    return *this;
+  }
+
+  ~AdaptiveAVLAbstract() { delete tree; }
+
+  void swap(AdaptiveAVLAbstract &other) {
+    int n = std::max(tree ? 0 : count, other.tree ? 0 : other.count);
+    std::swap_ranges(small, small + n, other.small);
+    std::swap(tree, other.tree);
+    std::swap(count, other.count);
+  }
+
+  bool insert(const T &val) { return insertValue(val); }
+  bool insert(T &&val) { return insertValue(std::move(val)); }
+
+  T *search(const T &val) {
+    if (tree)
+      return tree->search(val);
+    int i = lowerBound(val);
+    if (i < count && !Comp(val, small[i]))
+      return &small[i];
+    return nullptr;
+  }
+
+  void searchBatch(const std::vector<T> &keys, std::vector<T *> &out) {
+    if (tree) {
+      tree->searchBatch(keys, out);
+      return;
+    }
+    out.assign(keys.size(), nullptr);
+    for (size_t k = 0; k < keys.size(); k++) {
+      int i = lowerBound(keys[k]);
+      if (i < count && !Comp(keys[k], small[i]))
+        out[k] = &small[i];
+    }
+  }
+
+  bool remove(const T &val) {
+    if (tree) {
+      if (!tree->remove(val))
+        return false;
+      count--;
+      if (count <= SmallSize / 2)
+        shrink();
+      return true;
+    }
+
+    int i = lowerBound(val);
+    if (i == count || Comp(val, small[i]))
+      return false;
+    for (int j = i; j + 1 < count; j++) {
+      small[j] = std::move(small[j + 1]);
+    }
+    count--;
+    return true;
+  }
+
+  void clear() {
+    delete tree;
+    tree = nullptr;
+    count = 0;
+  }
+
+  int size() const { return count; }
+  bool isSmall() const { return tree == nullptr; }
+
+  // Same output as AVLAbstract::print; a small set prints the balanced tree
+  // that grow() would build from the array.
+  void print(std::ostream &out = std::cout) const {
+    if (tree) {
+      tree->print(out);
+      return;
+    }
+    std::ostringstream buffer;
+    printRange(buffer, 0, count, 0);
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  template <typename Fn> void visitInOrder(Fn fn) const {
+    if (tree) {
+      tree->visitInOrder(fn);
+      return;
+    }
+    for (int i = 0; i < count; i++) {
+      fn(small[i]);
+    }
+  }
+
+  // A small set is too small to split, so fn runs on the calling thread.
+  template <typename Fn> void visitParallel(ThreadPool &pool, Fn fn) const {
+    if (tree) {
+      tree->visitParallel(pool, fn);
+      return;
+    }
+    visitInOrder(fn);
+  }
+
+  // A small set folds on the calling thread, in key order.
+  template <typename R, typename Map, typename Combine>
+  R reduceParallel(ThreadPool &pool, R identity, Map map,
+                   Combine combine) const {
+    if (tree)
+      return tree->reduceParallel(pool, std::move(identity), map, combine);
+    R acc = std::move(identity);
+    for (int i = 0; i < count; i++) {
+      acc = combine(std::move(acc), map(small[i]));
+    }
+    return acc;
+  }
+
+  // A small set reports the levels of the balanced tree that grow() would
+  // build from the array.
+  template <typename Fn> void visitLevelOrder(Fn fn) const {
+    if (tree) {
+      tree->visitLevelOrder(fn);
+      return;
+    }
+    struct Range {
+      int lo;
+      int hi;
+      int depth;
+    };
+    std::vector<Range> level;
+    if (count > 0)
+      level.push_back({0, count, 0});
+    for (size_t k = 0; k < level.size(); k++) {
+      Range r = level[k];
+      int mid = r.lo + (r.hi - r.lo) / 2;
+      fn(small[mid], r.depth);
+      if (r.lo < mid)
+        level.push_back({r.lo, mid, r.depth + 1});
+      if (mid + 1 < r.hi)
+        level.push_back({mid + 1, r.hi, r.depth + 1});
+    }
+  }
+
+  FrozenTree<T, Comp> freeze() const {
+    if (tree)
+      return tree->freeze();
+    return FrozenTree<T, Comp>(std::vector<T>(small, small + count));
+  }
+
+  // Same dump format as AVLAbstract::serialize; a small set writes its
+  // array directly.
+  void serialize(std::ostream &out) const {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "serialize requires a trivially copyable T");
+    if (tree) {
+      tree->serialize(out);
+      return;
+    }
+    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(T),
+                         static_cast<uint64_t>(count)};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(small), count * sizeof(T));
+    if (!out) {
+      throw std::runtime_error("Failed to write tree dump");
+    }
+  }
+
+  // Loads into a new tree, which is kept if the dump holds more than
+  // SmallSize keys. If loading throws the set is left unchanged.
+  void deserialize(std::istream &in) {
+    AVLAbstract<T, Comp> *loaded = new AVLAbstract<T, Comp>();
+    int n = 0;
+    try {
+      loaded->deserialize(in);
+      loaded->visitInOrder([&n](const T &) { n++; });
+    } catch (...) {
+      delete loaded;
+      throw;
+    }
+    adopt(loaded, n);
+  }
+
+  // Up to SmallSize keys go straight into the array; more are built into a
+  // new tree. If copying a key throws, the set is left unchanged.
+  void assignSorted(const std::vector<T> &sorted) {
+    if (sorted.size() > static_cast<size_t>(SmallSize)) {
+      AVLAbstract<T, Comp> *loaded = new AVLAbstract<T, Comp>();
+      try {
+        loaded->assignSorted(sorted);
+      } catch (...) {
+        delete loaded;
+        throw;
+      }
+      adopt(loaded, static_cast<int>(sorted.size()));
+      return;
+    }
+    T copy[SmallSize];
+    std::copy(sorted.begin(), sorted.end(), copy);
+    int n = static_cast<int>(sorted.size());
+    std::move(copy, copy + n, small);
+    delete tree;
+    tree = nullptr;
+    count = n;
+  }
+
+  // Builds a new tree on the pool, then keeps the array form if the
+  // deduplicated keys fit in SmallSize. If building throws the set is left
+  // unchanged.
+  void buildParallel(std::vector<T> data, ThreadPool &pool) {
+    AVLAbstract<T, Comp> *loaded = new AVLAbstract<T, Comp>();
+    int n = 0;
+    try {
+      loaded->buildParallel(std::move(data), pool);
+      n = loaded->reduceParallel(
+          pool, 0, [](const T &) { return 1; },
+          [](int a, int b) { return a + b; });
+    } catch (...) {
+      delete loaded;
+      throw;
+    }
+    adopt(loaded, n);
+  }
+
+private:
+  T small[SmallSize];
+  AVLAbstract<T, Comp> *tree;
+  int count;
+
+  // Branchless lower bound over small[0, count).
+  int lowerBound(const T &val) const {
+    int base = 0;
+    int n = count;
+    while (n > 1) {
+      int half = n / 2;
+      base = Comp(small[base + half - 1], val) ? base + half : base;
+      n -= half;
+    }
+    return base + (n == 1 && Comp(small[base], val));
+  }
+
+  template <typename U> bool insertValue(U &&val) {
+    if (tree) {
+      if (!tree->insert(std::forward<U>(val)))
+        return false;
+      count++;
+      return true;
+    }
+
+    int i = lowerBound(val);
+    if (i < count && !Comp(val, small[i]))
+      return false;
+    if (count == SmallSize) {
+      grow(std::forward<U>(val), i);
+      return true;
+    }
+    for (int j = count; j > i; j--) {
+      small[j] = std::move(small[j - 1]);
+    }
+    small[i] = std::forward<U>(val);
+    count++;
+    return true;
+  }
+
+  // Moves the full array plus val (which belongs at index i) into a tree.
+  template <typename U> void grow(U &&val, int i) {
+    std::vector<T> sorted;
+    sorted.reserve(count + 1);
+    sorted.insert(sorted.end(), std::make_move_iterator(small),
+                  std::make_move_iterator(small + i));
+    sorted.push_back(std::forward<U>(val));
+    sorted.insert(sorted.end(), std::make_move_iterator(small + i),
+                  std::make_move_iterator(small + count));
+
+    tree = new AVLAbstract<T, Comp>();
+    tree->assignSorted(sorted);
+    count++;
+  }
+
+  // Replaces the contents with loaded, which holds n keys.
+  void adopt(AVLAbstract<T, Comp> *loaded, int n) {
+    delete tree;
+    tree = loaded;
+    count = n;
+    if (count <= SmallSize)
+      shrink();
+  }
+
+  // Prints small[lo, hi) as the balanced tree over it, right subtrees first
+  // like AVLAbstract::print.
+  void printRange(std::ostringstream &buffer, int lo, int hi,
+                  int depth) const {
+    if (lo >= hi)
+      return;
+    int mid = lo + (hi - lo) / 2;
+    printRange(buffer, mid + 1, hi, depth + 1);
+    for (int i = 0; i < depth; i++) {
+      buffer << "   ";
+    }
+    buffer << small[mid] << '\n';
+    printRange(buffer, lo, mid, depth + 1);
+  }
+
+  void shrink() {
+    int i = 0;
+    tree->visitInOrder([this, &i](const T &val) { small[i++] = val; });
+    delete tree;
+    tree = nullptr;
+  }
+};
+
 template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }
 template <typename T> using AVLTree = AVLAbstract<T, lessCompare<T>>;
+template <typename T>
+using AdaptiveAVLTree = AdaptiveAVLAbstract<T, lessCompare<T>>;
 
 int main() {
   std::cout << "=== AVL Test ===" << std::endl;
@@ -296,6 +1263,95 @@ int main() {
   avl3.print();
   std::cout << "Height should be O(log n), not a straight line." << std::endl;
 
+  std::cout << "\n13. Freezing tree for read-only lookups:" << std::endl;
+  auto frozen = avl3.freeze();
+  std::cout << "Frozen size: " << frozen.size() << std::endl;
+  std::cout << "Search 13: "
+            << (frozen.search(13) != nullptr ? "Found" : "Not found")
+            << std::endl;
+  std::cout << "Search 100: "
+            << (frozen.search(100) != nullptr ? "Found" : "Not found")
+            << std::endl;
+
+  std::cout << "\n14. Binary dump and balanced reload:" << std::endl;
+  std::stringstream dump;
+  avl3.serialize(dump);
+  AVLTree<int> restored;
+  restored.deserialize(dump);
+  restored.print();
+
+  std::cout << "\n15. Visiting in order and level order:" << std::endl;
+  restored.visitInOrder([](const int &val) { std::cout << val << " "; });
+  std::cout << std::endl;
+  restored.visitLevelOrder([](const int &val, int depth) {
+    std::cout << val << "@" << depth << " ";
+  });
+  std::cout << std::endl;
+
+  std::cout << "\n16. Batch search for 1, 5, 12, 100:" << std::endl;
+  std::vector<int> keys = {1, 5, 12, 100};
+  std::vector<int *> found;
+  avl2.searchBatch(keys, found);
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::cout << "Search " << keys[i] << ": "
+              << (found[i] != nullptr ? "Found" : "Not found") << std::endl;
+  }
+
+  std::cout << "\n17. Adaptive set growing past and shrinking below 64 keys:"
+            << std::endl;
+  AdaptiveAVLTree<int> adaptive;
+  for (int i = 10; i > 0; i--) {
+    adaptive.insert(i);
+  }
+  adaptive.print();
+  for (int i = 11; i <= 100; i++) {
+    adaptive.insert(i);
+  }
+  std::cout << "Size " << adaptive.size() << ", small: "
+            << (adaptive.isSmall() ? "true" : "false") << std::endl;
+  for (int i = 1; i <= 90; i++) {
+    adaptive.remove(i);
+  }
+  std::cout << "Size " << adaptive.size() << ", small: "
+            << (adaptive.isSmall() ? "true" : "false") << std::endl;
+  adaptive.print();
+  std::cout << "Search 95: "
+            << (adaptive.search(95) != nullptr ? "Found" : "Not found")
+            << std::endl;
+
+  std::cout << "\n18. Copying, moving and swapping trees:" << std::endl;
+  AVLTree<int> copy = avl3;
+  copy.remove(8);
+  std::cout << "Search 8 in original: "
+            << (avl3.search(8) != nullptr ? "Found (expected)" : "Not found")
+            << std::endl;
+  AVLTree<int> moved = std::move(copy);
+  std::cout << "Moved-from empty: "
+            << (copy.search(1) == nullptr ? "true" : "false") << std::endl;
+  moved.swap(avl2);
+  std::cout << "After swap, search 18: "
+            << (moved.search(18) != nullptr ? "Found" : "Not found")
+            << std::endl;
+
+  std::cout << "\n19. Parallel build and reduction from unsorted keys:"
+            << std::endl;
+  std::vector<int> unsorted;
+  for (int i = 0; i < 100000; i++) {
+    unsorted.push_back((i * 7919) % 50000);
+  }
+  ThreadPool pool(4);
+  AVLTree<int> bulk;
+  bulk.buildParallel(unsorted, pool);
+  long long sum = bulk.reduceParallel(
+      pool, 0LL, [](const int &val) { return static_cast<long long>(val); },
+      [](long long a, long long b) { return a + b; });
+  std::atomic<int> visited(0);
+  bulk.visitParallel(pool, [&visited](const int &) { visited++; });
+  std::cout << "Keys: " << visited << ", sum: " << sum
+            << ", search 49999: "
+            << (bulk.search(49999) != nullptr ? "Found" : "Not found")
+            << std::endl;
+
   std::cout << "\n=== All AVL tests completed ===" << std::endl;
   return 0;
 }
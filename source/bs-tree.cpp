@@ -1,11 +1,103 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 template <typename T>
 struct Node {
   T val;
   Node *left = nullptr;
   Node *right = nullptr;
-  Node(T v) : val(v) {}
+  int count = 1; // copies of val, equal keys never get their own node
+  Node(T v) : val(std::move(v)) {}
+};
+
+// Binary dump layout: header followed by `count` raw elements. T must be
+// trivially copyable, so the file can also be mmapped and searched in place.
+struct DumpHeader {
+  char magic[4];
+  uint32_t elemSize;
+  uint64_t count;
+};
+
+// Reads the `count` elements that follow a DumpHeader into out. count comes
+// from the file, so it is checked against the bytes left in the stream
+// before out is sized. A stream that cannot seek is read in bounded steps
+// instead, so a corrupt count ends in a short read, not a huge allocation.
+template <typename T>
+bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {
+  uint64_t step = count;
+  std::streampos here = in.tellg();
+  if (here != std::streampos(-1) && in.seekg(0, std::ios::end)) {
+    uint64_t left = static_cast<uint64_t>(in.tellg() - here);
+    in.seekg(here);
+    if (count > left / sizeof(T))
+      return false;
+  } else {
+    in.clear();
+    step = 1 << 16;
+  }
+  out.clear();
+  while (out.size() < count) {
+    size_t done = out.size();
+    size_t n = static_cast<size_t>(std::min<uint64_t>(step, count - done));
+    out.resize(done + n);
+    in.read(reinterpret_cast<char *>(out.data() + done), n * sizeof(T));
+    if (!in)
+      return false;
+  }
+  return true;
+}
+
+// Immutable search array in Eytzinger (BFS) order produced by freeze(). Node
+// k has children 2k and 2k + 1, so the top levels share a few cache lines and
+// lookup is a branchless descent that prefetches four levels ahead.
+template <typename T, bool (*Comp)(const T &, const T &)>
+class FrozenTree {
+public:
+  explicit FrozenTree(const std::vector<T> &sorted) {
+    arr.resize(sorted.size() + 1);
+    int pos = 0;
+    build(sorted, pos, 1);
+  }
+
+  const T *search(const T &val) const {
+    const int n = size();
+    const int block = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+    int k = 1;
+    while (k <= n) {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(arr.data() + static_cast<size_t>(k) * block);
+#endif
+      k = 2 * k + Comp(arr[k], val);
+    }
+    // undo the trailing right turns to get the lower bound
+    while (k & 1)
+      k >>= 1;
+    k >>= 1;
+    if (k == 0 || Comp(val, arr[k]))
+      return nullptr;
+    return &arr[k];
+  }
+
+  int size() const { return static_cast<int>(arr.size()) - 1; }
+  bool empty() const { return size() == 0; }
+
+private:
+  std::vector<T> arr; // arr[0] unused
+
+  void build(const std::vector<T> &sorted, int &pos, int k) {
+    if (k > size())
+      return;
+    build(sorted, pos, 2 * k);
+    arr[k] = sorted[pos++];
+    build(sorted, pos, 2 * k + 1);
+  }
 };
 
 template <typename T, bool (*Comp)(const T &, const T &)>
@@ -13,42 +105,229 @@ class BSTAbstract {
 public:
   BSTAbstract() { root = nullptr; }
 
+  // Deep copy with the same shape as other, see cloneTree.
+  BSTAbstract(const BSTAbstract &other) { root = cloneTree(other.root); }
+
+  BSTAbstract(BSTAbstract &&other) noexcept {
+    root = other.root;
+    other.root = nullptr;
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  BSTAbstract &operator=(BSTAbstract other) noexcept {
+    swap(other);
+    return *this;
+  }
+
   ~BSTAbstract() { clear(root); }
 
-  void insert(T val) { insertNode(root, val); }
-  T *search(T val) { return searchNode(root, val); }
-  bool remove(T val) { return removeNode(root, val); }
+  void swap(BSTAbstract &other) noexcept { std::swap(root, other.root); }
+
+  void insert(const T &val) { insertNode(root, val); }
+  void insert(T &&val) { insertNode(root, std::move(val)); }
+  T *search(const T &val) { return searchNode(root, val); }
+  bool remove(const T &val) { return removeOne(val); }
+  bool removeOne(const T &val) { return removeNode(root, val, false) > 0; }
+  // Removes every copy of val and returns how many there were.
+  int removeAll(const T &val) { return removeNode(root, val, true); }
+  int count(const T &val) {
+    Node<T> *node = root;
+    while (node) {
+      int r = compare(val, node->val);
+      if (r == 0)
+        return node->count;
+      node = r < 0 ? node->left : node->right;
+    }
+    return 0;
+  }
   void clear() {
     clear(root);
     root = nullptr;
   }
 
-  void print() {
-    std::cout << "Tree structure:" << std::endl;
-    print(root, 0);
-    std::cout << std::endl;
+  // Looks up every key in keys and stores the result (or nullptr) at the same
+  // index of out. Descents run in groups that advance one level per round, so
+  // the cache misses of different keys overlap instead of queueing up.
+  void searchBatch(const std::vector<T> &keys, std::vector<T *> &out) {
+    const size_t group = 16;
+    Node<T> *cursor[group];
+    out.assign(keys.size(), nullptr);
+
+    for (size_t base = 0; base < keys.size(); base += group) {
+      size_t n = std::min(group, keys.size() - base);
+      for (size_t i = 0; i < n; i++) {
+        cursor[i] = root;
+      }
+
+      size_t active = n;
+      while (active > 0) {
+        active = 0;
+        for (size_t i = 0; i < n; i++) {
+          Node<T> *node = cursor[i];
+          if (!node)
+            continue;
+
+          int r = compare(keys[base + i], node->val);
+          if (r == 0) {
+            out[base + i] = &(node->val);
+            cursor[i] = nullptr;
+            continue;
+          }
+
+          node = r < 0 ? node->left : node->right;
+#if defined(__GNUC__) || defined(__clang__)
+          if (node)
+            __builtin_prefetch(node);
+#endif
+          cursor[i] = node;
+          if (node)
+            active++;
+        }
+      }
+    }
+  }
+
+  // Formats the whole tree into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Tree structure:" << '\n';
+    std::vector<std::pair<Node<T> *, int>> stack;
+    Node<T> *node = root;
+    int depth = 0;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back({node, depth});
+        node = node->right;
+        depth++;
+      }
+      node = stack.back().first;
+      depth = stack.back().second;
+      stack.pop_back();
+
+      for (int i = 0; i < depth; i++) {
+        buffer << "   ";
+      }
+      buffer << node->val;
+      if (node->count > 1) {
+        buffer << " (x" << node->count << ")";
+      }
+      buffer << '\n';
+
+      node = node->left;
+      depth++;
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(val) for every key in sorted order, once per copy, without
+  // recursion.
+  template <typename Fn> void visitInOrder(Fn fn) const {
+    visitNodesInOrder([&fn](const Node<T> *node) {
+      for (int i = 0; i < node->count; i++) {
+        fn(node->val);
+      }
+    });
+  }
+
+  // Calls fn(val, depth) level by level, root first, once per node.
+  template <typename Fn> void visitLevelOrder(Fn fn) const {
+    std::vector<std::pair<Node<T> *, int>> level;
+    if (root)
+      level.push_back({root, 0});
+    for (size_t i = 0; i < level.size(); i++) {
+      Node<T> *node = level[i].first;
+      int depth = level[i].second;
+      fn(node->val, depth);
+      if (node->left)
+        level.push_back({node->left, depth + 1});
+      if (node->right)
+        level.push_back({node->right, depth + 1});
+    }
+  }
+
+  // Snapshot of the current keys for read-only phases, see FrozenTree.
+  FrozenTree<T, Comp> freeze() const {
+    std::vector<T> sorted;
+    visitNodesInOrder([&sorted](const Node<T> *node) {
+      sorted.push_back(node->val);
+    });
+    return FrozenTree<T, Comp>(sorted);
+  }
+
+  // Writes the keys as a sorted array, see DumpHeader.
+  void serialize(std::ostream &out) const {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "serialize requires a trivially copyable T");
+    std::vector<T> sorted;
+    collect(sorted);
+    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(T), sorted.size()};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(sorted.data()),
+              sorted.size() * sizeof(T));
+    if (!out) {
+      throw std::runtime_error("Failed to write tree dump");
+    }
+  }
+
+  // Replaces the contents with a dump written by serialize(). The tree is
+  // built balanced from the sorted array in O(n), without re-inserting.
+  void deserialize(std::istream &in) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "deserialize requires a trivially copyable T");
+    DumpHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, "DSTR", 4) != 0 ||
+        header.elemSize != sizeof(T)) {
+      throw std::runtime_error("Invalid tree dump");
+    }
+    std::vector<T> sorted;
+    if (!readDumpElements(in, header.count, sorted)) {
+      throw std::runtime_error("Truncated tree dump");
+    }
+    // Copies of a key are written once each, so keys may repeat but must
+    // never decrease.
+    std::vector<std::pair<T, int>> runs;
+    for (const T &val : sorted) {
+      if (!runs.empty() && Comp(val, runs.back().first))
+        throw std::runtime_error("Unsorted tree dump");
+      if (!runs.empty() && !Comp(runs.back().first, val))
+        runs.back().second++;
+      else
+        runs.push_back({val, 1});
+    }
+    // Built before the old tree is freed, so a throw leaves it unchanged.
+    Node<T> *fresh = build(runs, 0, static_cast<int>(runs.size()));
+    clear(root);
+    root = fresh;
   }
 
 private:
   Node<T> *root;
 
-  int compare(T a, T b) { return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0); }
+  static int compare(const T &a, const T &b) {
+    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);
+  }
 
-  void insertNode(Node<T>*  &node, T val) {
+  // U is T or const T&; val is moved into the new node, never copied on the
+  // way down.
+  template <typename U> void insertNode(Node<T> *&node, U &&val) {
     if (node == nullptr) {
-      node = new Node<T>(val);
+      node = new Node<T>(std::forward<U>(val));
       return;
     }
 
     int r = compare(val, node->val);
-    if (r <= 0) {
-      insertNode(node->left, val);
+    if (r < 0) {
+      insertNode(node->left, std::forward<U>(val));
+    } else if (r > 0) {
+      insertNode(node->right, std::forward<U>(val));
     } else {
-      insertNode(node->right, val);
+      node->count++;
     }
   }
 
-  T *searchNode(Node<T>*  node, T val) {
+  T *searchNode(Node<T> *node, const T &val) {
     if (node == nullptr) {
       return nullptr;
     }
@@ -64,18 +343,26 @@ private:
     }
   }
 
-  bool removeNode(Node<T> *&node, T val) {
+  // Removes one copy of val, or all of them if all is set, and returns the
+  // number of copies removed.
+  int removeNode(Node<T> *&node, const T &val, bool all) {
     if (node == nullptr) {
-      return false;
+      return 0;
     }
 
     int r = compare(val, node->val);
 
     if (r < 0) {
-      return removeNode(node->left, val);
+      return removeNode(node->left, val, all);
     } else if (r > 0) {
-      return removeNode(node->right, val);
+      return removeNode(node->right, val, all);
     } else {
+      if (!all && node->count > 1) {
+        node->count--;
+        return 1;
+      }
+
+      int removed = node->count;
       if (node->left == nullptr && node->right == nullptr) {
         delete node;
         node = nullptr;
@@ -90,9 +377,10 @@ private:
       } else {
         Node<T> *successor = findMin(node->right);
         node->val = successor->val;
-        removeNode(node->right, successor->val);
+        node->count = successor->count;
+        removeNode(node->right, node->val, true);
       }
-      return true;
+      return removed;
     }
   }
 
@@ -103,22 +391,81 @@ private:
     return node;
   }
 
-  void print(Node<T>* node, int depth) {
-      if (node == nullptr) {
-        return;
+  template <typename Fn> void visitNodesInOrder(Fn fn) const {
+    std::vector<Node<T> *> stack;
+    Node<T> *node = root;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back(node);
+        node = node->left;
       }
+      node = stack.back();
+      stack.pop_back();
+      fn(node);
+      node = node->right;
+    }
+  }
 
-      print(node->right, depth + 1);
+  void collect(std::vector<T> &out) const {
+    visitInOrder([&out](const T &val) { out.push_back(val); });
+  }
 
-      for (int i = 0; i < depth; i++) {
-        std::cout << "   ";
+  // Balanced subtree over runs[lo, hi) of (key, copies). If allocating or
+  // copying a key throws, the part built so far is freed.
+  Node<T> *build(const std::vector<std::pair<T, int>> &runs, int lo, int hi) {
+    if (lo >= hi)
+      return nullptr;
+    int mid = lo + (hi - lo) / 2;
+    Node<T> *node = new Node<T>(runs[mid].first);
+    node->count = runs[mid].second;
+    try {
+      node->left = build(runs, lo, mid);
+      node->right = build(runs, mid + 1, hi);
+    } catch (...) {
+      clear(node);
+      throw;
+    }
+    return node;
+  }
+
+  // Copies src node by node with an explicit stack, keeping its shape, so a
+  // degenerate tree is copied without deep recursion. If copying a value
+  // throws, the partial copy is freed.
+  static Node<T> *cloneTree(const Node<T> *src) {
+    if (!src)
+      return nullptr;
+
+    Node<T> *copy = cloneNode(src);
+    std::vector<std::pair<const Node<T> *, Node<T> *>> stack;
+    stack.push_back({src, copy});
+    try {
+      while (!stack.empty()) {
+        const Node<T> *from = stack.back().first;
+        Node<T> *to = stack.back().second;
+        stack.pop_back();
+        if (from->right) {
+          to->right = cloneNode(from->right);
+          stack.push_back({from->right, to->right});
+        }
+        if (from->left) {
+          to->left = cloneNode(from->left);
+          stack.push_back({from->left, to->left});
+        }
       }
-      std::cout << node->val << std::endl;
+    } catch (...) {
+      clear(copy);
+      throw;
+    }
+    return copy;
+  }
 
-      print(node->left, depth + 1);
-  };
+  static Node<T> *cloneNode(const Node<T> *src) {
+    Node<T> *node = new Node<T>(src->val);
+    node->count = src->count;
+    return node;
+  }
 
-  void clear(Node<T>*  node) {
+  static void clear(Node<T> *node) {
     if (!node)
       return;
     clear(node->left);
@@ -127,6 +474,11 @@ private:
   }
 };
 
+template <typename T, bool (*Comp)(const T &, const T &)>
+void swap(BSTAbstract<T, Comp> &a, BSTAbstract<T, Comp> &b) noexcept {
+  a.swap(b);
+}
+
 template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }
 template <typename T> using BST = BSTAbstract<T, lessCompare<T>>;
 
@@ -236,6 +588,56 @@ int main() {
   bst2.remove(15);
   bst2.print();
 
+  std::cout << "\n12. Freezing tree for read-only lookups:" << std::endl;
+  auto frozen = bst2.freeze();
+  std::cout << "Frozen size: " << frozen.size() << std::endl;
+  std::cout << "Search 13: "
+            << (frozen.search(13) != nullptr ? "Found" : "Not found")
+            << std::endl;
+  std::cout << "Search 100: "
+            << (frozen.search(100) != nullptr ? "Found" : "Not found")
+            << std::endl;
+
+  std::cout << "\n13. Binary dump and balanced reload:" << std::endl;
+  std::stringstream dump;
+  bst2.serialize(dump);
+  BST<int> restored;
+  restored.deserialize(dump);
+  restored.print();
+
+  std::cout << "\n14. Batch search for 1, 5, 12, 100:" << std::endl;
+  std::vector<int> keys = {1, 5, 12, 100};
+  std::vector<int *> found;
+  bst2.searchBatch(keys, found);
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::cout << "Search " << keys[i] << ": "
+              << (found[i] != nullptr ? "Found" : "Not found") << std::endl;
+  }
+
+  std::cout << "\n15. Inserting 7 five times and 3 twice into new tree:"
+            << std::endl;
+  BST<int> bst3;
+  for (int i = 0; i < 5; i++)
+    bst3.insert(7);
+  bst3.insert(3);
+  bst3.insert(3);
+  bst3.print();
+  std::cout << "count(7): " << bst3.count(7) << std::endl;
+  std::cout << "removeOne(7): " << (bst3.removeOne(7) ? "true" : "false")
+            << ", count(7): " << bst3.count(7) << std::endl;
+  std::cout << "removeAll(7): " << bst3.removeAll(7)
+            << ", count(7): " << bst3.count(7) << std::endl;
+  bst3.print();
+
+  std::cout << "\n16. Copying and moving trees:" << std::endl;
+  BST<int> copy = bst3;
+  copy.insert(9);
+  copy.insert(9);
+  std::cout << "count(9) in original: " << bst3.count(9)
+            << ", in copy: " << copy.count(9) << std::endl;
+  BST<int> moved = std::move(copy);
+  moved.print();
+
   std::cout << "\n=== All tests completed ===" << std::endl;
 
   return 0;
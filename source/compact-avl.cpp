@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Node stored by value in one contiguous array. Children are 32-bit indices;
+// the balance factor (height(left) - height(right), from -1 to 1) is kept as
+// balance + 1 in the top 2 bits of `left`, which leaves 30 bits per index.
+template <typename T>
+struct CompactNode {
+  T val;
+  uint32_t left;
+  uint32_t right;
+};
+
+// AVL tree with the same interface as AVLAbstract, but without a heap
+// allocation or 64-bit pointers per node. Freed slots are reused through a
+// free list threaded through `left`. Nodes refer to each other by index, so
+// the default copy is a shape-preserving deep copy in one allocation. A move
+// steals the array and leaves the source empty.
+template <typename T, bool (*Comp)(const T &, const T &)>
+class CompactAVLAbstract {
+public:
+  CompactAVLAbstract() {
+    root = NIL;
+    freeHead = NIL;
+    count = 0;
+  }
+
+  CompactAVLAbstract(const CompactAVLAbstract &other) = default;
+  CompactAVLAbstract &operator=(const CompactAVLAbstract &other) = default;
+
+  // The implicit move would leave root and freeHead pointing into the
+  // stolen array.
+  CompactAVLAbstract(CompactAVLAbstract &&other) noexcept
+      : CompactAVLAbstract() {
+    swap(other);
+  }
+
+  CompactAVLAbstract &operator=(CompactAVLAbstract &&other) noexcept {
+    CompactAVLAbstract taken(std::move(other));
+    swap(taken);
+    return *this;
+  }
+
+  // Returns false if an equal key was already present.
+  bool insert(const T &val) {
+    bool grew = false;
+    int before = count;
+    root = insertNode(root, val, grew);
+    return count > before;
+  }
+  bool insert(T &&val) {
+    bool grew = false;
+    int before = count;
+    root = insertNode(root, std::move(val), grew);
+    return count > before;
+  }
+  T *search(const T &val) {
+    uint32_t node = root;
+    while (node != NIL) {
+      int r = compare(val, nodes[node].val);
+      if (r < 0)
+        node = getLeft(node);
+      else if (r > 0)
+        node = getRight(node);
+      else
+        return &(nodes[node].val);
+    }
+    return nullptr;
+  }
+  bool remove(const T &val) {
+    bool removed = false;
+    bool shrunk = false;
+    root = removeNode(root, val, removed, shrunk);
+    return removed;
+  }
+  void clear() {
+    nodes.clear();
+    root = NIL;
+    freeHead = NIL;
+    count = 0;
+  }
+
+  void swap(CompactAVLAbstract &other) noexcept {
+    nodes.swap(other.nodes);
+    std::swap(root, other.root);
+    std::swap(freeHead, other.freeHead);
+    std::swap(count, other.count);
+  }
+
+  void reserve(int n) { nodes.reserve(n); }
+  int size() const { return count; }
+  // Bytes held by the node array, including free and reserved slots.
+  size_t memoryUsage() const {
+    return nodes.capacity() * sizeof(CompactNode<T>);
+  }
+
+  // Formats the whole tree into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    std::vector<std::pair<uint32_t, int>> stack;
+    uint32_t node = root;
+    int depth = 0;
+    while (node != NIL || !stack.empty()) {
+      while (node != NIL) {
+        stack.push_back({node, depth});
+        node = getRight(node);
+        depth++;
+      }
+      node = stack.back().first;
+      depth = stack.back().second;
+      stack.pop_back();
+
+      for (int i = 0; i < depth; i++) {
+        buffer << "   ";
+      }
+      buffer << nodes[node].val << '\n';
+
+      node = getLeft(node);
+      depth++;
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+private:
+  static const uint32_t NIL = 0x3FFFFFFF;
+  static const uint32_t INDEX_MASK = 0x3FFFFFFF;
+
+  std::vector<CompactNode<T>> nodes;
+  uint32_t root;
+  uint32_t freeHead;
+  int count;
+
+  static int compare(const T &a, const T &b) {
+    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);
+  }
+
+  uint32_t getLeft(uint32_t node) const {
+    return nodes[node].left & INDEX_MASK;
+  }
+  uint32_t getRight(uint32_t node) const { return nodes[node].right; }
+  int getBalance(uint32_t node) const {
+    return static_cast<int>(nodes[node].left >> 30) - 1;
+  }
+
+  void setLeft(uint32_t node, uint32_t child) {
+    nodes[node].left = (nodes[node].left & ~INDEX_MASK) | child;
+  }
+  void setRight(uint32_t node, uint32_t child) { nodes[node].right = child; }
+  void setBalance(uint32_t node, int balance) {
+    nodes[node].left = (static_cast<uint32_t>(balance + 1) << 30) |
+                       (nodes[node].left & INDEX_MASK);
+  }
+
+  template <typename U> uint32_t allocNode(U &&val) {
+    uint32_t node;
+    if (freeHead != NIL) {
+      node = freeHead;
+      freeHead = nodes[node].left & INDEX_MASK;
+      nodes[node].val = std::forward<U>(val);
+    } else {
+      if (nodes.size() >= NIL) {
+        throw std::runtime_error("CompactAVL is full");
+      }
+      node = static_cast<uint32_t>(nodes.size());
+      nodes.push_back({std::forward<U>(val), 0, 0});
+    }
+    nodes[node].left = NIL;
+    nodes[node].right = NIL;
+    setBalance(node, 0);
+    count++;
+    return node;
+  }
+
+  void freeNode(uint32_t node) {
+    nodes[node].left = freeHead;
+    freeHead = node;
+    count--;
+  }
+
+  // node is two levels heavier on the left. Rotates and returns the new
+  // subtree root; shrunk tells whether the subtree lost a level.
+  uint32_t fixLeft(uint32_t node, bool &shrunk) {
+    uint32_t l = getLeft(node);
+    int bl = getBalance(l);
+
+    // LL
+    if (bl >= 0) {
+      setLeft(node, getRight(l));
+      setRight(l, node);
+      setBalance(node, bl == 0 ? 1 : 0);
+      setBalance(l, bl == 0 ? -1 : 0);
+      shrunk = bl != 0;
+      return l;
+    }
+
+    // LR
+    uint32_t lr = getRight(l);
+    int b = getBalance(lr);
+    setRight(l, getLeft(lr));
+    setLeft(node, getRight(lr));
+    setLeft(lr, l);
+    setRight(lr, node);
+    setBalance(node, b == 1 ? -1 : 0);
+    setBalance(l, b == -1 ? 1 : 0);
+    setBalance(lr, 0);
+    shrunk = true;
+    return lr;
+  }
+
+  uint32_t fixRight(uint32_t node, bool &shrunk) {
+    uint32_t r = getRight(node);
+    int br = getBalance(r);
+
+    // RR
+    if (br <= 0) {
+      setRight(node, getLeft(r));
+      setLeft(r, node);
+      setBalance(node, br == 0 ? -1 : 0);
+      setBalance(r, br == 0 ? 1 : 0);
+      shrunk = br != 0;
+      return r;
+    }
+
+    // RL
+    uint32_t rl = getLeft(r);
+    int b = getBalance(rl);
+    setLeft(r, getRight(rl));
+    setRight(node, getLeft(rl));
+    setRight(rl, r);
+    setLeft(rl, node);
+    setBalance(node, b == -1 ? 1 : 0);
+    setBalance(r, b == 1 ? -1 : 0);
+    setBalance(rl, 0);
+    shrunk = true;
+    return rl;
+  }
+
+  // U is T or const T&; val is moved into the new node.
+  template <typename U>
+  uint32_t insertNode(uint32_t node, U &&val, bool &grew) {
+    if (node == NIL) {
+      grew = true;
+      return allocNode(std::forward<U>(val));
+    }
+
+    int r = compare(val, nodes[node].val);
+    if (r == 0) {
+      grew = false;
+      return node;
+    }
+
+    bool shrunk = false;
+    if (r < 0) {
+      setLeft(node, insertNode(getLeft(node), std::forward<U>(val), grew));
+      if (!grew)
+        return node;
+      int b = getBalance(node);
+      if (b < 1) {
+        setBalance(node, b + 1);
+        grew = b == 0;
+        return node;
+      }
+      grew = false;
+      return fixLeft(node, shrunk);
+    }
+
+    setRight(node, insertNode(getRight(node), std::forward<U>(val), grew));
+    if (!grew)
+      return node;
+    int b = getBalance(node);
+    if (b > -1) {
+      setBalance(node, b - 1);
+      grew = b == 0;
+      return node;
+    }
+    grew = false;
+    return fixRight(node, shrunk);
+  }
+
+  // The left subtree of node lost a level.
+  uint32_t leftShrunk(uint32_t node, bool &shrunk) {
+    int b = getBalance(node);
+    if (b > -1) {
+      setBalance(node, b - 1);
+      shrunk = b == 1;
+      return node;
+    }
+    return fixRight(node, shrunk);
+  }
+
+  // The right subtree of node lost a level.
+  uint32_t rightShrunk(uint32_t node, bool &shrunk) {
+    int b = getBalance(node);
+    if (b < 1) {
+      setBalance(node, b + 1);
+      shrunk = b == -1;
+      return node;
+    }
+    return fixLeft(node, shrunk);
+  }
+
+  uint32_t removeMin(uint32_t node, uint32_t &minNode, bool &shrunk) {
+    if (getLeft(node) == NIL) {
+      minNode = node;
+      shrunk = true;
+      return getRight(node);
+    }
+    setLeft(node, removeMin(getLeft(node), minNode, shrunk));
+    return shrunk ? leftShrunk(node, shrunk) : node;
+  }
+
+  uint32_t removeNode(uint32_t node, const T &val, bool &removed,
+                      bool &shrunk) {
+    if (node == NIL) {
+      shrunk = false;
+      return NIL;
+    }
+
+    int r = compare(val, nodes[node].val);
+    if (r < 0) {
+      setLeft(node, removeNode(getLeft(node), val, removed, shrunk));
+      return shrunk ? leftShrunk(node, shrunk) : node;
+    }
+    if (r > 0) {
+      setRight(node, removeNode(getRight(node), val, removed, shrunk));
+      return shrunk ? rightShrunk(node, shrunk) : node;
+    }
+
+    removed = true;
+    if (getLeft(node) == NIL || getRight(node) == NIL) {
+      uint32_t child = getLeft(node) == NIL ? getRight(node) : getLeft(node);
+      freeNode(node);
+      shrunk = true;
+      return child;
+    }
+
+    uint32_t successor = NIL;
+    setRight(node, removeMin(getRight(node), successor, shrunk));
+    nodes[node].val = std::move(nodes[successor].val);
+    freeNode(successor);
+    return shrunk ? rightShrunk(node, shrunk) : node;
+  }
+};
+
+template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }
+template <typename T>
+using CompactAVLTree = CompactAVLAbstract<T, lessCompare<T>>;
+
+int main() {
+  std::cout << "=== Compact AVL Test ===" << std::endl;
+
+  CompactAVLTree<int> avl;
+
+  std::cout << "\n1. Inserting elements: 5, 3, 7, 2, 4, 6, 8" << std::endl;
+  int elems[] = {5, 3, 7, 2, 4, 6, 8};
+  for (int x : elems)
+    avl.insert(x);
+  avl.print();
+
+  std::cout << "\n2. Searching for elements:" << std::endl;
+  std::cout << "Search 4: "
+            << (avl.search(4) != nullptr ? "Found" : "Not found") << std::endl;
+  std::cout << "Search 10: "
+            << (avl.search(10) != nullptr ? "Found" : "Not found") << std::endl;
+
+  std::cout << "\n3. Removing node with two children (root 5):" << std::endl;
+  avl.remove(5);
+  avl.print();
+
+  std::cout << "\n4. Removing non-existent element (100):" << std::endl;
+  bool result = avl.remove(100);
+  std::cout << "Result: " << (result ? "Success" : "Failed (expected)")
+            << std::endl;
+
+  std::cout << "\n5. Inserting sorted sequence into new tree (1..15):"
+            << std::endl;
+  CompactAVLTree<int> avl2;
+  for (int i = 1; i <= 15; ++i) {
+    avl2.insert(i);
+  }
+  avl2.print();
+
+  std::cout << "\n6. Memory:" << std::endl;
+  std::cout << "sizeof(CompactNode<int>): " << sizeof(CompactNode<int>)
+            << " bytes" << std::endl;
+  std::cout << "Nodes: " << avl2.size() << ", array: " << avl2.memoryUsage()
+            << " bytes" << std::endl;
+
+  std::cout << "\n7. Copying and swapping trees:" << std::endl;
+  CompactAVLTree<int> copy = avl2;
+  copy.remove(8);
+  copy.swap(avl);
+  std::cout << "Sizes after swap: " << copy.size() << ", " << avl.size()
+            << std::endl;
+
+  std::cout << "\n8. Moving a tree and reusing the source:" << std::endl;
+  CompactAVLTree<int> moved = std::move(copy);
+  copy.insert(42);
+  std::cout << "Moved size: " << moved.size()
+            << ", source after insert: " << copy.size() << " ("
+            << (copy.search(42) != nullptr ? "42 found" : "42 missing") << ")"
+            << std::endl;
+
+  std::cout << "\n=== All Compact AVL tests completed ===" << std::endl;
+  return 0;
+}
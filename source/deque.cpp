@@ -1,12 +1,16 @@
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
 
 template <typename T> struct Node {
   T data;
   Node<T> *next;
   Node<T> *prev;
 
-  Node(T v) {
-    data = v;
+  Node(T v) : data(std::move(v)) {
     next = nullptr;
     prev = nullptr;
   }
@@ -23,22 +27,56 @@ public:
     size = 0;
   }
 
-  ~Queue() {
-    Node<T> *current = this->head;
-    while (current != nullptr) {
-      Node<T> *next = current->next;
-      delete current;
-      current = next;
+  // Deep copy in the same order.
+  Queue(const Queue &other) : Queue() {
+    try {
+      other.visit([this](const T &data) { pushBack(data); });
+    } catch (...) {
+      clear();
+      throw;
     }
   }
 
+  Queue(Queue &&other) noexcept {
+    head = other.head;
+    tail = other.tail;
+    size = other.size;
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.size = 0;
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  Queue &operator=(Queue other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~Queue() { clear(); }
+
+  void swap(Queue &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    std::swap(size, other.size);
+  }
+
+  void clear() {
+    while (head != nullptr) {
+      Node<T> *next = head->next;
+      delete head;
+      head = next;
+    }
+    tail = nullptr;
+    size = 0;
+  }
+
   T popBack() {
     if (tail == nullptr) {
       throw std::runtime_error("Deque is empty");
     }
 
     Node<T> *nodeToDelete = tail;
-    T data = tail->data;
+    T data = std::move(tail->data);
 
     if (head == tail) {
       head = nullptr;
@@ -59,7 +97,7 @@ public:
     }
 
     Node<T> *nodeToDelete = head;
-    T data = head->data;
+    T data = std::move(head->data);
 
     if (head == tail) {
       head = nullptr;
@@ -74,9 +112,33 @@ public:
     return data;
   }
 
-  void pushBack(T data) {
-    Node<T> *node = new Node<T>(data);
+  void pushBack(const T &data) { linkBack(new Node<T>(data)); }
+
+  void pushBack(T &&data) { linkBack(new Node<T>(std::move(data))); }
+
+  void pushForward(const T &data) { linkForward(new Node<T>(data)); }
+
+  void pushForward(T &&data) { linkForward(new Node<T>(std::move(data))); }
+
+  // Formats all elements into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Deque (size=" << size << "): ";
+    visit([&buffer](const T &data) { buffer << data << " "; });
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(data) for every element from front to back.
+  template <typename Fn> void visit(Fn fn) const {
+    for (Node<T> *current = head; current != nullptr;
+         current = current->next) {
+      fn(current->data);
+    }
+  }
 
+private:
+  void linkBack(Node<T> *node) {
     if (tail == nullptr) {
       head = node;
       tail = node;
@@ -88,9 +150,7 @@ public:
     size++;
   }
 
-  void pushForward(T data) {
-    Node<T> *node = new Node<T>(data);
-
+  void linkForward(Node<T> *node) {
     if (head == nullptr) {
       head = node;
       tail = node;
@@ -101,19 +161,333 @@ public:
     }
     size++;
   }
+};
+
+// Contiguous run of elements inside a ChunkedDeque, laid out like iovec.
+template <typename T> struct Segment {
+  T *data;
+  size_t size;
+};
+
+template <typename T, int ChunkSize> struct Chunk {
+  T data[ChunkSize];
+  int begin; // first live element
+  int end;   // one past the last live element
+  Chunk *next;
+  Chunk *prev;
+};
+
+// Deque stored as a doubly-linked list of fixed-size chunks instead of one
+// node per element, so its contents can be handed to writev/readv as a few
+// contiguous segments. frontSegments + consume drain the front without
+// popping element by element. backSegments + commit let the caller fill
+// free space at the back in place. T must be default constructible; for
+// readv into the back segments it should also be trivially copyable.
+template <typename T,
+          int ChunkSize = (sizeof(T) < 256 ? 4096 / sizeof(T) : 16)>
+class ChunkedDeque {
+public:
+  ChunkedDeque() {
+    head = nullptr;
+    tail = nullptr;
+    spare = nullptr;
+    spareCount = 0;
+    size = 0;
+  }
+
+  // Deep copy of the elements; spare chunks are not copied.
+  ChunkedDeque(const ChunkedDeque &other) : ChunkedDeque() {
+    try {
+      other.visit([this](const T &data) { pushBack(data); });
+    } catch (...) {
+      freeList(head);
+      freeList(spare);
+      throw;
+    }
+  }
+
+  ChunkedDeque(ChunkedDeque &&other) noexcept : ChunkedDeque() {
+    swap(other);
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  ChunkedDeque &operator=(ChunkedDeque other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~ChunkedDeque() {
+    freeList(head);
+    freeList(spare);
+  }
+
+  void swap(ChunkedDeque &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    std::swap(spare, other.spare);
+    std::swap(spareCount, other.spareCount);
+    std::swap(size, other.size);
+  }
+
+  void pushBack(const T &data) { pushBackValue(data); }
+  void pushBack(T &&data) { pushBackValue(std::move(data)); }
+  void pushForward(const T &data) { pushForwardValue(data); }
+  void pushForward(T &&data) { pushForwardValue(std::move(data)); }
+
+  T popBack() {
+    if (tail == nullptr) {
+      throw std::runtime_error("Deque is empty");
+    }
+    T data = std::move(tail->data[--tail->end]);
+    size--;
+    if (tail->begin == tail->end) {
+      unlink(tail);
+    }
+    return data;
+  }
+
+  T popForward() {
+    if (head == nullptr) {
+      throw std::runtime_error("Deque is empty");
+    }
+    T data = std::move(head->data[head->begin++]);
+    size--;
+    if (head->begin == head->end) {
+      unlink(head);
+    }
+    return data;
+  }
+
+  // Writes up to max segments covering the deque from the front, in order,
+  // and returns how many were written. Segments stay valid until the deque
+  // is modified.
+  int frontSegments(Segment<T> *out, int max) const {
+    int n = 0;
+    for (Chunk<T, ChunkSize> *chunk = head; chunk != nullptr && n < max;
+         chunk = chunk->next) {
+      out[n++] = {chunk->data + chunk->begin,
+                  static_cast<size_t>(chunk->end - chunk->begin)};
+    }
+    return n;
+  }
+
+  // Drops count elements from the front, e.g. after writev sent them.
+  void consume(size_t count) {
+    if (count > static_cast<size_t>(size)) {
+      throw std::out_of_range("Deque has fewer elements");
+    }
+    size -= static_cast<int>(count);
+    while (count > 0) {
+      size_t available = head->end - head->begin;
+      if (count < available) {
+        head->begin += static_cast<int>(count);
+        break;
+      }
+      count -= available;
+      unlink(head);
+    }
+  }
+
+  // Writes up to max segments of free space at the back, together at least
+  // want elements long when max allows, and returns how many were written.
+  // Fill them (e.g. with readv), then call commit. No other modification may
+  // happen in between.
+  int backSegments(Segment<T> *out, int max, size_t want) {
+    int n = 0;
+    size_t room = 0;
+    if (tail != nullptr && tail->end < ChunkSize && n < max) {
+      out[n++] = {tail->data + tail->end,
+                  static_cast<size_t>(ChunkSize - tail->end)};
+      room += ChunkSize - tail->end;
+    }
+    Chunk<T, ChunkSize> **link = &spare;
+    while (room < want && n < max) {
+      if (*link == nullptr) {
+        *link = new Chunk<T, ChunkSize>;
+        (*link)->next = nullptr;
+        spareCount++;
+      }
+      out[n++] = {(*link)->data, static_cast<size_t>(ChunkSize)};
+      room += ChunkSize;
+      link = &(*link)->next;
+    }
+    return n;
+  }
+
+  // Appends count elements that were written into the back segments.
+  void commit(size_t count) {
+    size_t room = static_cast<size_t>(spareCount) * ChunkSize;
+    if (tail != nullptr) {
+      room += ChunkSize - tail->end;
+    }
+    if (count > room) {
+      throw std::out_of_range("Commit exceeds reserved space");
+    }
+
+    size += static_cast<int>(count);
+    if (tail != nullptr && tail->end < ChunkSize) {
+      size_t filled =
+          std::min(count, static_cast<size_t>(ChunkSize - tail->end));
+      tail->end += static_cast<int>(filled);
+      count -= filled;
+    }
+    while (count > 0) {
+      // Spares come out in the order backSegments handed them out.
+      Chunk<T, ChunkSize> *chunk = takeChunk(0);
+      chunk->end = static_cast<int>(std::min(count, size_t(ChunkSize)));
+      count -= chunk->end;
+      linkBack(chunk);
+    }
+  }
+
+  bool isEmpty() const { return size == 0; }
+
+  int getSize() const { return size; }
+
+  // Formats all elements into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Deque (size=" << size << "): ";
+    visit([&buffer](const T &data) { buffer << data << " "; });
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(data) for every element from front to back.
+  template <typename Fn> void visit(Fn fn) const {
+    for (Chunk<T, ChunkSize> *chunk = head; chunk != nullptr;
+         chunk = chunk->next) {
+      for (int i = chunk->begin; i < chunk->end; i++) {
+        fn(chunk->data[i]);
+      }
+    }
+  }
+
+private:
+  // Spare chunks kept after they empty out, so a deque used as an I/O buffer
+  // does not allocate in steady state.
+  static const int MAX_SPARE = 2;
+
+  Chunk<T, ChunkSize> *head;
+  Chunk<T, ChunkSize> *tail;
+  Chunk<T, ChunkSize> *spare; // singly linked through next
+  int spareCount;
+  int size;
+
+  // The element is assigned before tail->end moves, and a new chunk is
+  // linked only once the assignment into it succeeded, so a throwing
+  // assignment leaves the deque unchanged.
+  template <typename U> void pushBackValue(U &&data) {
+    if (tail != nullptr && tail->end < ChunkSize) {
+      tail->data[tail->end] = std::forward<U>(data);
+      tail->end++;
+    } else {
+      Chunk<T, ChunkSize> *chunk = takeChunk(0);
+      try {
+        chunk->data[0] = std::forward<U>(data);
+      } catch (...) {
+        release(chunk);
+        throw;
+      }
+      chunk->end = 1;
+      linkBack(chunk);
+    }
+    size++;
+  }
+
+  // Mirror of pushBackValue.
+  template <typename U> void pushForwardValue(U &&data) {
+    if (head != nullptr && head->begin > 0) {
+      head->data[head->begin - 1] = std::forward<U>(data);
+      head->begin--;
+    } else {
+      Chunk<T, ChunkSize> *chunk = takeChunk(ChunkSize);
+      try {
+        chunk->data[ChunkSize - 1] = std::forward<U>(data);
+      } catch (...) {
+        release(chunk);
+        throw;
+      }
+      chunk->begin = ChunkSize - 1;
+      linkForward(chunk);
+    }
+    size++;
+  }
 
-  void print() {
-    Node<T> *current = head;
-    std::cout << "Deque (size=" << size << "): ";
-    while (current != nullptr) {
-      std::cout << current->data << " ";
-      current = current->next;
+  // Returns an empty chunk with begin = end = at, reusing a spare if any.
+  Chunk<T, ChunkSize> *takeChunk(int at) {
+    Chunk<T, ChunkSize> *chunk = spare;
+    if (chunk != nullptr) {
+      spare = chunk->next;
+      spareCount--;
+    } else {
+      chunk = new Chunk<T, ChunkSize>;
+    }
+    chunk->begin = at;
+    chunk->end = at;
+    chunk->next = nullptr;
+    chunk->prev = nullptr;
+    return chunk;
+  }
+
+  void linkBack(Chunk<T, ChunkSize> *chunk) {
+    chunk->prev = tail;
+    if (tail == nullptr) {
+      head = chunk;
+    } else {
+      tail->next = chunk;
+    }
+    tail = chunk;
+  }
+
+  void linkForward(Chunk<T, ChunkSize> *chunk) {
+    chunk->next = head;
+    if (head == nullptr) {
+      tail = chunk;
+    } else {
+      head->prev = chunk;
+    }
+    head = chunk;
+  }
+
+  // Removes an empty chunk from the list and keeps or frees it.
+  void unlink(Chunk<T, ChunkSize> *chunk) {
+    if (chunk->prev) {
+      chunk->prev->next = chunk->next;
+    } else {
+      head = chunk->next;
+    }
+    if (chunk->next) {
+      chunk->next->prev = chunk->prev;
+    } else {
+      tail = chunk->prev;
+    }
+    release(chunk);
+  }
+
+  // Keeps an unlinked chunk as a spare, or frees it.
+  void release(Chunk<T, ChunkSize> *chunk) {
+    if (spareCount < MAX_SPARE) {
+      chunk->next = spare;
+      spare = chunk;
+      spareCount++;
+    } else {
+      delete chunk;
+    }
+  }
+
+  static void freeList(Chunk<T, ChunkSize> *chunk) {
+    while (chunk != nullptr) {
+      Chunk<T, ChunkSize> *next = chunk->next;
+      delete chunk;
+      chunk = next;
     }
-    std::cout << std::endl;
   }
 };
 
 #include <cassert>
+#include <cstring>
+#include <string>
 
 int main() {
   std::cout << "=== Deque Tests ===" << std::endl;
@@ -198,6 +572,113 @@ int main() {
   assert(q5.popBack() == 2);
   assert(q5.popBack() == 1);
 
+  std::cout << "\n7. Testing chunked deque across chunk borders:" << std::endl;
+  ChunkedDeque<int, 4> c1;
+  for (int i = 0; i < 10; i++) {
+    c1.pushBack(i);
+  }
+  c1.pushForward(-1);
+  c1.print();
+  assert(c1.popForward() == -1);
+  assert(c1.popBack() == 9);
+  assert(c1.getSize() == 9);
+
+  std::cout << "\n8. Testing front segments and consume:" << std::endl;
+  Segment<int> segs[8];
+  int n = c1.frontSegments(segs, 8);
+  std::cout << "Segments:";
+  for (int i = 0; i < n; i++) {
+    std::cout << " [" << segs[i].data[0] << ".."
+              << segs[i].data[segs[i].size - 1] << "]";
+  }
+  std::cout << std::endl;
+  c1.consume(6);
+  c1.print();
+  assert(c1.popForward() == 6);
+
+  std::cout << "\n9. Testing back segments and commit as a byte buffer:"
+            << std::endl;
+  ChunkedDeque<char, 8> bytes;
+  const char *message = "hello, segmented world";
+  size_t length = std::strlen(message);
+  Segment<char> space[4];
+  int m = bytes.backSegments(space, 4, length);
+  size_t copied = 0;
+  for (int i = 0; i < m && copied < length; i++) {
+    size_t k = std::min(space[i].size, length - copied);
+    std::memcpy(space[i].data, message + copied, k);
+    copied += k;
+  }
+  bytes.commit(length);
+
+  std::string drained;
+  Segment<char> data[4];
+  while (!bytes.isEmpty()) {
+    int k = bytes.frontSegments(data, 4);
+    size_t total = 0;
+    for (int i = 0; i < k; i++) {
+      drained.append(data[i].data, data[i].size);
+      total += data[i].size;
+    }
+    bytes.consume(total);
+  }
+  std::cout << "Drained: " << drained << std::endl;
+  assert(drained == message);
+
+  std::cout << "\n10. Testing copy, move and swap:" << std::endl;
+  Queue<std::string> words;
+  words.pushBack("a");
+  words.pushBack("b");
+  Queue<std::string> wordsCopy = words;
+  wordsCopy.pushForward("z");
+  Queue<std::string> wordsMoved = std::move(wordsCopy);
+  assert(wordsCopy.size == 0);
+  assert(words.size == 2 && wordsMoved.size == 3);
+  ChunkedDeque<int, 4> c2 = c1;
+  c2.pushBack(100);
+  ChunkedDeque<int, 4> c3 = std::move(c2);
+  c3.swap(c1);
+  c1.print();
+  c3.print();
+
+  std::cout << "\n11. Testing pushes whose assignment throws:" << std::endl;
+  struct Fussy {
+    int val = 0;
+    bool bad = false;
+    Fussy() = default;
+    Fussy(const Fussy &) = default;
+    Fussy &operator=(const Fussy &other) {
+      if (other.bad) {
+        throw std::runtime_error("Fussy copy failed");
+      }
+      val = other.val;
+      bad = false;
+      return *this;
+    }
+  };
+  Fussy good, bad;
+  bad.bad = true;
+  ChunkedDeque<Fussy, 4> fussy;
+  int failed = 0;
+  for (int round = 0; round < 2; round++) {
+    // Empty deque, then a full chunk at each end: every push needs a chunk.
+    for (bool back : {true, false}) {
+      try {
+        back ? fussy.pushBack(bad) : fussy.pushForward(bad);
+      } catch (const std::runtime_error &) {
+        failed++;
+      }
+    }
+    for (int i = 0; i < 4; i++) {
+      good.val = i;
+      fussy.pushBack(good);
+    }
+  }
+  assert(failed == 4 && fussy.getSize() == 8);
+  assert(fussy.popBack().val == 3 && fussy.popForward().val == 0);
+  std::cout << "Failed pushes: " << failed
+            << ", size after pops: " << fussy.getSize() << std::endl;
+
   std::cout << "\n=== All tests passed! ===" << std::endl;
 
   return 0;
@@ -0,0 +1,343 @@
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Control byte per slot: EMPTY, DELETED, or the low 7 bits of the key hash
+// for a full slot. Slots are probed in aligned groups of 16 control bytes,
+// compared all at once with SSE2 when available.
+const int8_t CTRL_EMPTY = -128;
+const int8_t CTRL_DELETED = -2;
+const int GROUP_SIZE = 16;
+
+// Bit i is set when ctrl[i] == value, for the 16 bytes of a group.
+inline uint32_t matchGroup(const int8_t *ctrl, int8_t value) {
+#if defined(__SSE2__)
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < GROUP_SIZE; i++) {
+    if (ctrl[i] == value)
+      mask |= 1u << i;
+  }
+  return mask;
+#endif
+}
+
+// Bit i is set when slot i of the group is EMPTY or DELETED.
+inline uint32_t matchFree(const int8_t *ctrl) {
+#if defined(__SSE2__)
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+  return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < GROUP_SIZE; i++) {
+    if (ctrl[i] < 0)
+      mask |= 1u << i;
+  }
+  return mask;
+#endif
+}
+
+inline int lowestBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int i = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+// Open-addressing table shared by HashSetAbstract and HashMapAbstract. Slot
+// must have a `key` member; keys are compared with ==. Slots are stored flat
+// in one vector, so Slot must be default constructible, and the implicit
+// copy and move operations copy or steal the whole table.
+template <typename Slot, typename K, size_t (*Hash)(const K &)>
+class SwissTable {
+public:
+  SwissTable() {
+    count = 0;
+    used = 0;
+  }
+
+  Slot *find(const K &key) {
+    if (slots.empty())
+      return nullptr;
+
+    uint64_t h = mix(key);
+    int8_t h2 = static_cast<int8_t>(h & 0x7F);
+    size_t groupMask = slots.size() / GROUP_SIZE - 1;
+    size_t group = (h >> 7) & groupMask;
+
+    for (size_t step = 1;; step++) {
+      const int8_t *ctrl = &control[group * GROUP_SIZE];
+      for (uint32_t m = matchGroup(ctrl, h2); m; m &= m - 1) {
+        Slot &slot = slots[group * GROUP_SIZE + lowestBit(m)];
+        if (slot.key == key)
+          return &slot;
+      }
+      if (matchGroup(ctrl, CTRL_EMPTY))
+        return nullptr;
+      group = (group + step) & groupMask;
+    }
+  }
+
+  // Returns the slot holding key, claiming a free one if key is new. U is K
+  // or const K&; a new key is moved into its slot.
+  template <typename U> Slot *findOrInsert(U &&key, bool &inserted) {
+    Slot *slot = find(key);
+    if (slot) {
+      inserted = false;
+      return slot;
+    }
+
+    if ((used + 1) * 8 > slots.size() * 7)
+      rehash(count * 2 >= slots.size() ? slots.size() * 2 : slots.size());
+
+    uint64_t h = mix(key);
+    size_t i = freeSlot(h);
+    if (control[i] == CTRL_EMPTY)
+      used++;
+    control[i] = static_cast<int8_t>(h & 0x7F);
+    slots[i].key = std::forward<U>(key);
+    count++;
+    inserted = true;
+    return &slots[i];
+  }
+
+  bool erase(const K &key) {
+    Slot *slot = find(key);
+    if (!slot)
+      return false;
+
+    size_t i = static_cast<size_t>(slot - slots.data());
+    // Probes never pass a group that has an EMPTY slot, so the slot can go
+    // back to EMPTY instead of leaving a tombstone.
+    if (matchGroup(&control[i / GROUP_SIZE * GROUP_SIZE], CTRL_EMPTY)) {
+      control[i] = CTRL_EMPTY;
+      used--;
+    } else {
+      control[i] = CTRL_DELETED;
+    }
+    slots[i] = Slot();
+    count--;
+    return true;
+  }
+
+  void clear() {
+    slots.clear();
+    control.clear();
+    count = 0;
+    used = 0;
+  }
+
+  void reserve(size_t n) {
+    size_t capacity = GROUP_SIZE;
+    while (capacity * 7 < n * 8)
+      capacity *= 2;
+    if (capacity > slots.size())
+      rehash(capacity);
+  }
+
+  size_t size() const { return count; }
+
+  void swap(SwissTable &other) noexcept {
+    slots.swap(other.slots);
+    control.swap(other.control);
+    std::swap(count, other.count);
+    std::swap(used, other.used);
+  }
+
+  template <typename Fn> void visit(Fn fn) const {
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (control[i] >= 0)
+        fn(slots[i]);
+    }
+  }
+
+private:
+  std::vector<Slot> slots;
+  std::vector<int8_t> control;
+  size_t count; // full slots
+  size_t used;  // full plus DELETED slots
+
+  static uint64_t mix(const K &key) {
+    uint64_t h = static_cast<uint64_t>(Hash(key)) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+  }
+
+  size_t freeSlot(uint64_t h) const {
+    size_t groupMask = slots.size() / GROUP_SIZE - 1;
+    size_t group = (h >> 7) & groupMask;
+    for (size_t step = 1;; step++) {
+      uint32_t m = matchFree(&control[group * GROUP_SIZE]);
+      if (m)
+        return group * GROUP_SIZE + lowestBit(m);
+      group = (group + step) & groupMask;
+    }
+  }
+
+  void rehash(size_t capacity) {
+    if (capacity < GROUP_SIZE)
+      capacity = GROUP_SIZE;
+
+    std::vector<Slot> oldSlots(capacity);
+    std::vector<int8_t> oldControl(capacity, CTRL_EMPTY);
+    oldSlots.swap(slots);
+    oldControl.swap(control);
+    used = count;
+
+    for (size_t i = 0; i < oldSlots.size(); i++) {
+      if (oldControl[i] < 0)
+        continue;
+      size_t j = freeSlot(mix(oldSlots[i].key));
+      control[j] = oldControl[i];
+      slots[j] = std::move(oldSlots[i]);
+    }
+  }
+};
+
+template <typename T> struct SetSlot {
+  T key;
+};
+
+template <typename K, typename V> struct MapSlot {
+  K key;
+  V val;
+};
+
+template <typename T, size_t (*Hash)(const T &)>
+class HashSetAbstract {
+public:
+  void insert(const T &val) {
+    bool inserted;
+    table.findOrInsert(val, inserted);
+  }
+  void insert(T &&val) {
+    bool inserted;
+    table.findOrInsert(std::move(val), inserted);
+  }
+  T *search(const T &val) {
+    SetSlot<T> *slot = table.find(val);
+    return slot ? &(slot->key) : nullptr;
+  }
+  bool remove(const T &val) { return table.erase(val); }
+  void clear() { table.clear(); }
+  void swap(HashSetAbstract &other) noexcept { table.swap(other.table); }
+  void reserve(int n) { table.reserve(n); }
+  int size() const { return static_cast<int>(table.size()); }
+
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "HashSet (size=" << size() << "): ";
+    table.visit(
+        [&buffer](const SetSlot<T> &slot) { buffer << slot.key << " "; });
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+private:
+  SwissTable<SetSlot<T>, T, Hash> table;
+};
+
+template <typename K, typename V, size_t (*Hash)(const K &)>
+class HashMapAbstract {
+public:
+  // Inserts key or overwrites its value. Both are taken by value and moved
+  // into the slot, so rvalues are never copied.
+  void insert(K key, V val) {
+    bool inserted;
+    table.findOrInsert(std::move(key), inserted)->val = std::move(val);
+  }
+  V *search(const K &key) {
+    MapSlot<K, V> *slot = table.find(key);
+    return slot ? &(slot->val) : nullptr;
+  }
+  bool remove(const K &key) { return table.erase(key); }
+  void clear() { table.clear(); }
+  void swap(HashMapAbstract &other) noexcept { table.swap(other.table); }
+  void reserve(int n) { table.reserve(n); }
+  int size() const { return static_cast<int>(table.size()); }
+
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "HashMap (size=" << size() << "): ";
+    table.visit([&buffer](const MapSlot<K, V> &slot) {
+      buffer << slot.key << "=" << slot.val << " ";
+    });
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+private:
+  SwissTable<MapSlot<K, V>, K, Hash> table;
+};
+
+template <typename T> size_t stdHash(const T &val) {
+  return std::hash<T>()(val);
+}
+
+template <typename T> using HashSet = HashSetAbstract<T, stdHash<T>>;
+template <typename K, typename V>
+using HashMap = HashMapAbstract<K, V, stdHash<K>>;
+
+#include <string>
+
+int main() {
+  std::cout << "=== Hash Set Test ===" << std::endl;
+
+  HashSet<int> set;
+
+  std::cout << "\n1. Inserting elements: 5, 3, 7, 2, 4, 6, 8, 5" << std::endl;
+  int elems[] = {5, 3, 7, 2, 4, 6, 8, 5};
+  for (int x : elems)
+    set.insert(x);
+  set.print();
+
+  std::cout << "\n2. Searching for elements:" << std::endl;
+  std::cout << "Search 4: "
+            << (set.search(4) != nullptr ? "Found" : "Not found") << std::endl;
+  std::cout << "Search 10: "
+            << (set.search(10) != nullptr ? "Found" : "Not found") << std::endl;
+
+  std::cout << "\n3. Removing 4 and non-existent 100:" << std::endl;
+  std::cout << "remove(4): " << (set.remove(4) ? "true" : "false") << std::endl;
+  std::cout << "remove(100): " << (set.remove(100) ? "true" : "false")
+            << std::endl;
+  set.print();
+
+  std::cout << "\n4. Growing to 100000 elements:" << std::endl;
+  for (int i = 0; i < 100000; i++)
+    set.insert(i);
+  for (int i = 0; i < 100000; i += 2)
+    set.remove(i);
+  std::cout << "Size: " << set.size() << std::endl;
+  std::cout << "Search 99999: "
+            << (set.search(99999) != nullptr ? "Found" : "Not found")
+            << std::endl;
+  std::cout << "Search 50000: "
+            << (set.search(50000) != nullptr ? "Found" : "Not found")
+            << std::endl;
+
+  std::cout << "\n5. Map with string keys:" << std::endl;
+  HashMap<std::string, int> map;
+  map.insert("one", 1);
+  map.insert("two", 2);
+  map.insert("one", 11);
+  map.print();
+  std::cout << "one = " << *map.search("one") << std::endl;
+
+  std::cout << "\n=== All Hash Set tests completed ===" << std::endl;
+  return 0;
+}
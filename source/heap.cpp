@@ -1,22 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// Binary dump layout: header followed by `count` raw elements in heap order.
+struct DumpHeader {
+  char magic[4];
+  uint32_t elemSize;
+  uint64_t count;
+};
+
+// Reads the `count` elements that follow a DumpHeader into out. count comes
+// from the file, so it is checked against the bytes left in the stream
+// before out is sized. A stream that cannot seek is read in bounded steps
+// instead, so a corrupt count ends in a short read, not a huge allocation.
+template <typename T>
+bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {
+  uint64_t step = count;
+  std::streampos here = in.tellg();
+  if (here != std::streampos(-1) && in.seekg(0, std::ios::end)) {
+    uint64_t left = static_cast<uint64_t>(in.tellg() - here);
+    in.seekg(here);
+    if (count > left / sizeof(T))
+      return false;
+  } else {
+    in.clear();
+    step = 1 << 16;
+  }
+  out.clear();
+  while (out.size() < count) {
+    size_t done = out.size();
+    size_t n = static_cast<size_t>(std::min<uint64_t>(step, count - done));
+    out.resize(done + n);
+    in.read(reinterpret_cast<char *>(out.data() + done), n * sizeof(T));
+    if (!in)
+      return false;
+  }
+  return true;
+}
+
+// Fixed set of worker threads for the parallel bulk operations. run() is a
+// fork-join step: the calling thread takes part, and it returns once every
+// task is done. Tasks of one run() must not call run() on the same pool.
+class ThreadPool {
+public:
+  // threads counts the calling thread, so ThreadPool(1) runs tasks inline.
+  explicit ThreadPool(
+      int threads = static_cast<int>(std::thread::hardware_concurrency())) {
+    job = nullptr;
+    jobSize = 0;
+    next = 0;
+    pending = 0;
+    active = 0;
+    generation = 0;
+    stopping = false;
+    for (int i = 1; i < threads; i++) {
+      workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Calls fn(i) for every i in [0, count), spread over the pool. The first
+  // exception thrown by a task is rethrown here after all tasks finished.
+  template <typename Fn> void run(int count, Fn fn) {
+    if (count <= 0)
+      return;
+    if (workers.empty() || count == 1) {
+      for (int i = 0; i < count; i++) {
+        fn(i);
+      }
+      return;
+    }
+
+    std::function<void(int)> task = fn;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &task;
+      jobSize = count;
+      next = 0;
+      pending = count;
+      error = nullptr;
+      generation++;
+    }
+    wake.notify_all();
+    work(task, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0 && active == 0; });
+    job = nullptr;
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const std::function<void(int)> *job;
+  int jobSize;
+  std::atomic<int> next; // next task index to hand out
+  int pending;           // tasks not finished yet
+  int active;            // workers inside work(), run() waits for them too
+  uint64_t generation;
+  bool stopping;
+  std::exception_ptr error;
+
+  void workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+      const std::function<void(int)> *task;
+      int count;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+          return;
+        seen = generation;
+        if (job == nullptr)
+          continue;
+        task = job;
+        count = jobSize;
+        active++;
+      }
+      work(*task, count);
+      std::lock_guard<std::mutex> lock(mutex);
+      active--;
+      if (pending == 0 && active == 0)
+        done.notify_all();
+    }
+  }
+
+  void work(const std::function<void(int)> &task, int count) {
+    int finished = 0;
+    for (int i; (i = next.fetch_add(1)) < count;) {
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+      finished++;
+    }
+    if (finished > 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending -= finished;
+      if (pending == 0 && active == 0)
+        done.notify_all();
+    }
+  }
+};
+
+// Array-backed binary heap. The implicit copy and move operations copy or
+// steal the array.
 template <typename T, bool (*Comp)(const T &, const T &)>
 class Heap {
 public:
   Heap() { std::vector<T> arr; }
 
-  void insert(int val) {
+  void insert(const T &val) {
     arr.push_back(val);
     siftUp(arr.size() - 1);
   }
 
-  int popRoot() {
+  void insert(T &&val) {
+    arr.push_back(std::move(val));
+    siftUp(arr.size() - 1);
+  }
+
+  T popRoot() {
     if (arr.empty()) {
       throw std::out_of_range("Heap is empty");
     }
 
-    int result = arr[0];
+    T result = std::move(arr[0]);
     int last = arr.size() - 1;
 
     std::swap(arr[0], arr[last]);
@@ -29,7 +214,7 @@ public:
     return result;
   }
 
-  int peek() const {
+  T peek() const {
     if (arr.empty()) {
       throw std::out_of_range("Heap is empty");
     }
@@ -42,13 +227,100 @@ public:
 
   void clear() { arr.clear(); }
 
-  void print() const {
-    print(0, 0);
-    std::cout << std::endl;
+  void swap(Heap &other) noexcept { arr.swap(other.arr); }
+
+  // Replaces the contents with data, heapified bottom-up in O(n). The nodes
+  // of one level head disjoint subtrees, so each level's sift-downs are
+  // split into pool tasks, deepest level first. Levels near the root have
+  // too few nodes to be worth splitting and run inline.
+  void buildParallel(std::vector<T> data, ThreadPool &pool) {
+    arr = std::move(data);
+    int last = static_cast<int>(arr.size()) / 2 - 1; // last node with a child
+    if (last < 0)
+      return;
+
+    int level = 0;
+    while ((2 << level) - 1 <= last)
+      level++;
+    for (; level >= 0; level--) {
+      int first = (1 << level) - 1;
+      int count = std::min(last + 1, (2 << level) - 1) - first;
+      int tasks = std::min(count / HEAPIFY_GRAIN, 4 * pool.size());
+      if (tasks < 2) {
+        for (int i = first; i < first + count; i++)
+          siftDown(i);
+        continue;
+      }
+      pool.run(tasks, [&](int t) {
+        int lo = first + static_cast<int>(int64_t(count) * t / tasks);
+        int hi = first + static_cast<int>(int64_t(count) * (t + 1) / tasks);
+        for (int i = lo; i < hi; i++)
+          siftDown(i);
+      });
+    }
+  }
+
+  // Formats the whole heap into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    print(buffer, 0, 0);
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(val, depth) in array order, which is level order for a heap.
+  template <typename Fn> void visitLevelOrder(Fn fn) const {
+    int depth = 0;
+    for (size_t i = 0; i < arr.size(); i++) {
+      if (i + 1 == (size_t(1) << (depth + 1)))
+        depth++;
+      fn(arr[i], depth);
+    }
+  }
+
+  // Writes arr as is, see DumpHeader.
+  void serialize(std::ostream &out) const {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "serialize requires a trivially copyable T");
+    DumpHeader header = {{'D', 'S', 'H', 'P'}, sizeof(T), arr.size()};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(arr.data()),
+              arr.size() * sizeof(T));
+    if (!out) {
+      throw std::runtime_error("Failed to write heap dump");
+    }
+  }
+
+  // Replaces the contents with a dump written by serialize(). The array is
+  // already in heap order, so it is only checked in O(n), with no sifting.
+  // The dump is read into a separate array, so if loading throws the heap
+  // is left unchanged.
+  void deserialize(std::istream &in) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "deserialize requires a trivially copyable T");
+    DumpHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, "DSHP", 4) != 0 ||
+        header.elemSize != sizeof(T)) {
+      throw std::runtime_error("Invalid heap dump");
+    }
+    std::vector<T> loaded;
+    if (!readDumpElements(in, header.count, loaded)) {
+      throw std::runtime_error("Truncated heap dump");
+    }
+    for (size_t i = 1; i < loaded.size(); i++) {
+      if (Comp(loaded[i], loaded[(i - 1) / 2])) {
+        throw std::runtime_error("Heap dump is not in heap order");
+      }
+    }
+    arr.swap(loaded);
   }
 
 private:
-  std::vector<int> arr;
+  // Fewest sift-downs worth handing to the pool as one task.
+  static const int HEAPIFY_GRAIN = 1024;
+
+  std::vector<T> arr;
 
   void siftUp(int i) {
     while (i > 0) {
@@ -85,21 +357,21 @@ private:
     }
   }
 
-  void print(int index, int depth) const {
+  void print(std::ostringstream &buffer, int index, int depth) const {
     if (index >= static_cast<int>(arr.size()))
       return;
 
     int right = 2 * index + 2;
     int left = 2 * index + 1;
 
-    print(right, depth + 1);
+    print(buffer, right, depth + 1);
 
     for (int i = 0; i < depth; ++i) {
-      std::cout << "   ";
+      buffer << "   ";
     }
 
-    std::cout << arr[index] << std::endl;
-    print(left, depth + 1);
+    buffer << arr[index] << '\n';
+    print(buffer, left, depth + 1);
   }
 };
 
@@ -109,6 +381,286 @@ template <typename T> bool maxCompare(const T &a, const T &b) { return a > b; }
 template <typename T = int> using MinHeap = Heap<T, minCompare<T>>;
 template <typename T = int> using MaxHeap = Heap<T, maxCompare<T>>;
 
+// Timer parked in the TimingWheel overflow heap, ordered by deadline. The
+// generation tells whether the timer was cancelled while parked.
+struct FarTimer {
+  uint64_t deadline;
+  uint32_t index;
+  uint32_t generation;
+
+  bool operator<(const FarTimer &other) const {
+    return deadline < other.deadline;
+  }
+};
+
+// Timer queue for large numbers of timeouts, most of which are cancelled
+// before they fire. Time is counted in ticks. A deadline less than
+// 2^(8 * Levels) ticks ahead goes into a hierarchy of 256-slot wheels, where
+// schedule and cancel are O(1) list splices. Each level's slots are 256
+// times wider than the level below, and a slot is redistributed to lower
+// levels when time reaches it. Deadlines further away wait in a MinHeap and
+// move into the wheels when the top level wraps. Timers live in one node
+// array recycled through a free list, so steady-state use does not
+// allocate. T must be default constructible.
+template <typename T, int Levels = 4> class TimingWheel {
+  static_assert(Levels >= 1 && Levels <= 7, "Levels must be in 1..7");
+
+public:
+  // Handle returned by schedule(): node index and its generation. Handles
+  // of fired or cancelled timers are detected through the generation.
+  using TimerId = uint64_t;
+
+  explicit TimingWheel(uint64_t start = 0) {
+    current = start;
+    freeList = NIL;
+    wheelCount = 0;
+    farCount = 0;
+    staleFar = 0;
+    for (uint32_t &head : slots) {
+      head = NIL;
+    }
+  }
+
+  // Arms a timer that fires on the first tick at or after deadline.
+  // Deadlines not after now() fire on the next tick.
+  TimerId schedule(uint64_t deadline, T payload) {
+    uint32_t index = allocate();
+    TimerNode &node = nodes[index];
+    node.payload = std::move(payload);
+    node.deadline = deadline > current ? deadline : current + 1;
+    place(index);
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+  }
+
+  // Disarms a timer. Returns false if it already fired or was cancelled.
+  // A timer parked in the heap is only marked stale there; the heap is
+  // rebuilt once stale entries outnumber the live ones.
+  bool cancel(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    if (index >= nodes.size() || nodes[index].slot == FREE ||
+        nodes[index].generation != static_cast<uint32_t>(id >> 32)) {
+      return false;
+    }
+
+    if (nodes[index].slot == FAR) {
+      farCount--;
+      staleFar++;
+    } else {
+      unlink(index);
+    }
+    release(index);
+
+    if (staleFar > MIN_COMPACT && staleFar > farCount) {
+      compactFar();
+    }
+    return true;
+  }
+
+  // Moves time forward to `time`, calling fire(T&&) for every timer that
+  // expires on the way, in tick order. All timers due on one tick are
+  // unlinked as a batch before fire() runs for them, so fire() may schedule
+  // and cancel timers, but must not call advance(). Returns the number of
+  // timers fired.
+  template <typename Fn> size_t advance(uint64_t time, Fn fire) {
+    size_t fired = 0;
+    while (current < time) {
+      if (wheelCount == 0) {
+        // Nothing can fire before the top level wraps, so skip to there.
+        uint64_t idle = current | (RANGE - 1);
+        if (idle >= time) {
+          current = time;
+          break;
+        }
+        current = idle;
+      }
+
+      tick();
+      for (T &payload : expired) {
+        fire(std::move(payload));
+      }
+      fired += expired.size();
+      expired.clear();
+    }
+    return fired;
+  }
+
+  // Disarms every timer; handles issued so far become stale.
+  void clear() {
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+      if (nodes[i].slot != FREE)
+        release(i);
+    }
+    for (uint32_t &head : slots) {
+      head = NIL;
+    }
+    far.clear();
+    wheelCount = 0;
+    farCount = 0;
+    staleFar = 0;
+  }
+
+  uint64_t now() const { return current; }
+
+  int size() const { return static_cast<int>(wheelCount + farCount); }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  static const int SLOT_BITS = 8;
+  static const uint32_t SLOTS = 1u << SLOT_BITS;
+  static const uint64_t RANGE = uint64_t(1) << (SLOT_BITS * Levels);
+  static const uint32_t NIL = 0xFFFFFFFFu;
+  static const uint32_t FAR = 0xFFFFFFFEu;  // slot of a timer in the heap
+  static const uint32_t FREE = 0xFFFFFFFDu; // slot of a node on the free list
+  static const size_t MIN_COMPACT = 1024;
+
+  struct TimerNode {
+    T payload;
+    uint64_t deadline = 0;
+    uint32_t next = NIL; // also links the free list
+    uint32_t prev = NIL;
+    uint32_t slot = FREE;
+    uint32_t generation = 1;
+  };
+
+  std::vector<TimerNode> nodes;
+  uint32_t slots[Levels * SLOTS]; // list heads, level by level
+  MinHeap<FarTimer> far;
+  std::vector<T> expired; // batch of the current tick, reused
+  uint64_t current;
+  uint32_t freeList;
+  size_t wheelCount;
+  size_t farCount;
+  size_t staleFar; // cancelled entries still in far
+
+  uint32_t allocate() {
+    if (freeList == NIL) {
+      nodes.emplace_back();
+      return static_cast<uint32_t>(nodes.size() - 1);
+    }
+    uint32_t index = freeList;
+    freeList = nodes[index].next;
+    return index;
+  }
+
+  // Resets the payload and bumps the generation, which invalidates the
+  // handle and any heap entry for the node.
+  void release(uint32_t index) {
+    TimerNode &node = nodes[index];
+    node.payload = T();
+    node.generation++;
+    node.slot = FREE;
+    node.prev = NIL;
+    node.next = freeList;
+    freeList = index;
+  }
+
+  // Files the node by how far its deadline is from now: the lowest level
+  // whose slots cover every bit in which the deadline differs from now.
+  // That slot is always ahead of now within its level, so the node is
+  // reached before the level wraps.
+  void place(uint32_t index) {
+    TimerNode &node = nodes[index];
+    uint64_t diff = node.deadline ^ current;
+    if (diff >= RANGE) {
+      node.slot = FAR;
+      far.insert({node.deadline, index, node.generation});
+      farCount++;
+      return;
+    }
+
+    int level = 0;
+    while (diff >> (SLOT_BITS * (level + 1))) {
+      level++;
+    }
+    uint32_t digit = (node.deadline >> (SLOT_BITS * level)) & (SLOTS - 1);
+    uint32_t slot = level * SLOTS + digit;
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = slots[slot];
+    if (node.next != NIL)
+      nodes[node.next].prev = index;
+    slots[slot] = index;
+    wheelCount++;
+  }
+
+  void unlink(uint32_t index) {
+    TimerNode &node = nodes[index];
+    if (node.prev != NIL) {
+      nodes[node.prev].next = node.next;
+    } else {
+      slots[node.slot] = node.next;
+    }
+    if (node.next != NIL)
+      nodes[node.next].prev = node.prev;
+    wheelCount--;
+  }
+
+  // One step of time. At a multiple of 256^k ticks the level k slot for the
+  // new time is redistributed downwards, highest level first, and at a wrap
+  // of the top level the heap hands over the deadlines that now fit. Then
+  // the level 0 slot is due and its timers move into `expired`.
+  void tick() {
+    current++;
+    if ((current & (RANGE - 1)) == 0)
+      migrateFar();
+    for (int level = Levels - 1; level > 0; level--) {
+      uint64_t below = (uint64_t(1) << (SLOT_BITS * level)) - 1;
+      if ((current & below) == 0) {
+        uint32_t digit = (current >> (SLOT_BITS * level)) & (SLOTS - 1);
+        cascade(level * SLOTS + digit);
+      }
+    }
+
+    uint32_t &head = slots[current & (SLOTS - 1)];
+    for (uint32_t index = head; index != NIL;) {
+      uint32_t next = nodes[index].next;
+      expired.push_back(std::move(nodes[index].payload));
+      release(index);
+      wheelCount--;
+      index = next;
+    }
+    head = NIL;
+  }
+
+  void cascade(uint32_t slot) {
+    uint32_t index = slots[slot];
+    slots[slot] = NIL;
+    while (index != NIL) {
+      uint32_t next = nodes[index].next;
+      wheelCount--;
+      place(index);
+      index = next;
+    }
+  }
+
+  void migrateFar() {
+    while (!far.empty() && far.peek().deadline / RANGE == current / RANGE) {
+      FarTimer entry = far.popRoot();
+      if (nodes[entry.index].generation != entry.generation) {
+        staleFar--;
+        continue;
+      }
+      farCount--;
+      place(entry.index);
+    }
+  }
+
+  // Rebuilds the heap from its live entries in O(n). ThreadPool(1) runs
+  // the heapify inline.
+  void compactFar() {
+    std::vector<FarTimer> live;
+    live.reserve(farCount);
+    far.visitLevelOrder([&](const FarTimer &entry, int) {
+      if (nodes[entry.index].generation == entry.generation)
+        live.push_back(entry);
+    });
+    ThreadPool pool(1);
+    far.buildParallel(std::move(live), pool);
+    staleFar = 0;
+  }
+};
+
 int main() {
   MaxHeap<int> minHeap;
   minHeap.insert(5);
@@ -119,4 +671,35 @@ int main() {
   minHeap.insert(6);
   minHeap.insert(8);
   minHeap.print();
+
+  std::stringstream dump;
+  minHeap.serialize(dump);
+  MaxHeap<int> restored;
+  restored.deserialize(dump);
+  std::cout << "Restored root: " << restored.peek() << std::endl;
+  restored.print();
+
+  std::vector<int> values;
+  for (int i = 0; i < 100000; i++)
+    values.push_back((i * 7919) % 100000);
+  ThreadPool pool(4);
+  MinHeap<int> bulk;
+  bulk.buildParallel(values, pool);
+  std::cout << "Parallel heapify of " << bulk.size() << " values, root: "
+            << bulk.popRoot() << ", next: " << bulk.peek() << std::endl;
+
+  // Connection timeouts: most are cancelled by activity before they fire.
+  TimingWheel<int> timers;
+  TimingWheel<int>::TimerId first = timers.schedule(100, 1);
+  timers.schedule(100, 2);
+  timers.schedule(300, 3);
+  timers.schedule(uint64_t(1) << 40, 4); // beyond the wheels, kept in the heap
+  timers.cancel(first);
+  size_t fired = timers.advance(1000, [](int id) {
+    std::cout << "Timer " << id << " fired" << std::endl;
+  });
+  std::cout << "Fired " << fired << ", pending " << timers.size()
+            << ", cancel again: "
+            << (timers.cancel(first) ? "true" : "false") << std::endl;
+  return 0;
 }
\ No newline at end of file
@@ -0,0 +1,347 @@
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+// Link hook embedded in the user's type. The containers below never allocate
+// or copy: they splice the object itself through its hook, so an object can
+// sit in at most one container per hook at a time, and moving it from one
+// container to another is two O(1) pointer splices.
+template <typename T> struct ListHook {
+  T *next = nullptr;
+  T *prev = nullptr;
+};
+
+// LIFO list over objects owned by the caller, see Stack.
+template <typename T, ListHook<T> T::*Hook> class IntrusiveStack {
+public:
+  IntrusiveStack() {
+    head = nullptr;
+    size = 0;
+  }
+
+  // Each object has one hook, so the links cannot be copied. Moving hands
+  // the chain over and leaves other empty.
+  IntrusiveStack(const IntrusiveStack &) = delete;
+  IntrusiveStack &operator=(const IntrusiveStack &) = delete;
+
+  IntrusiveStack(IntrusiveStack &&other) noexcept : IntrusiveStack() {
+    swap(other);
+  }
+
+  IntrusiveStack &operator=(IntrusiveStack &&other) noexcept {
+    clear();
+    swap(other);
+    return *this;
+  }
+
+  ~IntrusiveStack() { clear(); }
+
+  void swap(IntrusiveStack &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(size, other.size);
+  }
+
+  void push(T &item) {
+    size++;
+    (item.*Hook).next = head;
+    head = &item;
+  }
+
+  T &pop() {
+    if (isEmpty()) {
+      throw std::runtime_error("Stack is empty");
+    }
+
+    size--;
+    T *item = head;
+    head = (item->*Hook).next;
+    (item->*Hook).next = nullptr;
+    return *item;
+  }
+
+  // Unlinks every object; the objects themselves are not touched otherwise.
+  void clear() {
+    while (!isEmpty()) {
+      pop();
+    }
+  }
+
+  bool isEmpty() const { return size == 0; }
+
+  int getSize() const { return size; }
+
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Stack (size=" << size << "): ";
+    for (T *current = head; current != nullptr;
+         current = (current->*Hook).next) {
+      buffer << *current << " ";
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+private:
+  T *head;
+  int size;
+};
+
+// FIFO list over objects owned by the caller, see Queue.
+template <typename T, ListHook<T> T::*Hook> class IntrusiveQueue {
+public:
+  IntrusiveQueue() {
+    head = nullptr;
+    tail = nullptr;
+    size = 0;
+  }
+
+  IntrusiveQueue(const IntrusiveQueue &) = delete;
+  IntrusiveQueue &operator=(const IntrusiveQueue &) = delete;
+
+  IntrusiveQueue(IntrusiveQueue &&other) noexcept : IntrusiveQueue() {
+    swap(other);
+  }
+
+  IntrusiveQueue &operator=(IntrusiveQueue &&other) noexcept {
+    clear();
+    swap(other);
+    return *this;
+  }
+
+  ~IntrusiveQueue() { clear(); }
+
+  void swap(IntrusiveQueue &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    std::swap(size, other.size);
+  }
+
+  void enqueue(T &item) {
+    size++;
+    (item.*Hook).next = nullptr;
+    if (tail == nullptr) {
+      head = tail = &item;
+    } else {
+      (tail->*Hook).next = &item;
+      tail = &item;
+    }
+  }
+
+  T &dequeue() {
+    if (size == 0) {
+      throw std::out_of_range("Queue is empty");
+    }
+
+    size--;
+    T *item = head;
+    head = (item->*Hook).next;
+    (item->*Hook).next = nullptr;
+
+    if (head == nullptr) {
+      tail = nullptr;
+    }
+
+    return *item;
+  }
+
+  void clear() {
+    while (!isEmpty()) {
+      dequeue();
+    }
+  }
+
+  bool isEmpty() const { return size == 0; }
+
+  int getSize() const { return size; }
+
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Queue (size=" << size << "): ";
+    for (T *current = head; current != nullptr;
+         current = (current->*Hook).next) {
+      buffer << *current << " ";
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+private:
+  T *head;
+  T *tail;
+  int size;
+};
+
+// Double-ended list over objects owned by the caller, see the deque Queue.
+// Being doubly linked, it can also unlink any object in O(1) with remove().
+template <typename T, ListHook<T> T::*Hook> class IntrusiveDeque {
+public:
+  IntrusiveDeque() {
+    head = nullptr;
+    tail = nullptr;
+    size = 0;
+  }
+
+  IntrusiveDeque(const IntrusiveDeque &) = delete;
+  IntrusiveDeque &operator=(const IntrusiveDeque &) = delete;
+
+  IntrusiveDeque(IntrusiveDeque &&other) noexcept : IntrusiveDeque() {
+    swap(other);
+  }
+
+  IntrusiveDeque &operator=(IntrusiveDeque &&other) noexcept {
+    clear();
+    swap(other);
+    return *this;
+  }
+
+  ~IntrusiveDeque() { clear(); }
+
+  void swap(IntrusiveDeque &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    std::swap(size, other.size);
+  }
+
+  void pushBack(T &item) {
+    (item.*Hook).next = nullptr;
+    (item.*Hook).prev = tail;
+    if (tail == nullptr) {
+      head = &item;
+    } else {
+      (tail->*Hook).next = &item;
+    }
+    tail = &item;
+    size++;
+  }
+
+  void pushForward(T &item) {
+    (item.*Hook).prev = nullptr;
+    (item.*Hook).next = head;
+    if (head == nullptr) {
+      tail = &item;
+    } else {
+      (head->*Hook).prev = &item;
+    }
+    head = &item;
+    size++;
+  }
+
+  T &popBack() {
+    if (tail == nullptr) {
+      throw std::runtime_error("Deque is empty");
+    }
+    T *item = tail;
+    remove(*item);
+    return *item;
+  }
+
+  T &popForward() {
+    if (head == nullptr) {
+      throw std::runtime_error("Deque is empty");
+    }
+    T *item = head;
+    remove(*item);
+    return *item;
+  }
+
+  // Unlinks item, which must currently be in this deque.
+  void remove(T &item) {
+    ListHook<T> &hook = item.*Hook;
+    if (hook.prev) {
+      (hook.prev->*Hook).next = hook.next;
+    } else {
+      head = hook.next;
+    }
+    if (hook.next) {
+      (hook.next->*Hook).prev = hook.prev;
+    } else {
+      tail = hook.prev;
+    }
+    hook.next = nullptr;
+    hook.prev = nullptr;
+    size--;
+  }
+
+  void clear() {
+    while (head != nullptr) {
+      popForward();
+    }
+  }
+
+  bool isEmpty() const { return size == 0; }
+
+  int getSize() const { return size; }
+
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Deque (size=" << size << "): ";
+    for (T *current = head; current != nullptr;
+         current = (current->*Hook).next) {
+      buffer << *current << " ";
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+private:
+  T *head;
+  T *tail;
+  int size;
+};
+
+struct Job {
+  int id;
+  ListHook<Job> link;
+
+  Job(int id) : id(id) {}
+};
+
+std::ostream &operator<<(std::ostream &out, const Job &job) {
+  return out << "#" << job.id;
+}
+
+int main() {
+  std::cout << "=== Intrusive Container Tests ===" << std::endl;
+
+  // The objects live in a caller-owned pool; containers only link them.
+  Job pool[] = {1, 2, 3, 4, 5};
+
+  std::cout << "\n1. Enqueue all jobs:" << std::endl;
+  IntrusiveQueue<Job, &Job::link> pending;
+  for (Job &job : pool)
+    pending.enqueue(job);
+  pending.print();
+
+  std::cout << "\n2. Move two jobs from queue to stack:" << std::endl;
+  IntrusiveStack<Job, &Job::link> running;
+  running.push(pending.dequeue());
+  running.push(pending.dequeue());
+  pending.print();
+  running.print();
+  std::cout << "Popped: " << running.pop() << std::endl;
+
+  std::cout << "\n3. Move the rest into a deque and unlink from the middle:"
+            << std::endl;
+  IntrusiveDeque<Job, &Job::link> done;
+  while (!pending.isEmpty())
+    done.pushBack(pending.dequeue());
+  done.pushForward(pool[1]);
+  done.print();
+  done.remove(pool[3]);
+  done.print();
+  std::cout << "popBack: " << done.popBack()
+            << ", popForward: " << done.popForward() << std::endl;
+  done.print();
+
+  std::cout << "\n4. Pop from empty stack (expect exception):" << std::endl;
+  running.clear();
+  try {
+    running.pop();
+  } catch (const std::exception &e) {
+    std::cout << "Caught exception: " << e.what() << std::endl;
+  }
+
+  std::cout << "\n=== All Intrusive tests completed ===" << std::endl;
+  return 0;
+}
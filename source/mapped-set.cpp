@@ -0,0 +1,172 @@
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+// Binary dump layout: header followed by `count` raw elements. Same layout as
+// AVLAbstract::serialize / BSTAbstract::serialize (magic "DSTR").
+struct DumpHeader {
+  char magic[4];
+  uint32_t elemSize;
+  uint64_t count;
+};
+
+// Read-only view of a tree dump mapped straight from disk (POSIX mmap).
+// Opening is O(1) regardless of file size; pages are loaded lazily by the OS
+// as lookups touch them.
+template <typename T, bool (*Comp)(const T &, const T &)>
+class MappedSet {
+public:
+  explicit MappedSet(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open tree dump");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(DumpHeader)) {
+      close(fd);
+      throw std::runtime_error("Invalid tree dump");
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      throw std::runtime_error("Cannot map tree dump");
+    }
+
+    const DumpHeader *header = static_cast<const DumpHeader *>(mapping);
+    if (std::memcmp(header->magic, "DSTR", 4) != 0 ||
+        header->elemSize != sizeof(T) ||
+        header->count > (length - sizeof(DumpHeader)) / sizeof(T)) {
+      munmap(mapping, length);
+      throw std::runtime_error("Invalid tree dump");
+    }
+
+    count = static_cast<size_t>(header->count);
+    data = reinterpret_cast<const T *>(static_cast<const char *>(mapping) +
+                                       sizeof(DumpHeader));
+  }
+
+  ~MappedSet() {
+    if (mapping)
+      munmap(mapping, length);
+  }
+
+  // One mapping has one owner: a set can be moved but not copied. A
+  // moved-from set is empty.
+  MappedSet(const MappedSet &) = delete;
+  MappedSet &operator=(const MappedSet &) = delete;
+
+  MappedSet(MappedSet &&other) noexcept {
+    mapping = other.mapping;
+    length = other.length;
+    data = other.data;
+    count = other.count;
+    other.mapping = nullptr;
+    other.length = 0;
+    other.data = nullptr;
+    other.count = 0;
+  }
+
+  MappedSet &operator=(MappedSet &&other) noexcept {
+    MappedSet moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  void swap(MappedSet &other) noexcept {
+    std::swap(mapping, other.mapping);
+    std::swap(length, other.length);
+    std::swap(data, other.data);
+    std::swap(count, other.count);
+  }
+
+  // Branchless lower bound over the sorted array.
+  const T *search(const T &val) const {
+    if (count == 0)
+      return nullptr;
+
+    const T *base = data;
+    size_t n = count;
+    while (n > 1) {
+      size_t half = n / 2;
+      base = Comp(base[half], val) ? base + half : base;
+      n -= half;
+    }
+    base += Comp(*base, val);
+
+    if (base == data + count || Comp(val, *base))
+      return nullptr;
+    return base;
+  }
+
+  int size() const { return static_cast<int>(count); }
+  bool empty() const { return count == 0; }
+
+private:
+  void *mapping;
+  size_t length;
+  const T *data;
+  size_t count;
+};
+
+template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }
+template <typename T> using MappedTreeSet = MappedSet<T, lessCompare<T>>;
+
+#include <cstdio>
+#include <fstream>
+
+int main() {
+  std::cout << "=== Mapped Set Test ===" << std::endl;
+
+  const char *path = "mapped-set-test.bin";
+
+  std::cout << "\n1. Writing dump with keys 0, 2, ..., 98" << std::endl;
+  {
+    int keys[50];
+    for (int i = 0; i < 50; i++)
+      keys[i] = 2 * i;
+    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(int), 50};
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(keys), sizeof(keys));
+  }
+
+  std::cout << "\n2. Mapping and searching:" << std::endl;
+  {
+    MappedTreeSet<int> set(path);
+    std::cout << "Size: " << set.size() << std::endl;
+    std::cout << "Search 42: "
+              << (set.search(42) != nullptr ? "Found" : "Not found")
+              << std::endl;
+    std::cout << "Search 43: "
+              << (set.search(43) != nullptr ? "Found" : "Not found")
+              << std::endl;
+    std::cout << "Search 100: "
+              << (set.search(100) != nullptr ? "Found" : "Not found")
+              << std::endl;
+
+    MappedTreeSet<int> owner = std::move(set);
+    std::cout << "After move: " << owner.size() << " keys, moved-from "
+              << (set.empty() ? "empty" : "not empty") << std::endl;
+  }
+
+  std::cout << "\n3. Mapping a missing file (expect exception):" << std::endl;
+  try {
+    MappedTreeSet<int> missing("does-not-exist.bin");
+  } catch (const std::exception &e) {
+    std::cout << "Caught exception: " << e.what() << std::endl;
+  }
+
+  std::remove(path);
+  std::cout << "\n=== Mapped Set Tests Completed ===" << std::endl;
+  return 0;
+}
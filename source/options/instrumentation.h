@@ -0,0 +1,24 @@
+#include <atomic>
+#include <iostream>
+
+// Process-wide counters summed over every container in the snippet: key
+// comparisons made through the comparator, and node allocations and frees.
+// Counting is relaxed-atomic, so instrumented containers stay usable from
+// several threads.
+struct Instrumentation {
+  static inline std::atomic<long long> comparisons{0};
+  static inline std::atomic<long long> allocations{0};
+  static inline std::atomic<long long> releases{0};
+
+  static void reset() {
+    comparisons = 0;
+    allocations = 0;
+    releases = 0;
+  }
+
+  static void print(std::ostream &out = std::cout) {
+    out << "comparisons: " << comparisons << ", allocations: " << allocations
+        << ", releases: " << releases << ", live nodes: "
+        << allocations - releases << std::endl;
+  }
+};
@@ -0,0 +1,29 @@
+#include <mutex>
+#include <utility>
+
+// Container behind a mutex. withLock(fn) runs fn(container) under the lock
+// and returns its result, so several calls made inside one fn happen as one
+// atomic step. Pointers and references into the container must not escape
+// fn.
+template <typename Container> class Locked {
+public:
+  template <typename... Args>
+  explicit Locked(Args &&...args) : container(std::forward<Args>(args)...) {}
+
+  Locked(const Locked &) = delete;
+  Locked &operator=(const Locked &) = delete;
+
+  template <typename Fn> auto withLock(Fn fn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fn(container);
+  }
+
+  template <typename Fn> auto withLock(Fn fn) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fn(static_cast<const Container &>(container));
+  }
+
+private:
+  mutable std::mutex mutex;
+  Container container;
+};
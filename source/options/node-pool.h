@@ -0,0 +1,73 @@
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+// Free-list allocator for one node size, hooked into Node by operator new
+// and delete. Nodes are carved from blocks of BLOCK_NODES and recycled
+// through an intrusive free list, so steady-state inserts and removes never
+// reach malloc. Blocks are kept for the life of the program. With
+// ThreadSafe the list is guarded by a mutex; otherwise the pool must only be
+// used from one thread.
+template <size_t Size, size_t Align, bool ThreadSafe> class NodePool {
+public:
+  static void *allocate() {
+    State &s = state();
+    std::unique_lock<std::mutex> lock(s.mutex, std::defer_lock);
+    if (ThreadSafe)
+      lock.lock();
+    if (s.free == nullptr)
+      refill(s);
+    FreeSlot *slot = s.free;
+    s.free = slot->next;
+    return slot;
+  }
+
+  static void release(void *p) {
+    State &s = state();
+    std::unique_lock<std::mutex> lock(s.mutex, std::defer_lock);
+    if (ThreadSafe)
+      lock.lock();
+    FreeSlot *slot = static_cast<FreeSlot *>(p);
+    slot->next = s.free;
+    s.free = slot;
+  }
+
+private:
+  static_assert(Align <= alignof(std::max_align_t),
+                "NodePool does not support over-aligned nodes");
+
+  static const size_t BLOCK_NODES = 1024;
+
+  struct FreeSlot {
+    FreeSlot *next;
+  };
+
+  // Slot stride: large enough for a node or a free-list link, and a
+  // multiple of the fundamental alignment.
+  static const size_t SLOT =
+      ((Size > sizeof(FreeSlot) ? Size : sizeof(FreeSlot)) +
+       alignof(std::max_align_t) - 1) /
+      alignof(std::max_align_t) * alignof(std::max_align_t);
+
+  struct State {
+    FreeSlot *free = nullptr;
+    std::mutex mutex;
+  };
+
+  // Never destroyed, so nodes freed by static containers at exit still
+  // find the pool.
+  static State &state() {
+    static State *s = new State;
+    return *s;
+  }
+
+  static void refill(State &s) {
+    unsigned char *block =
+        static_cast<unsigned char *>(::operator new(SLOT * BLOCK_NODES));
+    for (size_t i = BLOCK_NODES; i-- > 0;) {
+      FreeSlot *slot = reinterpret_cast<FreeSlot *>(block + i * SLOT);
+      slot->next = s.free;
+      s.free = slot;
+    }
+  }
+};
@@ -0,0 +1,319 @@
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T>
+struct Node {
+  T val;
+  std::shared_ptr<const Node> left;
+  std::shared_ptr<const Node> right;
+  int height = 1;
+
+  Node(T v, std::shared_ptr<const Node> l, std::shared_ptr<const Node> r)
+      : val(std::move(v)), left(std::move(l)), right(std::move(r)) {
+    int hl = left ? left->height : 0;
+    int hr = right ? right->height : 0;
+    height = std::max(hl, hr) + 1;
+  }
+};
+
+// Persistent AVL tree. Nodes are immutable and shared between versions:
+// insert/remove copy only the O(log n) nodes on the search path and return a
+// new version, so copying a tree is an O(1) snapshot and the implicit copy
+// and move operations are already cheap and safe. Unreachable nodes are
+// freed by reference counting when the last version using them goes away.
+template <typename T, bool (*Comp)(const T &, const T &)>
+class PersistentAVLAbstract {
+public:
+  using NodePtr = std::shared_ptr<const Node<T>>;
+
+  PersistentAVLAbstract() { root = nullptr; }
+
+  // If val is already present, returns the same version without copying.
+  PersistentAVLAbstract insert(const T &val) const {
+    bool inserted = false;
+    return PersistentAVLAbstract(insertNode(root, val, inserted));
+  }
+  PersistentAVLAbstract insert(T &&val) const {
+    bool inserted = false;
+    return PersistentAVLAbstract(insertNode(root, std::move(val), inserted));
+  }
+  const T *search(const T &val) const { return searchNode(root.get(), val); }
+  PersistentAVLAbstract remove(const T &val) const {
+    bool removed = false;
+    return remove(val, removed);
+  }
+  PersistentAVLAbstract remove(const T &val, bool &removed) const {
+    removed = false;
+    NodePtr newRoot = removeNode(root, val, removed);
+    return removed ? PersistentAVLAbstract(newRoot) : *this;
+  }
+
+  bool empty() const { return root == nullptr; }
+
+  void swap(PersistentAVLAbstract &other) noexcept { root.swap(other.root); }
+
+  // Thread-safe hand-off of versions between threads. A writer builds the
+  // next version from snapshot() and publishes it; readers call snapshot()
+  // and work on their own copy. Each call copies one shared_ptr atomically.
+  // That is not lock-free in common standard libraries (libstdc++ guards it
+  // with a small mutex pool), but the guard is never held during a search
+  // or an update. C++20 deprecates these functions in favour of
+  // std::atomic<std::shared_ptr>, which would make root non-copyable. With
+  // several writers, updates must be serialized among the writers. Other
+  // methods must not be called on an object that is being published to.
+  void publish(const PersistentAVLAbstract &version) {
+    std::atomic_store(&root, version.root);
+  }
+
+  PersistentAVLAbstract snapshot() const {
+    return PersistentAVLAbstract(std::atomic_load(&root));
+  }
+
+  // Formats the whole tree into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    std::vector<std::pair<const Node<T> *, int>> stack;
+    const Node<T> *node = root.get();
+    int depth = 0;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back({node, depth});
+        node = node->right.get();
+        depth++;
+      }
+      node = stack.back().first;
+      depth = stack.back().second;
+      stack.pop_back();
+
+      for (int i = 0; i < depth; i++) {
+        buffer << "   ";
+      }
+      buffer << node->val << '\n';
+
+      node = node->left.get();
+      depth++;
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(val) for every key in sorted order, without recursion.
+  template <typename Fn> void visitInOrder(Fn fn) const {
+    std::vector<const Node<T> *> stack;
+    const Node<T> *node = root.get();
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back(node);
+        node = node->left.get();
+      }
+      node = stack.back();
+      stack.pop_back();
+      fn(node->val);
+      node = node->right.get();
+    }
+  }
+
+  // Calls fn(val, depth) level by level, root first.
+  template <typename Fn> void visitLevelOrder(Fn fn) const {
+    std::vector<std::pair<const Node<T> *, int>> level;
+    if (root)
+      level.push_back({root.get(), 0});
+    for (size_t i = 0; i < level.size(); i++) {
+      const Node<T> *node = level[i].first;
+      int depth = level[i].second;
+      fn(node->val, depth);
+      if (node->left)
+        level.push_back({node->left.get(), depth + 1});
+      if (node->right)
+        level.push_back({node->right.get(), depth + 1});
+    }
+  }
+
+private:
+  NodePtr root;
+
+  explicit PersistentAVLAbstract(NodePtr r) : root(std::move(r)) {}
+
+  static int compare(const T &a, const T &b) {
+    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);
+  }
+
+  static int getHeight(const NodePtr &node) { return node ? node->height : 0; }
+
+  static NodePtr makeNode(T val, NodePtr left, NodePtr right) {
+    return std::make_shared<const Node<T>>(std::move(val), std::move(left),
+                                           std::move(right));
+  }
+
+  // Builds a new node from val and two subtrees, rotating if they differ in
+  // height by 2. Rotations allocate fresh nodes instead of relinking.
+  static NodePtr balanceNode(T val, NodePtr left, NodePtr right) {
+    int hl = getHeight(left);
+    int hr = getHeight(right);
+
+    if (hl > hr + 1) {
+      // LL
+      if (getHeight(left->left) >= getHeight(left->right)) {
+        return makeNode(left->val, left->left,
+                        makeNode(val, left->right, std::move(right)));
+      }
+      // LR
+      const Node<T> *lr = left->right.get();
+      return makeNode(lr->val, makeNode(left->val, left->left, lr->left),
+                      makeNode(val, lr->right, std::move(right)));
+    }
+
+    if (hr > hl + 1) {
+      // RR
+      if (getHeight(right->right) >= getHeight(right->left)) {
+        return makeNode(right->val,
+                        makeNode(val, std::move(left), right->left),
+                        right->right);
+      }
+      // RL
+      const Node<T> *rl = right->left.get();
+      return makeNode(rl->val, makeNode(val, std::move(left), rl->left),
+                      makeNode(right->val, rl->right, right->right));
+    }
+
+    return makeNode(std::move(val), std::move(left), std::move(right));
+  }
+
+  // U is T or const T&; val is moved into the new leaf. Path nodes are
+  // still copied, as every version needs its own, unless the key was
+  // already there: then the original nodes are returned, like removeNode.
+  template <typename U>
+  static NodePtr insertNode(const NodePtr &node, U &&val, bool &inserted) {
+    if (!node) {
+      inserted = true;
+      return makeNode(std::forward<U>(val), nullptr, nullptr);
+    }
+
+    int r = compare(val, node->val);
+    if (r < 0) {
+      NodePtr left = insertNode(node->left, std::forward<U>(val), inserted);
+      return inserted ? balanceNode(node->val, left, node->right) : node;
+    } else if (r > 0) {
+      NodePtr right = insertNode(node->right, std::forward<U>(val), inserted);
+      return inserted ? balanceNode(node->val, node->left, right) : node;
+    }
+    return node;
+  }
+
+  static const T *searchNode(const Node<T> *node, const T &val) {
+    while (node) {
+      int r = compare(val, node->val);
+      if (r < 0)
+        node = node->left.get();
+      else if (r > 0)
+        node = node->right.get();
+      else
+        return &(node->val);
+    }
+    return nullptr;
+  }
+
+  static NodePtr removeMin(const NodePtr &node, T &minVal) {
+    if (!node->left) {
+      minVal = node->val;
+      return node->right;
+    }
+    return balanceNode(node->val, removeMin(node->left, minVal), node->right);
+  }
+
+  static NodePtr removeNode(const NodePtr &node, const T &val,
+                            bool &removed) {
+    if (!node) {
+      return nullptr;
+    }
+
+    int r = compare(val, node->val);
+    if (r < 0) {
+      NodePtr left = removeNode(node->left, val, removed);
+      return removed ? balanceNode(node->val, left, node->right) : node;
+    } else if (r > 0) {
+      NodePtr right = removeNode(node->right, val, removed);
+      return removed ? balanceNode(node->val, node->left, right) : node;
+    }
+
+    removed = true;
+    if (!node->left)
+      return node->right;
+    if (!node->right)
+      return node->left;
+
+    T successor = node->val;
+    NodePtr right = removeMin(node->right, successor);
+    return balanceNode(successor, node->left, right);
+  }
+};
+
+template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }
+template <typename T>
+using PersistentAVLTree = PersistentAVLAbstract<T, lessCompare<T>>;
+
+int main() {
+  std::cout << "=== Persistent AVL Test ===" << std::endl;
+
+  PersistentAVLTree<int> v0;
+
+  std::cout << "\n1. Building v1 by inserting 1..7 into v0:" << std::endl;
+  PersistentAVLTree<int> v1 = v0;
+  for (int i = 1; i <= 7; ++i) {
+    v1 = v1.insert(i);
+  }
+  v1.print();
+  std::cout << "v0 empty: " << (v0.empty() ? "true" : "false") << std::endl;
+
+  std::cout << "\n2. Snapshot of v1, then v2 = v1 + 8, 9:" << std::endl;
+  PersistentAVLTree<int> snapshot = v1;
+  PersistentAVLTree<int> v2 = v1.insert(8).insert(9);
+  v2.print();
+  std::cout << "Search 9 in snapshot: "
+            << (snapshot.search(9) != nullptr ? "Found"
+                                              : "Not found (expected)")
+            << std::endl;
+  std::cout << "Search 9 in v2: "
+            << (v2.search(9) != nullptr ? "Found" : "Not found") << std::endl;
+
+  std::cout << "\n3. v3 = v2 - 4 (node with two children):" << std::endl;
+  bool removed = false;
+  PersistentAVLTree<int> v3 = v2.remove(4, removed);
+  v3.print();
+  std::cout << "Removed: " << (removed ? "true" : "false") << std::endl;
+  std::cout << "Search 4 in v2: "
+            << (v2.search(4) != nullptr ? "Found (expected)" : "Not found")
+            << std::endl;
+
+  std::cout << "\n4. Removing non-existent element (100):" << std::endl;
+  v3.remove(100, removed);
+  std::cout << "Result: " << (removed ? "Success" : "Failed (expected)")
+            << std::endl;
+
+  std::cout << "\n5. Snapshot still unchanged:" << std::endl;
+  snapshot.print();
+
+  std::cout << "\n6. Publishing versions to a reader thread:" << std::endl;
+  PersistentAVLTree<int> current;
+  std::thread reader([&current] {
+    int seen = 0;
+    while (seen < 100) {
+      PersistentAVLTree<int> view = current.snapshot();
+      seen = 0;
+      while (view.search(seen + 1) != nullptr)
+        seen++;
+    }
+  });
+  for (int i = 1; i <= 100; ++i) {
+    current.publish(current.snapshot().insert(i));
+  }
+  reader.join();
+  std::cout << "Reader saw all 100 keys" << std::endl;
+
+  std::cout << "\n=== All Persistent AVL tests completed ===" << std::endl;
+  return 0;
+}
@@ -1,10 +1,26 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 
 template <typename T> struct Node {
   T data;
   Node<T> *next;
 
-  Node(T data, Node<T> *next = nullptr) : data(data), next(next) {}
+  Node(T data, Node<T> *next = nullptr) : data(std::move(data)), next(next) {}
 };
 
 template <typename T> class Queue {
@@ -15,33 +31,50 @@ public:
     size = 0;
   }
 
-  ~Queue() {
-    Node<T> *current = this->head;
-    while (current != nullptr) {
-      Node<T> *next = current->next;
-      delete current;
-      current = next;
+  // Deep copy in the same order.
+  Queue(const Queue &other) : Queue() {
+    try {
+      other.visit([this](const T &data) { enqueue(data); });
+    } catch (...) {
+      clear();
+      throw;
     }
   }
 
-  void enqueue(T data) {
-    size++;
-    Node<T> *node = new Node<T>(data);
-    if (tail == nullptr) {
-      head = tail = node;
-    } else {
-      tail->next = node;
-      tail = node;
-    }
+  Queue(Queue &&other) noexcept {
+    head = other.head;
+    tail = other.tail;
+    size = other.size;
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.size = 0;
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  Queue &operator=(Queue other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~Queue() { clear(); }
+
+  void swap(Queue &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    std::swap(size, other.size);
   }
 
+  void enqueue(const T &data) { link(new Node<T>(data)); }
+
+  void enqueue(T &&data) { link(new Node<T>(std::move(data))); }
+
   T dequeue() {
     if (size == 0) {
       throw std::out_of_range("Queue is empty");
     }
 
     size--;
-    T data = head->data;
+    T data = std::move(head->data);
     Node<T> *oldHead = head;
     head = head->next;
     delete oldHead;
@@ -53,26 +86,397 @@ public:
     return data;
   }
 
+  void clear() {
+    while (head != nullptr) {
+      Node<T> *next = head->next;
+      delete head;
+      head = next;
+    }
+    tail = nullptr;
+    size = 0;
+  }
+
   bool isEmpty() { return size == 0; }
 
   int getSize() { return size; }
 
-  void print() {
-    Node<T> *current = head;
-    std::cout << "Queue (size=" << size << "): ";
-    while (current != nullptr) {
-      std::cout << current->data << " ";
-      current = current->next;
+  // Formats all elements into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Queue (size=" << size << "): ";
+    visit([&buffer](const T &data) { buffer << data << " "; });
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(data) for every element from front to back.
+  template <typename Fn> void visit(Fn fn) const {
+    for (Node<T> *current = head; current != nullptr;
+         current = current->next) {
+      fn(current->data);
     }
-    std::cout << std::endl;
   }
 
 private:
   Node<T> *head;
   Node<T> *tail;
   int size;
+
+  void link(Node<T> *node) {
+    size++;
+    if (tail == nullptr) {
+      head = tail = node;
+    } else {
+      tail->next = node;
+      tail = node;
+    }
+  }
 };
 
+// Hint to the CPU that we are in a spin-wait loop.
+inline void cpuRelax() {
+#if defined(__SSE2__)
+  _mm_pause();
+#endif
+}
+
+// Bounded thread-safe queue on top of Queue. Producers block while it is full
+// and consumers block while it is empty. A waiter first spins for a moment on
+// the lock-free size, then parks on a condition variable (a futex on Linux).
+// The other side only pays for a wakeup when somebody is actually parked.
+template <typename T> class BlockingQueue {
+public:
+  explicit BlockingQueue(int capacity) {
+    if (capacity <= 0) {
+      throw std::invalid_argument("Capacity must be positive");
+    }
+    this->capacity = capacity;
+    count = 0;
+    closed = false;
+    waitingPush = 0;
+    waitingPop = 0;
+  }
+
+  // Parked threads and coroutines point into the queue, so it can be
+  // neither copied nor moved.
+  BlockingQueue(const BlockingQueue &) = delete;
+  BlockingQueue &operator=(const BlockingQueue &) = delete;
+
+  // Blocks while the queue is full. Throws once the queue is closed.
+  void push(T data) {
+    if (!pushWait(data, false, {})) {
+      throw std::runtime_error("Queue is closed");
+    }
+  }
+
+  // Returns false instead of blocking when the queue is full or closed.
+  bool tryPush(T data) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closed || items.getSize() >= capacity)
+      return false;
+    putLocked(lock, data);
+    return true;
+  }
+
+  // Waits at most timeout for a free slot.
+  bool tryPush(T data, std::chrono::nanoseconds timeout) {
+    return pushWait(data, true, std::chrono::steady_clock::now() + timeout);
+  }
+
+  // Pushes every element, blocking whenever the queue is full. Consumers are
+  // woken once per run of elements that fit, not once per element.
+  void pushAll(const std::vector<T> &data) {
+    size_t next = 0;
+    while (next < data.size()) {
+      spinUntil([this] {
+        return count.load(std::memory_order_relaxed) < capacity ||
+               closed.load(std::memory_order_relaxed);
+      });
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!closed && items.getSize() >= capacity) {
+        park(notFull, lock, waitingPush, false, {});
+      }
+      if (closed) {
+        throw std::runtime_error("Queue is closed");
+      }
+
+#if defined(__cpp_impl_coroutine)
+      if (!asyncWaiters.isEmpty()) {
+        T item = data[next++];
+        putLocked(lock, item);
+        continue;
+      }
+#endif
+
+      int added = 0;
+      while (next < data.size() && items.getSize() < capacity) {
+        items.enqueue(data[next++]);
+        added++;
+      }
+      count.store(items.getSize(), std::memory_order_relaxed);
+      int wake = std::min(added, waitingPop);
+      lock.unlock();
+      wakeUp(notEmpty, wake);
+    }
+  }
+
+  // Blocks while the queue is empty. Throws once the queue is closed and
+  // drained.
+  T pop() {
+    std::optional<T> data;
+    if (!popWait(data, false, {})) {
+      throw std::out_of_range("Queue is closed");
+    }
+    return std::move(*data);
+  }
+
+  // Returns false instead of blocking when the queue is empty.
+  bool tryPop(T &data) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (items.isEmpty())
+      return false;
+    data = takeLocked(lock);
+    return true;
+  }
+
+  // Waits at most timeout for an element.
+  bool tryPop(T &data, std::chrono::nanoseconds timeout) {
+    std::optional<T> item;
+    if (!popWait(item, true, std::chrono::steady_clock::now() + timeout))
+      return false;
+    data = std::move(*item);
+    return true;
+  }
+
+  // Waits for at least one element, then moves up to max elements into out.
+  // Returns how many were taken, 0 once the queue is closed and drained.
+  int popBatch(std::vector<T> &out, int max) {
+    spinUntil([this] {
+      return count.load(std::memory_order_relaxed) > 0 ||
+             closed.load(std::memory_order_relaxed);
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!closed && items.isEmpty()) {
+      park(notEmpty, lock, waitingPop, false, {});
+    }
+
+    int taken = 0;
+    while (taken < max && !items.isEmpty()) {
+      out.push_back(items.dequeue());
+      taken++;
+    }
+    count.store(items.getSize(), std::memory_order_relaxed);
+    int wake = std::min(taken, waitingPush);
+    lock.unlock();
+    wakeUp(notFull, wake);
+    return taken;
+  }
+
+  // Wakes every waiter. Pushes fail from now on; pops drain what is left and
+  // then fail.
+  void close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+#if defined(__cpp_impl_coroutine)
+    std::vector<PopAwaiter *> waiters;
+    while (!asyncWaiters.isEmpty()) {
+      waiters.push_back(asyncWaiters.dequeue());
+    }
+#endif
+    lock.unlock();
+    notEmpty.notify_all();
+    notFull.notify_all();
+#if defined(__cpp_impl_coroutine)
+    for (PopAwaiter *waiter : waiters) {
+      waiter->handle.resume();
+    }
+#endif
+  }
+
+  bool isClosed() const { return closed.load(); }
+
+  int getSize() const { return count.load(std::memory_order_relaxed); }
+
+  int getCapacity() const { return capacity; }
+
+#if defined(__cpp_impl_coroutine)
+  class PopAwaiter {
+  public:
+    explicit PopAwaiter(BlockingQueue *queue) : queue(queue) {}
+
+    bool await_ready() { return false; }
+
+    // Takes an element right away if there is one. Otherwise registers the
+    // coroutine while still holding the lock, so a concurrent push cannot
+    // slip in between the check and the registration.
+    bool await_suspend(std::coroutine_handle<> h) {
+      std::unique_lock<std::mutex> lock(queue->mutex);
+      if (!queue->items.isEmpty()) {
+        data = queue->takeLocked(lock);
+        return false;
+      }
+      if (queue->closed)
+        return false;
+      handle = h;
+      queue->asyncWaiters.enqueue(this);
+      return true;
+    }
+
+    T await_resume() {
+      if (!data) {
+        throw std::out_of_range("Queue is closed");
+      }
+      return std::move(*data);
+    }
+
+  private:
+    friend class BlockingQueue;
+
+    BlockingQueue *queue;
+    std::coroutine_handle<> handle;
+    std::optional<T> data;
+  };
+
+  // `co_await queue.popAsync()` suspends the coroutine instead of blocking
+  // the thread. The pushing thread hands over the element and resumes the
+  // coroutine. Throws like pop() once the queue is closed and drained; call
+  // close() before destroying a queue that coroutines may still wait on.
+  PopAwaiter popAsync() { return PopAwaiter(this); }
+#endif
+
+private:
+  static const int SPIN_COUNT = 256;
+
+  Queue<T> items;
+  int capacity;
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::atomic<int> count; // items.getSize(), readable without the lock
+  std::atomic<bool> closed;
+  int waitingPush;
+  int waitingPop;
+#if defined(__cpp_impl_coroutine)
+  Queue<PopAwaiter *> asyncWaiters;
+#endif
+
+  template <typename Pred> static void spinUntil(Pred ready) {
+    for (int i = 0; i < SPIN_COUNT && !ready(); i++) {
+      cpuRelax();
+    }
+  }
+
+  // Waits on cv with the lock held. Returns false on timeout.
+  static bool park(std::condition_variable &cv,
+                   std::unique_lock<std::mutex> &lock, int &waiting,
+                   bool timed, std::chrono::steady_clock::time_point deadline) {
+    waiting++;
+    bool woken = true;
+    if (timed) {
+      woken = cv.wait_until(lock, deadline) == std::cv_status::no_timeout;
+    } else {
+      cv.wait(lock);
+    }
+    waiting--;
+    return woken;
+  }
+
+  static void wakeUp(std::condition_variable &cv, int waiters) {
+    if (waiters > 1) {
+      cv.notify_all();
+    } else if (waiters == 1) {
+      cv.notify_one();
+    }
+  }
+
+  bool pushWait(T &data, bool timed,
+                std::chrono::steady_clock::time_point deadline) {
+    spinUntil([this] {
+      return count.load(std::memory_order_relaxed) < capacity ||
+             closed.load(std::memory_order_relaxed);
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!closed && items.getSize() >= capacity) {
+      if (!park(notFull, lock, waitingPush, timed, deadline))
+        break;
+    }
+    if (closed || items.getSize() >= capacity)
+      return false;
+    putLocked(lock, data);
+    return true;
+  }
+
+  bool popWait(std::optional<T> &data, bool timed,
+               std::chrono::steady_clock::time_point deadline) {
+    spinUntil([this] {
+      return count.load(std::memory_order_relaxed) > 0 ||
+             closed.load(std::memory_order_relaxed);
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!closed && items.isEmpty()) {
+      if (!park(notEmpty, lock, waitingPop, timed, deadline))
+        break;
+    }
+    if (items.isEmpty())
+      return false;
+    data = takeLocked(lock);
+    return true;
+  }
+
+  // Hands data to a suspended coroutine if one is waiting, otherwise queues
+  // it and wakes one parked consumer. Releases the lock.
+  void putLocked(std::unique_lock<std::mutex> &lock, T &data) {
+#if defined(__cpp_impl_coroutine)
+    if (!asyncWaiters.isEmpty()) {
+      PopAwaiter *waiter = asyncWaiters.dequeue();
+      waiter->data = std::move(data);
+      lock.unlock();
+      waiter->handle.resume();
+      return;
+    }
+#endif
+    items.enqueue(std::move(data));
+    count.store(items.getSize(), std::memory_order_relaxed);
+    int wake = std::min(1, waitingPop);
+    lock.unlock();
+    wakeUp(notEmpty, wake);
+  }
+
+  // Dequeues one element and wakes one parked producer. Releases the lock.
+  T takeLocked(std::unique_lock<std::mutex> &lock) {
+    T data = items.dequeue();
+    count.store(items.getSize(), std::memory_order_relaxed);
+    int wake = std::min(1, waitingPush);
+    lock.unlock();
+    wakeUp(notFull, wake);
+    return data;
+  }
+};
+
+#include <thread>
+
+#if defined(__cpp_impl_coroutine)
+// Minimal fire-and-forget coroutine type for the demo.
+struct Task {
+  struct promise_type {
+    Task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+Task consume(BlockingQueue<int> &queue, std::vector<int> &seen) {
+  try {
+    for (;;) {
+      seen.push_back(co_await queue.popAsync());
+    }
+  } catch (const std::out_of_range &) {
+  }
+}
+#endif
+
 int main() {
   std::cout << "=== Queue Tests ===" << std::endl;
 
@@ -118,6 +522,72 @@ int main() {
     std::cout << "Caught exception: " << e.what() << std::endl;
   }
 
+  std::cout << "\nTest 7: copy, move and swap" << std::endl;
+  q.enqueue(1);
+  q.enqueue(2);
+  Queue<int> copy = q;
+  copy.enqueue(3);
+  Queue<int> moved = std::move(copy);
+  moved.swap(q);
+  q.print();
+  moved.print();
+
+  std::cout << "\nTest 8: blocking queue, capacity 2, producer pushes 1..6"
+            << std::endl;
+  BlockingQueue<int> bq(2);
+  std::thread producer([&bq] {
+    for (int i = 1; i <= 6; i++) {
+      bq.push(i);
+    }
+  });
+  std::vector<int> received;
+  while (received.size() < 6) {
+    bq.popBatch(received, 4);
+  }
+  producer.join();
+  std::cout << "received:";
+  for (int x : received)
+    std::cout << " " << x;
+  std::cout << std::endl;
+
+  std::cout << "\nTest 9: tryPop with 10ms timeout on empty queue" << std::endl;
+  int value = 0;
+  bool got = bq.tryPop(value, std::chrono::milliseconds(10));
+  std::cout << "tryPop(): " << (got ? "true" : "false (expected)") << std::endl;
+
+  std::cout << "\nTest 10: tryPush on full queue" << std::endl;
+  bq.push(7);
+  bq.push(8);
+  std::cout << "tryPush(9): " << (bq.tryPush(9) ? "true" : "false (expected)")
+            << std::endl;
+
+  std::cout << "\nTest 11: close, drain, then pop (expect exception)"
+            << std::endl;
+  bq.close();
+  std::cout << "pop(): " << bq.pop() << std::endl;
+  std::cout << "pop(): " << bq.pop() << std::endl;
+  try {
+    bq.pop();
+  } catch (const std::exception &e) {
+    std::cout << "Caught exception: " << e.what() << std::endl;
+  }
+
+#if defined(__cpp_impl_coroutine)
+  std::cout << "\nTest 12: coroutine consumer with co_await popAsync()"
+            << std::endl;
+  BlockingQueue<int> cq(4);
+  std::vector<int> seen;
+  consume(cq, seen);
+  for (int i = 1; i <= 3; i++) {
+    cq.push(i * 10);
+  }
+  cq.close();
+  std::cout << "seen:";
+  for (int x : seen)
+    std::cout << " " << x;
+  std::cout << std::endl;
+#endif
+
   std::cout << "\n=== Queue Tests Completed ===" << std::endl;
   return 0;
 }
\ No newline at end of file
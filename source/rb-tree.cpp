@@ -0,0 +1,441 @@
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+template <typename T>
+struct Node {
+  T val;
+  Node *left = nullptr;
+  Node *right = nullptr;
+  Node *parent = nullptr;
+  bool red = true;
+
+  Node(T v) : val(std::move(v)) {}
+};
+
+// Red-black tree with the same interface as AVLAbstract. Insert does at most
+// 2 rotations and remove at most 3, recoloring is the only O(log n) work.
+template <typename T, bool (*Comp)(const T &, const T &)>
+class RBAbstract {
+public:
+  RBAbstract() { root = nullptr; }
+
+  // Deep copy with the same shape and colors as other, see cloneTree.
+  RBAbstract(const RBAbstract &other) { root = cloneTree(other.root); }
+
+  RBAbstract(RBAbstract &&other) noexcept {
+    root = other.root;
+    other.root = nullptr;
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  RBAbstract &operator=(RBAbstract other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~RBAbstract() { clear(root); }
+
+  void swap(RBAbstract &other) noexcept { std::swap(root, other.root); }
+
+  // Returns false if an equal key was already present.
+  bool insert(const T &val) { return insertNode(val); }
+  bool insert(T &&val) { return insertNode(std::move(val)); }
+  T *search(const T &val) {
+    Node<T> *node = findNode(val);
+    return node ? &(node->val) : nullptr;
+  }
+  bool remove(const T &val) {
+    Node<T> *node = findNode(val);
+    if (!node)
+      return false;
+    removeNode(node);
+    return true;
+  }
+  void clear() {
+    clear(root);
+    root = nullptr;
+  }
+
+  // Formats the whole tree into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    std::vector<std::pair<Node<T> *, int>> stack;
+    Node<T> *node = root;
+    int depth = 0;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back({node, depth});
+        node = node->right;
+        depth++;
+      }
+      node = stack.back().first;
+      depth = stack.back().second;
+      stack.pop_back();
+
+      for (int i = 0; i < depth; i++) {
+        buffer << "   ";
+      }
+      buffer << node->val << (node->red ? "r" : "b") << '\n';
+
+      node = node->left;
+      depth++;
+    }
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(val) for every key in sorted order, without recursion.
+  template <typename Fn> void visitInOrder(Fn fn) const {
+    std::vector<Node<T> *> stack;
+    Node<T> *node = root;
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back(node);
+        node = node->left;
+      }
+      node = stack.back();
+      stack.pop_back();
+      fn(node->val);
+      node = node->right;
+    }
+  }
+
+  // Calls fn(val, depth) level by level, root first.
+  template <typename Fn> void visitLevelOrder(Fn fn) const {
+    std::vector<std::pair<Node<T> *, int>> level;
+    if (root)
+      level.push_back({root, 0});
+    for (size_t i = 0; i < level.size(); i++) {
+      Node<T> *node = level[i].first;
+      int depth = level[i].second;
+      fn(node->val, depth);
+      if (node->left)
+        level.push_back({node->left, depth + 1});
+      if (node->right)
+        level.push_back({node->right, depth + 1});
+    }
+  }
+
+private:
+  Node<T> *root;
+
+  static int compare(const T &a, const T &b) {
+    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);
+  }
+
+  bool isRed(Node<T> *node) { return node && node->red; }
+
+  void replaceChild(Node<T> *parent, Node<T> *oldChild, Node<T> *newChild) {
+    if (!parent) {
+      root = newChild;
+    } else if (parent->left == oldChild) {
+      parent->left = newChild;
+    } else {
+      parent->right = newChild;
+    }
+    if (newChild)
+      newChild->parent = parent;
+  }
+
+  void rotateLeft(Node<T> *x) {
+    Node<T> *y = x->right;
+    x->right = y->left;
+    if (y->left)
+      y->left->parent = x;
+    replaceChild(x->parent, x, y);
+    y->left = x;
+    x->parent = y;
+  }
+
+  void rotateRight(Node<T> *y) {
+    Node<T> *x = y->left;
+    y->left = x->right;
+    if (x->right)
+      x->right->parent = y;
+    replaceChild(y->parent, y, x);
+    x->right = y;
+    y->parent = x;
+  }
+
+  Node<T> *findNode(const T &val) {
+    Node<T> *node = root;
+    while (node) {
+      int r = compare(val, node->val);
+      if (r < 0)
+        node = node->left;
+      else if (r > 0)
+        node = node->right;
+      else
+        return node;
+    }
+    return nullptr;
+  }
+
+  // U is T or const T&; val is moved into the new node.
+  template <typename U> bool insertNode(U &&val) {
+    Node<T> *parent = nullptr;
+    Node<T> *cur = root;
+    int r = 0;
+    while (cur) {
+      r = compare(val, cur->val);
+      if (r == 0)
+        return false;
+      parent = cur;
+      cur = r < 0 ? cur->left : cur->right;
+    }
+
+    Node<T> *node = new Node<T>(std::forward<U>(val));
+    node->parent = parent;
+    if (!parent)
+      root = node;
+    else if (r < 0)
+      parent->left = node;
+    else
+      parent->right = node;
+
+    insertFixup(node);
+    return true;
+  }
+
+  void insertFixup(Node<T> *node) {
+    while (isRed(node->parent)) {
+      Node<T> *parent = node->parent;
+      Node<T> *grand = parent->parent;
+
+      if (parent == grand->left) {
+        Node<T> *uncle = grand->right;
+        if (isRed(uncle)) {
+          parent->red = false;
+          uncle->red = false;
+          grand->red = true;
+          node = grand;
+          continue;
+        }
+        if (node == parent->right) {
+          rotateLeft(parent);
+          node = parent;
+          parent = node->parent;
+        }
+        parent->red = false;
+        grand->red = true;
+        rotateRight(grand);
+      } else {
+        Node<T> *uncle = grand->left;
+        if (isRed(uncle)) {
+          parent->red = false;
+          uncle->red = false;
+          grand->red = true;
+          node = grand;
+          continue;
+        }
+        if (node == parent->left) {
+          rotateRight(parent);
+          node = parent;
+          parent = node->parent;
+        }
+        parent->red = false;
+        grand->red = true;
+        rotateLeft(grand);
+      }
+    }
+    root->red = false;
+  }
+
+  Node<T> *findMin(Node<T> *node) {
+    while (node && node->left) {
+      node = node->left;
+    }
+    return node;
+  }
+
+  void removeNode(Node<T> *node) {
+    if (node->left && node->right) {
+      Node<T> *successor = findMin(node->right);
+      node->val = std::move(successor->val);
+      node = successor;
+    }
+
+    // node has at most one child now
+    Node<T> *child = node->left ? node->left : node->right;
+    Node<T> *parent = node->parent;
+    bool wasBlack = !node->red;
+
+    replaceChild(parent, node, child);
+    delete node;
+
+    if (wasBlack)
+      removeFixup(child, parent);
+  }
+
+  void removeFixup(Node<T> *node, Node<T> *parent) {
+    while (node != root && !isRed(node)) {
+      if (node == parent->left) {
+        Node<T> *sibling = parent->right;
+        if (isRed(sibling)) {
+          sibling->red = false;
+          parent->red = true;
+          rotateLeft(parent);
+          sibling = parent->right;
+        }
+        if (!isRed(sibling->left) && !isRed(sibling->right)) {
+          sibling->red = true;
+          node = parent;
+          parent = node->parent;
+          continue;
+        }
+        if (!isRed(sibling->right)) {
+          sibling->left->red = false;
+          sibling->red = true;
+          rotateRight(sibling);
+          sibling = parent->right;
+        }
+        sibling->red = parent->red;
+        parent->red = false;
+        sibling->right->red = false;
+        rotateLeft(parent);
+        node = root;
+      } else {
+        Node<T> *sibling = parent->left;
+        if (isRed(sibling)) {
+          sibling->red = false;
+          parent->red = true;
+          rotateRight(parent);
+          sibling = parent->left;
+        }
+        if (!isRed(sibling->left) && !isRed(sibling->right)) {
+          sibling->red = true;
+          node = parent;
+          parent = node->parent;
+          continue;
+        }
+        if (!isRed(sibling->left)) {
+          sibling->right->red = false;
+          sibling->red = true;
+          rotateLeft(sibling);
+          sibling = parent->left;
+        }
+        sibling->red = parent->red;
+        parent->red = false;
+        sibling->left->red = false;
+        rotateRight(parent);
+        node = root;
+      }
+    }
+    if (node)
+      node->red = false;
+  }
+
+  // Copies src node by node with an explicit stack, keeping its shape and
+  // colors, so no fixup runs. If copying a value throws, the partial copy is
+  // freed.
+  static Node<T> *cloneTree(const Node<T> *src) {
+    if (!src)
+      return nullptr;
+
+    Node<T> *copy = cloneNode(src, nullptr);
+    std::vector<std::pair<const Node<T> *, Node<T> *>> stack;
+    stack.push_back({src, copy});
+    try {
+      while (!stack.empty()) {
+        const Node<T> *from = stack.back().first;
+        Node<T> *to = stack.back().second;
+        stack.pop_back();
+        if (from->right) {
+          to->right = cloneNode(from->right, to);
+          stack.push_back({from->right, to->right});
+        }
+        if (from->left) {
+          to->left = cloneNode(from->left, to);
+          stack.push_back({from->left, to->left});
+        }
+      }
+    } catch (...) {
+      clear(copy);
+      throw;
+    }
+    return copy;
+  }
+
+  static Node<T> *cloneNode(const Node<T> *src, Node<T> *parent) {
+    Node<T> *node = new Node<T>(src->val);
+    node->parent = parent;
+    node->red = src->red;
+    return node;
+  }
+
+  static void clear(Node<T> *node) {
+    if (!node)
+      return;
+    clear(node->left);
+    clear(node->right);
+    delete node;
+  }
+};
+
+template <typename T, bool (*Comp)(const T &, const T &)>
+void swap(RBAbstract<T, Comp> &a, RBAbstract<T, Comp> &b) noexcept {
+  a.swap(b);
+}
+
+template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }
+template <typename T> using RBTree = RBAbstract<T, lessCompare<T>>;
+
+int main() {
+  std::cout << "=== Red-Black Tree Test ===" << std::endl;
+
+  RBTree<int> rb;
+
+  std::cout << "\n1. Inserting elements: 5, 3, 7, 2, 4, 6, 8" << std::endl;
+  int elems[] = {5, 3, 7, 2, 4, 6, 8};
+  for (int x : elems)
+    rb.insert(x);
+  rb.print();
+
+  std::cout << "\n2. Searching for elements:" << std::endl;
+  std::cout << "Search 4: "
+            << (rb.search(4) != nullptr ? "Found" : "Not found") << std::endl;
+  std::cout << "Search 10: "
+            << (rb.search(10) != nullptr ? "Found" : "Not found") << std::endl;
+
+  std::cout << "\n3. Removing leaf node (2):" << std::endl;
+  rb.remove(2);
+  rb.print();
+
+  std::cout << "\n4. Removing node with two children (root 5):" << std::endl;
+  rb.remove(5);
+  rb.print();
+
+  std::cout << "\n5. Removing non-existent element (100):" << std::endl;
+  bool result = rb.remove(100);
+  std::cout << "Result: " << (result ? "Success" : "Failed (expected)")
+            << std::endl;
+
+  std::cout << "\n6. Inserting sorted sequence into new tree (1..15):"
+            << std::endl;
+  RBTree<int> rb2;
+  for (int i = 1; i <= 15; ++i) {
+    rb2.insert(i);
+  }
+  rb2.print();
+
+  std::cout << "\n7. Removing all elements one by one:" << std::endl;
+  for (int i = 1; i <= 15; ++i) {
+    rb2.remove(i);
+  }
+  std::cout << "Search 7 after removal: "
+            << (rb2.search(7) != nullptr ? "Found" : "Not found") << std::endl;
+
+  std::cout << "\n8. Copying and moving trees:" << std::endl;
+  RBTree<int> copy = rb;
+  copy.insert(1);
+  std::cout << "Search 1 in original: "
+            << (rb.search(1) != nullptr ? "Found" : "Not found (expected)")
+            << std::endl;
+  RBTree<int> moved = std::move(copy);
+  moved.print();
+
+  std::cout << "\n=== All Red-Black tests completed ===" << std::endl;
+  return 0;
+}
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
 
 template <typename T>
 struct Node {
@@ -14,46 +17,95 @@ public:
     size = 0;
   }
 
-  ~Stack() {
-    Node<T> *current = head;
-    while (current != nullptr) {
-      Node<T> *next = current->next;
-      delete current;
-      current = next;
+  // Deep copy in the same order, without recursion.
+  Stack(const Stack &other) {
+    head = nullptr;
+    size = 0;
+    Node<T> **link = &head;
+    try {
+      for (Node<T> *current = other.head; current != nullptr;
+           current = current->next) {
+        *link = new Node<T>{current->data, nullptr};
+        link = &(*link)->next;
+        size++;
+      }
+    } catch (...) {
+      clear();
+      throw;
     }
   }
 
+  Stack(Stack &&other) noexcept {
+    head = other.head;
+    size = other.size;
+    other.head = nullptr;
+    other.size = 0;
+  }
+
+  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.
+  Stack &operator=(Stack other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~Stack() { clear(); }
+
+  void swap(Stack &other) noexcept {
+    std::swap(head, other.head);
+    std::swap(size, other.size);
+  }
+
   T pop() {
     if (isEmpty()) {
       throw std::runtime_error("Stack is empty");
     }
 
     size--;
-    T data = head->data;
-    head = head->next;
-    delete head;
+    Node<T> *oldHead = head;
+    T data = std::move(oldHead->data);
+    head = oldHead->next;
+    delete oldHead;
     return data;
   }
 
-  void push(T data) {
+  void push(const T &data) {
+    head = new Node<T>{data, head};
     size++;
-    Node<T> *node = new Node<T>(data);
-    node->next = head;
-    head = node;
+  }
+
+  void push(T &&data) {
+    head = new Node<T>{std::move(data), head};
+    size++;
+  }
+
+  void clear() {
+    while (head != nullptr) {
+      Node<T> *next = head->next;
+      delete head;
+      head = next;
+    }
+    size = 0;
   }
 
   bool isEmpty() { return size == 0; }
 
   int getSize() { return size; }
 
-  void print() {
-    Node<T> *current = head;
-    std::cout << "Stack (size=" << size << "): ";
-    while (current != nullptr) {
-      std::cout << current->data << " ";
-      current = current->next;
+  // Formats all elements into one buffer and writes it with a single flush.
+  void print(std::ostream &out = std::cout) const {
+    std::ostringstream buffer;
+    buffer << "Stack (size=" << size << "): ";
+    visit([&buffer](const T &data) { buffer << data << " "; });
+    buffer << '\n';
+    out << buffer.str() << std::flush;
+  }
+
+  // Calls fn(data) for every element from top to bottom.
+  template <typename Fn> void visit(Fn fn) const {
+    for (Node<T> *current = head; current != nullptr;
+         current = current->next) {
+      fn(current->data);
     }
-    std::cout << std::endl;
   }
 
 private:
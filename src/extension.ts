@@ -2,6 +2,7 @@
 // Import the module and reference it with the alias vscode in your code below
 import * as vscode from 'vscode';
 import { snippets } from './snippets';
+import { availableOptions, buildSnippet, OptionId } from './variants';
 
 // This method is called when your extension is activated
 // Your extension is activated the very first time the command is executed
@@ -20,7 +21,21 @@ export function activate(context: vscode.ExtensionContext) {
 		const snippet = snippets.find(s => s.label === picked);
 		if (!snippet) return;
 
-		const snippetString = new vscode.SnippetString(snippet.body.join("\n"));
+		// Second step: performance options that apply to this snippet.
+		// Picking none inserts the plain snippet.
+		let options = new Set<OptionId>();
+		const available = availableOptions(snippet);
+		if (available.length > 0) {
+			const chosen = await vscode.window.showQuickPick(
+				available.map(o => ({ label: o.label, description: o.description, id: o.id })),
+				{ placeHolder: "Choose options (none for the plain snippet)", canPickMany: true }
+			);
+			if (!chosen) return;
+			options = new Set(chosen.map(o => o.id));
+		}
+
+		// Inserted as plain text: C++ code may contain `$` and `\`.
+		const snippetString = new vscode.SnippetString().appendText(buildSnippet(snippet, options));
 		editor.insertSnippet(snippetString);
 	});
 
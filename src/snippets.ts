@@ -1,8 +1,27 @@
-export const snippets = [
+// Generated by scripts/generate-snippets.mjs from source/. Do not edit:
+// run `npm run compile` after changing the C++ sources.
+import type { Fragments, SnippetTemplate } from './variants';
+
+export const snippets: SnippetTemplate[] = [
     {
         "label": "AVL Tree",
         "body": [
+            "#include <algorithm>",
+            "#include <atomic>",
+            "#include <condition_variable>",
+            "#include <cstdint>",
+            "#include <cstring>",
+            "#include <exception>",
+            "#include <functional>",
             "#include <iostream>",
+            "#include <iterator>",
+            "#include <mutex>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <thread>",
+            "#include <type_traits>",
+            "#include <utility>",
+            "#include <vector>",
             "",
             "template <typename T>",
             "struct Node {",
@@ -11,52 +30,503 @@ export const snippets = [
             "  Node *right = nullptr;",
             "  int height = 1;",
             "",
-            "  Node(T v) : val(v) {}",
+            "  Node(T v) : val(std::move(v)) {}",
+            "};",
+            "",
+            "// Binary dump layout: header followed by `count` raw elements. T must be",
+            "// trivially copyable, so the file can also be mmapped and searched in place.",
+            "struct DumpHeader {",
+            "  char magic[4];",
+            "  uint32_t elemSize;",
+            "  uint64_t count;",
             "};",
             "",
+            "// Reads the `count` elements that follow a DumpHeader into out. count comes",
+            "// from the file, so it is checked against the bytes left in the stream",
+            "// before out is sized. A stream that cannot seek is read in bounded steps",
+            "// instead, so a corrupt count ends in a short read, not a huge allocation.",
             "template <typename T>",
-            "class AVL {",
+            "bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {",
+            "  uint64_t step = count;",
+            "  std::streampos here = in.tellg();",
+            "  if (here != std::streampos(-1) && in.seekg(0, std::ios::end)) {",
+            "    uint64_t left = static_cast<uint64_t>(in.tellg() - here);",
+            "    in.seekg(here);",
+            "    if (count > left / sizeof(T))",
+            "      return false;",
+            "  } else {",
+            "    in.clear();",
+            "    step = 1 << 16;",
+            "  }",
+            "  out.clear();",
+            "  while (out.size() < count) {",
+            "    size_t done = out.size();",
+            "    size_t n = static_cast<size_t>(std::min<uint64_t>(step, count - done));",
+            "    out.resize(done + n);",
+            "    in.read(reinterpret_cast<char *>(out.data() + done), n * sizeof(T));",
+            "    if (!in)",
+            "      return false;",
+            "  }",
+            "  return true;",
+            "}",
+            "",
+            "// Immutable search array in Eytzinger (BFS) order produced by freeze(). Node",
+            "// k has children 2k and 2k + 1, so the top levels share a few cache lines and",
+            "// lookup is a branchless descent that prefetches four levels ahead.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class FrozenTree {",
             "public:",
-            "  using CompareFunction = int (*)(T, T);",
+            "  explicit FrozenTree(const std::vector<T> &sorted) {",
+            "    arr.resize(sorted.size() + 1);",
+            "    int pos = 0;",
+            "    build(sorted, pos, 1);",
+            "  }",
             "",
-            "  Node<T> *root;",
-            "  CompareFunction compare;",
-            "",
-            "  AVL(CompareFunction cmp = nullptr) {",
-            "    if (cmp == nullptr) {",
-            "      cmp = [](T a, T b) {",
-            "        if (a < b)",
-            "          return -1;",
-            "        if (a > b)",
-            "          return 1;",
-            "        return 0;",
-            "      };",
-            "    }",
-            "    compare = cmp;",
-            "    root = nullptr;",
+            "  const T *search(const T &val) const {",
+            "    const int n = size();",
+            "    const int block = sizeof(T) < 64 ? 64 / sizeof(T) : 1;",
+            "    int k = 1;",
+            "    while (k <= n) {",
+            "#if defined(__GNUC__) || defined(__clang__)",
+            "      __builtin_prefetch(arr.data() + static_cast<size_t>(k) * block);",
+            "#endif",
+            "      k = 2 * k + Comp(arr[k], val);",
+            "    }",
+            "    // undo the trailing right turns to get the lower bound",
+            "    while (k & 1)",
+            "      k >>= 1;",
+            "    k >>= 1;",
+            "    if (k == 0 || Comp(val, arr[k]))",
+            "      return nullptr;",
+            "    return &arr[k];",
+            "  }",
+            "",
+            "  int size() const { return static_cast<int>(arr.size()) - 1; }",
+            "  bool empty() const { return size() == 0; }",
+            "",
+            "private:",
+            "  std::vector<T> arr; // arr[0] unused",
+            "",
+            "  void build(const std::vector<T> &sorted, int &pos, int k) {",
+            "    if (k > size())",
+            "      return;",
+            "    build(sorted, pos, 2 * k);",
+            "    arr[k] = sorted[pos++];",
+            "    build(sorted, pos, 2 * k + 1);",
+            "  }",
+            "};",
+            "",
+            "// Fixed set of worker threads for the parallel bulk operations. run() is a",
+            "// fork-join step: the calling thread takes part, and it returns once every",
+            "// task is done. Tasks of one run() must not call run() on the same pool.",
+            "class ThreadPool {",
+            "public:",
+            "  // threads counts the calling thread, so ThreadPool(1) runs tasks inline.",
+            "  explicit ThreadPool(",
+            "      int threads = static_cast<int>(std::thread::hardware_concurrency())) {",
+            "    job = nullptr;",
+            "    jobSize = 0;",
+            "    next = 0;",
+            "    pending = 0;",
+            "    active = 0;",
+            "    generation = 0;",
+            "    stopping = false;",
+            "    for (int i = 1; i < threads; i++) {",
+            "      workers.emplace_back([this] { workerLoop(); });",
+            "    }",
+            "  }",
+            "",
+            "  ThreadPool(const ThreadPool &) = delete;",
+            "  ThreadPool &operator=(const ThreadPool &) = delete;",
+            "",
+            "  ~ThreadPool() {",
+            "    {",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      stopping = true;",
+            "    }",
+            "    wake.notify_all();",
+            "    for (std::thread &worker : workers) {",
+            "      worker.join();",
+            "    }",
+            "  }",
+            "",
+            "  int size() const { return static_cast<int>(workers.size()) + 1; }",
+            "",
+            "  // Calls fn(i) for every i in [0, count), spread over the pool. The first",
+            "  // exception thrown by a task is rethrown here after all tasks finished.",
+            "  template <typename Fn> void run(int count, Fn fn) {",
+            "    if (count <= 0)",
+            "      return;",
+            "    if (workers.empty() || count == 1) {",
+            "      for (int i = 0; i < count; i++) {",
+            "        fn(i);",
+            "      }",
+            "      return;",
+            "    }",
+            "",
+            "    std::function<void(int)> task = fn;",
+            "    {",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      job = &task;",
+            "      jobSize = count;",
+            "      next = 0;",
+            "      pending = count;",
+            "      error = nullptr;",
+            "      generation++;",
+            "    }",
+            "    wake.notify_all();",
+            "    work(task, count);",
+            "",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    done.wait(lock, [this] { return pending == 0 && active == 0; });",
+            "    job = nullptr;",
+            "    if (error) {",
+            "      std::rethrow_exception(error);",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  std::vector<std::thread> workers;",
+            "  std::mutex mutex;",
+            "  std::condition_variable wake;",
+            "  std::condition_variable done;",
+            "  const std::function<void(int)> *job;",
+            "  int jobSize;",
+            "  std::atomic<int> next; // next task index to hand out",
+            "  int pending;           // tasks not finished yet",
+            "  int active;            // workers inside work(), run() waits for them too",
+            "  uint64_t generation;",
+            "  bool stopping;",
+            "  std::exception_ptr error;",
+            "",
+            "  void workerLoop() {",
+            "    uint64_t seen = 0;",
+            "    for (;;) {",
+            "      const std::function<void(int)> *task;",
+            "      int count;",
+            "      {",
+            "        std::unique_lock<std::mutex> lock(mutex);",
+            "        wake.wait(lock, [&] { return stopping || generation != seen; });",
+            "        if (stopping)",
+            "          return;",
+            "        seen = generation;",
+            "        if (job == nullptr)",
+            "          continue;",
+            "        task = job;",
+            "        count = jobSize;",
+            "        active++;",
+            "      }",
+            "      work(*task, count);",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      active--;",
+            "      if (pending == 0 && active == 0)",
+            "        done.notify_all();",
+            "    }",
+            "  }",
+            "",
+            "  void work(const std::function<void(int)> &task, int count) {",
+            "    int finished = 0;",
+            "    for (int i; (i = next.fetch_add(1)) < count;) {",
+            "      try {",
+            "        task(i);",
+            "      } catch (...) {",
+            "        std::lock_guard<std::mutex> lock(mutex);",
+            "        if (!error)",
+            "          error = std::current_exception();",
+            "      }",
+            "      finished++;",
+            "    }",
+            "    if (finished > 0) {",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      pending -= finished;",
+            "      if (pending == 0 && active == 0)",
+            "        done.notify_all();",
+            "    }",
+            "  }",
+            "};",
+            "",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class AVLAbstract {",
+            "public:",
+            "  AVLAbstract() { root = nullptr; }",
+            "",
+            "  // Deep copy with the same shape as other, see cloneTree.",
+            "  AVLAbstract(const AVLAbstract &other) { root = cloneTree(other.root); }",
+            "",
+            "  AVLAbstract(AVLAbstract &&other) noexcept {",
+            "    root = other.root;",
+            "    other.root = nullptr;",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  AVLAbstract &operator=(AVLAbstract other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
             "  }",
             "",
-            "  ~AVL() { clear(root); }",
+            "  ~AVLAbstract() { clear(root); }",
+            "",
+            "  void swap(AVLAbstract &other) noexcept { std::swap(root, other.root); }",
             "",
-            "  void insert(T val) { root = insertNode(root, val); }",
-            "  T *search(T val) { return searchNode(root, val); }",
-            "  bool remove(T val) {",
+            "  // Returns false if an equal key was already present.",
+            "  bool insert(const T &val) {",
+            "    bool inserted = false;",
+            "    root = insertNode(root, val, inserted);",
+            "    return inserted;",
+            "  }",
+            "  bool insert(T &&val) {",
+            "    bool inserted = false;",
+            "    root = insertNode(root, std::move(val), inserted);",
+            "    return inserted;",
+            "  }",
+            "  T *search(const T &val) { return searchNode(root, val); }",
+            "  bool remove(const T &val) {",
             "    bool removed = false;",
             "    root = removeNode(root, val, removed);",
             "    return removed;",
             "  }",
             "",
-            "  void clear() {",
+            "  // Looks up every key in keys and stores the result (or nullptr) at the same",
+            "  // index of out. Descents run in groups that advance one level per round, so",
+            "  // the cache misses of different keys overlap instead of queueing up.",
+            "  void searchBatch(const std::vector<T> &keys, std::vector<T *> &out) {",
+            "    const size_t group = 16;",
+            "    Node<T> *cursor[group];",
+            "    out.assign(keys.size(), nullptr);",
+            "",
+            "    for (size_t base = 0; base < keys.size(); base += group) {",
+            "      size_t n = std::min(group, keys.size() - base);",
+            "      for (size_t i = 0; i < n; i++) {",
+            "        cursor[i] = root;",
+            "      }",
+            "",
+            "      size_t active = n;",
+            "      while (active > 0) {",
+            "        active = 0;",
+            "        for (size_t i = 0; i < n; i++) {",
+            "          Node<T> *node = cursor[i];",
+            "          if (!node)",
+            "            continue;",
+            "",
+            "          int r = compare(keys[base + i], node->val);",
+            "          if (r == 0) {",
+            "            out[base + i] = &(node->val);",
+            "            cursor[i] = nullptr;",
+            "            continue;",
+            "          }",
+            "",
+            "          node = r < 0 ? node->left : node->right;",
+            "#if defined(__GNUC__) || defined(__clang__)",
+            "          if (node)",
+            "            __builtin_prefetch(node);",
+            "#endif",
+            "          cursor[i] = node;",
+            "          if (node)",
+            "            active++;",
+            "        }",
+            "      }",
+            "    }",
+            "  }",
+            "",
+            "  // Formats the whole tree into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    std::vector<std::pair<Node<T> *, int>> stack;",
+            "    Node<T> *node = root;",
+            "    int depth = 0;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back({node, depth});",
+            "        node = node->right;",
+            "        depth++;",
+            "      }",
+            "      node = stack.back().first;",
+            "      depth = stack.back().second;",
+            "      stack.pop_back();",
+            "",
+            "      for (int i = 0; i < depth; i++) {",
+            "        buffer << \"   \";",
+            "      }",
+            "      buffer << node->val << '\\n';",
+            "",
+            "      node = node->left;",
+            "      depth++;",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(val) for every key in sorted order, without recursion.",
+            "  template <typename Fn> void visitInOrder(Fn fn) const {",
+            "    visitSubtree(root, fn);",
+            "  }",
+            "",
+            "  // Calls fn(val) for every key, spread over the pool: the subtrees below",
+            "  // the top levels are separate tasks. fn is called concurrently and in no",
+            "  // particular order, so it must be thread-safe.",
+            "  template <typename Fn> void visitParallel(ThreadPool &pool, Fn fn) const {",
+            "    std::vector<Span> spans;",
+            "    collectSpans(root, splitDepth(pool), spans);",
+            "    pool.run(static_cast<int>(spans.size()), [&](int i) {",
+            "      if (spans[i].whole) {",
+            "        visitSubtree(spans[i].node, fn);",
+            "      } else {",
+            "        fn(spans[i].node->val);",
+            "      }",
+            "    });",
+            "  }",
+            "",
+            "  // Folds combine(acc, map(val)) over the keys in sorted order, starting from",
+            "  // identity. Each subtree below the top levels is folded as its own task",
+            "  // and the partial results are combined in key order, so combine must be",
+            "  // associative with identity as its neutral element, but need not be",
+            "  // commutative. map is called concurrently.",
+            "  template <typename R, typename Map, typename Combine>",
+            "  R reduceParallel(ThreadPool &pool, R identity, Map map,",
+            "                   Combine combine) const {",
+            "    struct Partial {",
+            "      R acc;",
+            "    };",
+            "    std::vector<Span> spans;",
+            "    collectSpans(root, splitDepth(pool), spans);",
+            "    std::vector<Partial> partial(spans.size(), Partial{identity});",
+            "    pool.run(static_cast<int>(spans.size()), [&](int i) {",
+            "      R &acc = partial[i].acc;",
+            "      if (spans[i].whole) {",
+            "        visitSubtree(spans[i].node, [&](const T &val) {",
+            "          acc = combine(std::move(acc), map(val));",
+            "        });",
+            "      } else {",
+            "        acc = combine(std::move(acc), map(spans[i].node->val));",
+            "      }",
+            "    });",
+            "",
+            "    R result = std::move(identity);",
+            "    for (Partial &p : partial) {",
+            "      result = combine(std::move(result), std::move(p.acc));",
+            "    }",
+            "    return result;",
+            "  }",
+            "",
+            "  // Calls fn(val, depth) level by level, root first.",
+            "  template <typename Fn> void visitLevelOrder(Fn fn) const {",
+            "    std::vector<std::pair<Node<T> *, int>> level;",
+            "    if (root)",
+            "      level.push_back({root, 0});",
+            "    for (size_t i = 0; i < level.size(); i++) {",
+            "      Node<T> *node = level[i].first;",
+            "      int depth = level[i].second;",
+            "      fn(node->val, depth);",
+            "      if (node->left)",
+            "        level.push_back({node->left, depth + 1});",
+            "      if (node->right)",
+            "        level.push_back({node->right, depth + 1});",
+            "    }",
+            "  }",
+            "",
+            "  // Snapshot of the current keys for read-only phases, see FrozenTree.",
+            "  FrozenTree<T, Comp> freeze() const {",
+            "    std::vector<T> sorted;",
+            "    collect(sorted);",
+            "    return FrozenTree<T, Comp>(sorted);",
+            "  }",
+            "",
+            "  // Writes the keys as a sorted array, see DumpHeader.",
+            "  void serialize(std::ostream &out) const {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"serialize requires a trivially copyable T\");",
+            "    std::vector<T> sorted;",
+            "    collect(sorted);",
+            "    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(T), sorted.size()};",
+            "    out.write(reinterpret_cast<const char *>(&header), sizeof(header));",
+            "    out.write(reinterpret_cast<const char *>(sorted.data()),",
+            "              sorted.size() * sizeof(T));",
+            "    if (!out) {",
+            "      throw std::runtime_error(\"Failed to write tree dump\");",
+            "    }",
+            "  }",
+            "",
+            "  // Replaces the contents with a dump written by serialize(). The tree is",
+            "  // built balanced from the sorted array in O(n), without re-inserting.",
+            "  void deserialize(std::istream &in) {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"deserialize requires a trivially copyable T\");",
+            "    DumpHeader header;",
+            "    in.read(reinterpret_cast<char *>(&header), sizeof(header));",
+            "    if (!in || std::memcmp(header.magic, \"DSTR\", 4) != 0 ||",
+            "        header.elemSize != sizeof(T)) {",
+            "      throw std::runtime_error(\"Invalid tree dump\");",
+            "    }",
+            "    std::vector<T> sorted;",
+            "    if (!readDumpElements(in, header.count, sorted)) {",
+            "      throw std::runtime_error(\"Truncated tree dump\");",
+            "    }",
+            "    for (size_t i = 1; i < sorted.size(); i++) {",
+            "      if (!Comp(sorted[i - 1], sorted[i])) {",
+            "        throw std::runtime_error(\"Unsorted tree dump\");",
+            "      }",
+            "    }",
+            "    assignSorted(sorted);",
+            "  }",
+            "",
+            "  // Replaces the contents with the given strictly increasing keys, building a",
+            "  // balanced tree in O(n). The new tree is built before the old one is freed,",
+            "  // so if building throws the tree is left unchanged.",
+            "  void assignSorted(const std::vector<T> &sorted) {",
+            "    Node<T> *fresh = build(sorted, 0, static_cast<int>(sorted.size()));",
             "    clear(root);",
-            "    root = nullptr;",
+            "    root = fresh;",
             "  }",
             "",
-            "  void print() {",
-            "    print(root, 0);",
-            "    std::cout << std::endl;",
+            "  // Replaces the contents with the keys in data, which may be unsorted and",
+            "  // hold duplicates. Chunks of data are sorted as pool tasks and merged",
+            "  // pairwise; then the top levels of the balanced tree are laid out here and",
+            "  // the subtrees below them are built as tasks. The result has the same",
+            "  // shape as assignSorted on the sorted, deduplicated keys.",
+            "  void buildParallel(std::vector<T> data, ThreadPool &pool) {",
+            "    sortParallel(data, pool);",
+            "    data.erase(std::unique(data.begin(), data.end(),",
+            "                           [](const T &a, const T &b) { return !Comp(a, b); }),",
+            "               data.end());",
+            "",
+            "    // Built aside like assignSorted, so a throw leaves the tree unchanged.",
+            "    Node<T> *fresh = nullptr;",
+            "    int split = splitDepth(pool);",
+            "    std::vector<BuildTask> tasks;",
+            "    try {",
+            "      layoutTop(data, 0, static_cast<int>(data.size()), split, &fresh, tasks);",
+            "      pool.run(static_cast<int>(tasks.size()), [&](int i) {",
+            "        *tasks[i].slot = build(data, tasks[i].lo, tasks[i].hi);",
+            "      });",
+            "    } catch (...) {",
+            "      clear(fresh);",
+            "      throw;",
+            "    }",
+            "    updateTop(fresh, split);",
+            "    clear(root);",
+            "    root = fresh;",
             "  }",
             "",
             "private:",
+            "  Node<T> *root;",
+            "",
+            "  // Subtree over sorted[lo, hi) still to be built into *slot.",
+            "  struct BuildTask {",
+            "    Node<T> **slot;",
+            "    int lo;",
+            "    int hi;",
+            "  };",
+            "",
+            "  // Piece of an in-order walk: one node alone, or the whole subtree under it.",
+            "  struct Span {",
+            "    Node<T> *node;",
+            "    bool whole;",
+            "  };",
+            "",
+            "  static int compare(const T &a, const T &b) {",
+            "    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);",
+            "  }",
+            "",
             "  int getHeight(Node<T> *node) { return node ? node->height : 0; }",
             "",
             "  int getBalance(Node<T> *node) {",
@@ -131,16 +601,20 @@ export const snippets = [
             "    return node;",
             "  }",
             "",
-            "  Node<T> *insertNode(Node<T> *node, T val) {",
+            "  // U is T or const T&; val is moved into the new node, never copied on the",
+            "  // way down.",
+            "  template <typename U>",
+            "  Node<T> *insertNode(Node<T> *node, U &&val, bool &inserted) {",
             "    if (!node) {",
-            "      return new Node<T>(val);",
+            "      inserted = true;",
+            "      return new Node<T>(std::forward<U>(val));",
             "    }",
             "",
             "    int r = compare(val, node->val);",
             "    if (r < 0) {",
-            "      node->left = insertNode(node->left, val);",
+            "      node->left = insertNode(node->left, std::forward<U>(val), inserted);",
             "    } else if (r > 0) {",
-            "      node->right = insertNode(node->right, val);",
+            "      node->right = insertNode(node->right, std::forward<U>(val), inserted);",
             "    } else {",
             "      return node;",
             "    }",
@@ -148,7 +622,7 @@ export const snippets = [
             "    return balanceNode(node);",
             "  }",
             "",
-            "  T *searchNode(Node<T> *node, T val) {",
+            "  T *searchNode(Node<T> *node, const T &val) {",
             "    if (!node)",
             "      return nullptr;",
             "",
@@ -167,7 +641,7 @@ export const snippets = [
             "    return node;",
             "  }",
             "",
-            "  Node<T> *removeNode(Node<T> *node, T val, bool &removed) {",
+            "  Node<T> *removeNode(Node<T> *node, const T &val, bool &removed) {",
             "    if (!node) {",
             "      removed = false;",
             "      return nullptr;",
@@ -194,171 +668,164 @@ export const snippets = [
             "      } else {",
             "        Node<T> *successor = findMin(node->right);",
             "        node->val = successor->val;",
-            "        node->right = removeNode(node->right, successor->val, removed);",
+            "        node->right = removeNode(node->right, node->val, removed);",
             "      }",
             "    }",
             "",
             "    return balanceNode(node);",
             "  }",
             "",
-            "  void print(Node<T> *node, int depth) {",
-            "    if (node == nullptr) {",
-            "      return;",
-            "    }",
-            "",
-            "    print(node->right, depth + 1);",
-            "",
-            "    for (int i = 0; i < depth; i++) {",
-            "      std::cout << \"   \";",
-            "    }",
-            "    std::cout << node->val << std::endl;",
-            "",
-            "    print(node->left, depth + 1);",
-            "  };",
-            "",
-            "  void clear(Node<T> *node) {",
-            "    if (!node)",
-            "      return;",
-            "    clear(node->left);",
-            "    clear(node->right);",
-            "    delete node;",
+            "  void collect(std::vector<T> &out) const {",
+            "    visitInOrder([&out](const T &val) { out.push_back(val); });",
             "  }",
-            "};",
-            "",
-            "$1"
-        ]
-    },
-    {
-        "label": "Binary Search Tree",
-        "body": [
-            "#include <iostream>",
-            "",
-            "template <typename T>",
-            "struct Node {",
-            "  T val;",
-            "  Node *left = nullptr;",
-            "  Node *right = nullptr;",
-            "  Node(T v) : val(v) {}",
-            "};",
             "",
-            "template <typename T>",
-            "class BST {  ",
-            "public:",
-            "  using CompareFunction = int (*)(T, T);",
+            "  // Depth at which the parallel operations cut the tree into tasks: about",
+            "  // four subtrees per thread, so uneven subtrees still balance out.",
+            "  static int splitDepth(const ThreadPool &pool) {",
+            "    int depth = 0;",
+            "    while ((1 << depth) < 4 * pool.size())",
+            "      depth++;",
+            "    return depth;",
+            "  }",
             "",
-            "  Node<T>* root;",
-            "  CompareFunction compare;",
-            "  BST(CompareFunction cmp = nullptr) {",
-            "    if (cmp == nullptr) {",
-            "      cmp = [](T a, T b) { return a - b; };",
+            "  // Sorts chunks of data as pool tasks, then merges neighbouring runs",
+            "  // pairwise, one pool.run per round, until a single run is left. Small",
+            "  // inputs are sorted inline.",
+            "  static void sortParallel(std::vector<T> &data, ThreadPool &pool) {",
+            "    size_t n = data.size();",
+            "    size_t runs = n < 8192 ? 1 : static_cast<size_t>(pool.size());",
+            "    std::vector<size_t> bounds(runs + 1);",
+            "    for (size_t i = 0; i <= runs; i++) {",
+            "      bounds[i] = n / runs * i + std::min(i, n % runs);",
+            "    }",
+            "    auto at = [&](size_t run) { return data.begin() + bounds[run]; };",
+            "",
+            "    pool.run(static_cast<int>(runs), [&](int i) {",
+            "      std::sort(at(i), at(i + 1), Comp);",
+            "    });",
+            "    for (size_t width = 1; width < runs; width *= 2) {",
+            "      int pairs = static_cast<int>((runs + 2 * width - 1) / (2 * width));",
+            "      pool.run(pairs, [&](int p) {",
+            "        size_t lo = p * 2 * width;",
+            "        size_t mid = std::min(lo + width, runs);",
+            "        size_t hi = std::min(lo + 2 * width, runs);",
+            "        if (mid < hi)",
+            "          std::inplace_merge(at(lo), at(mid), at(hi), Comp);",
+            "      });",
             "    }",
-            "",
-            "    compare = cmp;",
-            "    root = nullptr;",
             "  }",
             "",
-            "  ~BST() { clear(root); }",
-            "",
-            "  void insert(T val) { insertNode(root, val); }",
-            "  T *search(T val) { return searchNode(root, val); }",
-            "  bool remove(T val) { return removeNode(root, val); }",
-            "  void clear() {",
-            "    clear(root);",
-            "    root = nullptr;",
+            "  // Lays out the nodes of the balanced tree over sorted[lo, hi) that lie",
+            "  // above depth `split`, and records each subtree at that depth as a task.",
+            "  void layoutTop(const std::vector<T> &sorted, int lo, int hi, int split,",
+            "                 Node<T> **slot, std::vector<BuildTask> &tasks) {",
+            "    *slot = nullptr;",
+            "    if (lo >= hi)",
+            "      return;",
+            "    if (split == 0) {",
+            "      tasks.push_back({slot, lo, hi});",
+            "      return;",
+            "    }",
+            "    int mid = lo + (hi - lo) / 2;",
+            "    Node<T> *node = new Node<T>(sorted[mid]);",
+            "    *slot = node;",
+            "    layoutTop(sorted, lo, mid, split - 1, &node->left, tasks);",
+            "    layoutTop(sorted, mid + 1, hi, split - 1, &node->right, tasks);",
             "  }",
             "",
-            "  void print() {",
-            "    std::cout << \"Tree structure:\" << std::endl;",
-            "    print(root, 0);",
-            "    std::cout << std::endl;",
+            "  // Recomputes the heights of the nodes laid out by layoutTop, once the",
+            "  // subtrees under them are built.",
+            "  void updateTop(Node<T> *node, int split) {",
+            "    if (!node || split == 0)",
+            "      return;",
+            "    updateTop(node->left, split - 1);",
+            "    updateTop(node->right, split - 1);",
+            "    updateHeight(node);",
             "  }",
             "",
-            "private:",
-            "  void insertNode(Node<T>*  &node, T val) {",
-            "    if (node == nullptr) {",
-            "      node = new Node<T>(val);",
+            "  static void collectSpans(Node<T> *node, int split, std::vector<Span> &spans) {",
+            "    if (!node)",
+            "      return;",
+            "    if (split == 0) {",
+            "      spans.push_back({node, true});",
             "      return;",
             "    }",
+            "    collectSpans(node->left, split - 1, spans);",
+            "    spans.push_back({node, false});",
+            "    collectSpans(node->right, split - 1, spans);",
+            "  }",
             "",
-            "    int r = compare(val, node->val);",
-            "    if (r <= 0) {",
-            "      insertNode(node->left, val);",
-            "    } else {",
-            "      insertNode(node->right, val);",
+            "  template <typename Fn> static void visitSubtree(Node<T> *node, Fn &&fn) {",
+            "    std::vector<Node<T> *> stack;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back(node);",
+            "        node = node->left;",
+            "      }",
+            "      node = stack.back();",
+            "      stack.pop_back();",
+            "      fn(node->val);",
+            "      node = node->right;",
             "    }",
             "  }",
             "",
-            "  T *searchNode(Node<T>*  node, T val) {",
-            "    if (node == nullptr) {",
+            "  // Balanced subtree over sorted[lo, hi). If allocating or copying a key",
+            "  // throws, the part built so far is freed.",
+            "  Node<T> *build(const std::vector<T> &sorted, int lo, int hi) {",
+            "    if (lo >= hi)",
             "      return nullptr;",
+            "    int mid = lo + (hi - lo) / 2;",
+            "    Node<T> *node = new Node<T>(sorted[mid]);",
+            "    try {",
+            "      node->left = build(sorted, lo, mid);",
+            "      node->right = build(sorted, mid + 1, hi);",
+            "    } catch (...) {",
+            "      clear(node);",
+            "      throw;",
             "    }",
-            "",
-            "    int r = compare(val, node->val);",
-            "",
-            "    if (r < 0) {",
-            "      return searchNode(node->left, val);",
-            "    } else if (r > 0) {",
-            "      return searchNode(node->right, val);",
-            "    } else {",
-            "      return &(node->val);",
-            "    }",
+            "    updateHeight(node);",
+            "    return node;",
             "  }",
             "",
-            "  bool removeNode(Node<T> *&node, T val) {",
-            "    if (node == nullptr) {",
-            "      return false;",
-            "    }",
-            "",
-            "    int r = compare(val, node->val);",
+            "  // Copies src node by node with an explicit stack, keeping its shape and",
+            "  // heights, so no rebalancing happens. The stack is sized once from the",
+            "  // height. If copying a value throws, the partial copy is freed.",
+            "  static Node<T> *cloneTree(const Node<T> *src) {",
+            "    if (!src)",
+            "      return nullptr;",
             "",
-            "    if (r < 0) {",
-            "      return removeNode(node->left, val);",
-            "    } else if (r > 0) {",
-            "      return removeNode(node->right, val);",
-            "    } else {",
-            "      if (node->left == nullptr && node->right == nullptr) {",
-            "        delete node;",
-            "        node = nullptr;",
-            "      } else if (node->left == nullptr) {",
-            "        Node<T> *temp = node;",
-            "        node = node->right;",
-            "        delete temp;",
-            "      } else if (node->right == nullptr) {",
-            "        Node<T> *temp = node;",
-            "        node = node->left;",
-            "        delete temp;",
-            "      } else {",
-            "        Node<T> *successor = findMin(node->right);",
-            "        node->val = successor->val;",
-            "        removeNode(node->right, successor->val);",
+            "    Node<T> *copy = cloneNode(src);",
+            "    std::vector<std::pair<const Node<T> *, Node<T> *>> stack;",
+            "    stack.reserve(src->height + 1);",
+            "    stack.push_back({src, copy});",
+            "    try {",
+            "      while (!stack.empty()) {",
+            "        const Node<T> *from = stack.back().first;",
+            "        Node<T> *to = stack.back().second;",
+            "        stack.pop_back();",
+            "        if (from->right) {",
+            "          to->right = cloneNode(from->right);",
+            "          stack.push_back({from->right, to->right});",
+            "        }",
+            "        if (from->left) {",
+            "          to->left = cloneNode(from->left);",
+            "          stack.push_back({from->left, to->left});",
+            "        }",
             "      }",
-            "      return true;",
+            "    } catch (...) {",
+            "      clear(copy);",
+            "      throw;",
             "    }",
+            "    return copy;",
             "  }",
             "",
-            "  Node<T> *findMin(Node<T> *node) {",
-            "    while (node->left != nullptr) {",
-            "      node = node->left;",
-            "    }",
+            "  static Node<T> *cloneNode(const Node<T> *src) {",
+            "    Node<T> *node = new Node<T>(src->val);",
+            "    node->height = src->height;",
             "    return node;",
             "  }",
             "",
-            "  void print(Node<T>* node, int depth) {",
-            "      if (node == nullptr) {",
-            "        return;",
-            "      }",
-            "",
-            "      print(node->right, depth + 1);",
-            "",
-            "      for (int i = 0; i < depth; i++) {",
-            "        std::cout << \"   \";",
-            "      }",
-            "      std::cout << node->val << std::endl;",
-            "",
-            "      print(node->left, depth + 1);",
-            "  };",
-            "",
-            "  void clear(Node<T>*  node) {",
+            "  static void clear(Node<T> *node) {",
             "    if (!node)",
             "      return;",
             "    clear(node->left);",
@@ -367,398 +834,5136 @@ export const snippets = [
             "  }",
             "};",
             "",
-            "$1"
-        ]
-    },
-    {
-        "label": "Heap",
-        "body": [
-            "#include <iostream>",
-            "#include <vector>",
-            "",
             "template <typename T, bool (*Comp)(const T &, const T &)>",
-            "class Heap {",
+            "void swap(AVLAbstract<T, Comp> &a, AVLAbstract<T, Comp> &b) noexcept {",
+            "  a.swap(b);",
+            "}",
+            "",
+            "// Ordered set with the AVLAbstract interface that keeps up to SmallSize keys",
+            "// in a sorted array inside the object, so small sets need no allocation and",
+            "// no pointer chasing. Inserting past SmallSize moves the keys into an",
+            "// AVLAbstract; dropping to SmallSize / 2 moves them back (the gap avoids",
+            "// converting back and forth around the threshold). T must be default",
+            "// constructible. Pointers from search() are invalidated by insert and remove.",
+            "template <typename T, bool (*Comp)(const T &, const T &), int SmallSize = 64>",
+            "class AdaptiveAVLAbstract {",
             "public:",
-            "  Heap() { std::vector<T> arr; }",
+            "  AdaptiveAVLAbstract() {",
+            "    tree = nullptr;",
+            "    count = 0;",
+            "  }",
             "",
-            "  void insert(int val) {",
-            "    arr.push_back(val);",
-            "    siftUp(arr.size() - 1);",
+            "  AdaptiveAVLAbstract(const AdaptiveAVLAbstract &other) {",
+            "    tree = other.tree ? new AVLAbstract<T, Comp>(*other.tree) : nullptr;",
+            "    count = other.count;",
+            "    if (!tree)",
+            "      std::copy(other.small, other.small + count, small);",
             "  }",
             "",
-            "  int popRoot() {",
-            "    if (arr.empty()) {",
-            "      throw std::out_of_range(\"Heap is empty\");",
-            "    }",
+            "  // O(1) once the keys live in a tree; a small set moves its keys one by one.",
+            "  AdaptiveAVLAbstract(AdaptiveAVLAbstract &&other) noexcept {",
+            "    tree = other.tree;",
+            "    count = other.count;",
+            "    if (!tree)",
+            "      std::move(other.small, other.small + count, small);",
+            "    other.tree = nullptr;",
+            "    other.count = 0;",
+            "  }",
             "",
-            "    int result = arr[0];",
-            "    int last = arr.size() - 1;",
+            "  AdaptiveAVLAbstract &operator=(AdaptiveAVLAbstract other) {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
             "",
-            "    std::swap(arr[0], arr[last]);",
-            "    arr.pop_back();",
+            "  ~AdaptiveAVLAbstract() { delete tree; }",
             "",
-            "    if (!arr.empty()) {",
-            "      siftDown(0);",
-            "    }",
+            "  void swap(AdaptiveAVLAbstract &other) {",
+            "    int n = std::max(tree ? 0 : count, other.tree ? 0 : other.count);",
+            "    std::swap_ranges(small, small + n, other.small);",
+            "    std::swap(tree, other.tree);",
+            "    std::swap(count, other.count);",
+            "  }",
             "",
-            "    return result;",
+            "  bool insert(const T &val) { return insertValue(val); }",
+            "  bool insert(T &&val) { return insertValue(std::move(val)); }",
+            "",
+            "  T *search(const T &val) {",
+            "    if (tree)",
+            "      return tree->search(val);",
+            "    int i = lowerBound(val);",
+            "    if (i < count && !Comp(val, small[i]))",
+            "      return &small[i];",
+            "    return nullptr;",
             "  }",
             "",
-            "  int peek() const {",
-            "    if (arr.empty()) {",
-            "      throw std::out_of_range(\"Heap is empty\");",
+            "  void searchBatch(const std::vector<T> &keys, std::vector<T *> &out) {",
+            "    if (tree) {",
+            "      tree->searchBatch(keys, out);",
+            "      return;",
+            "    }",
+            "    out.assign(keys.size(), nullptr);",
+            "    for (size_t k = 0; k < keys.size(); k++) {",
+            "      int i = lowerBound(keys[k]);",
+            "      if (i < count && !Comp(keys[k], small[i]))",
+            "        out[k] = &small[i];",
             "    }",
-            "    return arr[0];",
             "  }",
             "",
-            "  bool empty() const { return arr.empty(); }",
+            "  bool remove(const T &val) {",
+            "    if (tree) {",
+            "      if (!tree->remove(val))",
+            "        return false;",
+            "      count--;",
+            "      if (count <= SmallSize / 2)",
+            "        shrink();",
+            "      return true;",
+            "    }",
             "",
-            "  int size() const { return static_cast<int>(arr.size()); }",
+            "    int i = lowerBound(val);",
+            "    if (i == count || Comp(val, small[i]))",
+            "      return false;",
+            "    for (int j = i; j + 1 < count; j++) {",
+            "      small[j] = std::move(small[j + 1]);",
+            "    }",
+            "    count--;",
+            "    return true;",
+            "  }",
+            "",
+            "  void clear() {",
+            "    delete tree;",
+            "    tree = nullptr;",
+            "    count = 0;",
+            "  }",
+            "",
+            "  int size() const { return count; }",
+            "  bool isSmall() const { return tree == nullptr; }",
+            "",
+            "  // Same output as AVLAbstract::print; a small set prints the balanced tree",
+            "  // that grow() would build from the array.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    if (tree) {",
+            "      tree->print(out);",
+            "      return;",
+            "    }",
+            "    std::ostringstream buffer;",
+            "    printRange(buffer, 0, count, 0);",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  template <typename Fn> void visitInOrder(Fn fn) const {",
+            "    if (tree) {",
+            "      tree->visitInOrder(fn);",
+            "      return;",
+            "    }",
+            "    for (int i = 0; i < count; i++) {",
+            "      fn(small[i]);",
+            "    }",
+            "  }",
+            "",
+            "  // A small set is too small to split, so fn runs on the calling thread.",
+            "  template <typename Fn> void visitParallel(ThreadPool &pool, Fn fn) const {",
+            "    if (tree) {",
+            "      tree->visitParallel(pool, fn);",
+            "      return;",
+            "    }",
+            "    visitInOrder(fn);",
+            "  }",
+            "",
+            "  // A small set folds on the calling thread, in key order.",
+            "  template <typename R, typename Map, typename Combine>",
+            "  R reduceParallel(ThreadPool &pool, R identity, Map map,",
+            "                   Combine combine) const {",
+            "    if (tree)",
+            "      return tree->reduceParallel(pool, std::move(identity), map, combine);",
+            "    R acc = std::move(identity);",
+            "    for (int i = 0; i < count; i++) {",
+            "      acc = combine(std::move(acc), map(small[i]));",
+            "    }",
+            "    return acc;",
+            "  }",
+            "",
+            "  // A small set reports the levels of the balanced tree that grow() would",
+            "  // build from the array.",
+            "  template <typename Fn> void visitLevelOrder(Fn fn) const {",
+            "    if (tree) {",
+            "      tree->visitLevelOrder(fn);",
+            "      return;",
+            "    }",
+            "    struct Range {",
+            "      int lo;",
+            "      int hi;",
+            "      int depth;",
+            "    };",
+            "    std::vector<Range> level;",
+            "    if (count > 0)",
+            "      level.push_back({0, count, 0});",
+            "    for (size_t k = 0; k < level.size(); k++) {",
+            "      Range r = level[k];",
+            "      int mid = r.lo + (r.hi - r.lo) / 2;",
+            "      fn(small[mid], r.depth);",
+            "      if (r.lo < mid)",
+            "        level.push_back({r.lo, mid, r.depth + 1});",
+            "      if (mid + 1 < r.hi)",
+            "        level.push_back({mid + 1, r.hi, r.depth + 1});",
+            "    }",
+            "  }",
+            "",
+            "  FrozenTree<T, Comp> freeze() const {",
+            "    if (tree)",
+            "      return tree->freeze();",
+            "    return FrozenTree<T, Comp>(std::vector<T>(small, small + count));",
+            "  }",
+            "",
+            "  // Same dump format as AVLAbstract::serialize; a small set writes its",
+            "  // array directly.",
+            "  void serialize(std::ostream &out) const {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"serialize requires a trivially copyable T\");",
+            "    if (tree) {",
+            "      tree->serialize(out);",
+            "      return;",
+            "    }",
+            "    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(T),",
+            "                         static_cast<uint64_t>(count)};",
+            "    out.write(reinterpret_cast<const char *>(&header), sizeof(header));",
+            "    out.write(reinterpret_cast<const char *>(small), count * sizeof(T));",
+            "    if (!out) {",
+            "      throw std::runtime_error(\"Failed to write tree dump\");",
+            "    }",
+            "  }",
+            "",
+            "  // Loads into a new tree, which is kept if the dump holds more than",
+            "  // SmallSize keys. If loading throws the set is left unchanged.",
+            "  void deserialize(std::istream &in) {",
+            "    AVLAbstract<T, Comp> *loaded = new AVLAbstract<T, Comp>();",
+            "    int n = 0;",
+            "    try {",
+            "      loaded->deserialize(in);",
+            "      loaded->visitInOrder([&n](const T &) { n++; });",
+            "    } catch (...) {",
+            "      delete loaded;",
+            "      throw;",
+            "    }",
+            "    adopt(loaded, n);",
+            "  }",
+            "",
+            "  // Up to SmallSize keys go straight into the array; more are built into a",
+            "  // new tree. If copying a key throws, the set is left unchanged.",
+            "  void assignSorted(const std::vector<T> &sorted) {",
+            "    if (sorted.size() > static_cast<size_t>(SmallSize)) {",
+            "      AVLAbstract<T, Comp> *loaded = new AVLAbstract<T, Comp>();",
+            "      try {",
+            "        loaded->assignSorted(sorted);",
+            "      } catch (...) {",
+            "        delete loaded;",
+            "        throw;",
+            "      }",
+            "      adopt(loaded, static_cast<int>(sorted.size()));",
+            "      return;",
+            "    }",
+            "    T copy[SmallSize];",
+            "    std::copy(sorted.begin(), sorted.end(), copy);",
+            "    int n = static_cast<int>(sorted.size());",
+            "    std::move(copy, copy + n, small);",
+            "    delete tree;",
+            "    tree = nullptr;",
+            "    count = n;",
+            "  }",
+            "",
+            "  // Builds a new tree on the pool, then keeps the array form if the",
+            "  // deduplicated keys fit in SmallSize. If building throws the set is left",
+            "  // unchanged.",
+            "  void buildParallel(std::vector<T> data, ThreadPool &pool) {",
+            "    AVLAbstract<T, Comp> *loaded = new AVLAbstract<T, Comp>();",
+            "    int n = 0;",
+            "    try {",
+            "      loaded->buildParallel(std::move(data), pool);",
+            "      n = loaded->reduceParallel(",
+            "          pool, 0, [](const T &) { return 1; },",
+            "          [](int a, int b) { return a + b; });",
+            "    } catch (...) {",
+            "      delete loaded;",
+            "      throw;",
+            "    }",
+            "    adopt(loaded, n);",
+            "  }",
+            "",
+            "private:",
+            "  T small[SmallSize];",
+            "  AVLAbstract<T, Comp> *tree;",
+            "  int count;",
+            "",
+            "  // Branchless lower bound over small[0, count).",
+            "  int lowerBound(const T &val) const {",
+            "    int base = 0;",
+            "    int n = count;",
+            "    while (n > 1) {",
+            "      int half = n / 2;",
+            "      base = Comp(small[base + half - 1], val) ? base + half : base;",
+            "      n -= half;",
+            "    }",
+            "    return base + (n == 1 && Comp(small[base], val));",
+            "  }",
+            "",
+            "  template <typename U> bool insertValue(U &&val) {",
+            "    if (tree) {",
+            "      if (!tree->insert(std::forward<U>(val)))",
+            "        return false;",
+            "      count++;",
+            "      return true;",
+            "    }",
+            "",
+            "    int i = lowerBound(val);",
+            "    if (i < count && !Comp(val, small[i]))",
+            "      return false;",
+            "    if (count == SmallSize) {",
+            "      grow(std::forward<U>(val), i);",
+            "      return true;",
+            "    }",
+            "    for (int j = count; j > i; j--) {",
+            "      small[j] = std::move(small[j - 1]);",
+            "    }",
+            "    small[i] = std::forward<U>(val);",
+            "    count++;",
+            "    return true;",
+            "  }",
+            "",
+            "  // Moves the full array plus val (which belongs at index i) into a tree.",
+            "  template <typename U> void grow(U &&val, int i) {",
+            "    std::vector<T> sorted;",
+            "    sorted.reserve(count + 1);",
+            "    sorted.insert(sorted.end(), std::make_move_iterator(small),",
+            "                  std::make_move_iterator(small + i));",
+            "    sorted.push_back(std::forward<U>(val));",
+            "    sorted.insert(sorted.end(), std::make_move_iterator(small + i),",
+            "                  std::make_move_iterator(small + count));",
+            "",
+            "    tree = new AVLAbstract<T, Comp>();",
+            "    tree->assignSorted(sorted);",
+            "    count++;",
+            "  }",
+            "",
+            "  // Replaces the contents with loaded, which holds n keys.",
+            "  void adopt(AVLAbstract<T, Comp> *loaded, int n) {",
+            "    delete tree;",
+            "    tree = loaded;",
+            "    count = n;",
+            "    if (count <= SmallSize)",
+            "      shrink();",
+            "  }",
+            "",
+            "  // Prints small[lo, hi) as the balanced tree over it, right subtrees first",
+            "  // like AVLAbstract::print.",
+            "  void printRange(std::ostringstream &buffer, int lo, int hi,",
+            "                  int depth) const {",
+            "    if (lo >= hi)",
+            "      return;",
+            "    int mid = lo + (hi - lo) / 2;",
+            "    printRange(buffer, mid + 1, hi, depth + 1);",
+            "    for (int i = 0; i < depth; i++) {",
+            "      buffer << \"   \";",
+            "    }",
+            "    buffer << small[mid] << '\\n';",
+            "    printRange(buffer, lo, mid, depth + 1);",
+            "  }",
+            "",
+            "  void shrink() {",
+            "    int i = 0;",
+            "    tree->visitInOrder([this, &i](const T &val) { small[i++] = val; });",
+            "    delete tree;",
+            "    tree = nullptr;",
+            "  }",
+            "};",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T> using AVLTree = AVLAbstract<T, lessCompare<T>>;",
+            "template <typename T>",
+            "using AdaptiveAVLTree = AdaptiveAVLAbstract<T, lessCompare<T>>;"
+        ],
+        "threadSafe": true,
+        "arrayBacked": [
+            "#include <algorithm>",
+            "#include <cstdint>",
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "#include <vector>",
+            "",
+            "// Node stored by value in one contiguous array. Children are 32-bit indices;",
+            "// the balance factor (height(left) - height(right), from -1 to 1) is kept as",
+            "// balance + 1 in the top 2 bits of `left`, which leaves 30 bits per index.",
+            "template <typename T>",
+            "struct CompactNode {",
+            "  T val;",
+            "  uint32_t left;",
+            "  uint32_t right;",
+            "};",
+            "",
+            "// AVL tree with the same interface as AVLAbstract, but without a heap",
+            "// allocation or 64-bit pointers per node. Freed slots are reused through a",
+            "// free list threaded through `left`. Nodes refer to each other by index, so",
+            "// the default copy is a shape-preserving deep copy in one allocation. A move",
+            "// steals the array and leaves the source empty.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class CompactAVLAbstract {",
+            "public:",
+            "  CompactAVLAbstract() {",
+            "    root = NIL;",
+            "    freeHead = NIL;",
+            "    count = 0;",
+            "  }",
+            "",
+            "  CompactAVLAbstract(const CompactAVLAbstract &other) = default;",
+            "  CompactAVLAbstract &operator=(const CompactAVLAbstract &other) = default;",
+            "",
+            "  // The implicit move would leave root and freeHead pointing into the",
+            "  // stolen array.",
+            "  CompactAVLAbstract(CompactAVLAbstract &&other) noexcept",
+            "      : CompactAVLAbstract() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  CompactAVLAbstract &operator=(CompactAVLAbstract &&other) noexcept {",
+            "    CompactAVLAbstract taken(std::move(other));",
+            "    swap(taken);",
+            "    return *this;",
+            "  }",
+            "",
+            "  // Returns false if an equal key was already present.",
+            "  bool insert(const T &val) {",
+            "    bool grew = false;",
+            "    int before = count;",
+            "    root = insertNode(root, val, grew);",
+            "    return count > before;",
+            "  }",
+            "  bool insert(T &&val) {",
+            "    bool grew = false;",
+            "    int before = count;",
+            "    root = insertNode(root, std::move(val), grew);",
+            "    return count > before;",
+            "  }",
+            "  T *search(const T &val) {",
+            "    uint32_t node = root;",
+            "    while (node != NIL) {",
+            "      int r = compare(val, nodes[node].val);",
+            "      if (r < 0)",
+            "        node = getLeft(node);",
+            "      else if (r > 0)",
+            "        node = getRight(node);",
+            "      else",
+            "        return &(nodes[node].val);",
+            "    }",
+            "    return nullptr;",
+            "  }",
+            "  bool remove(const T &val) {",
+            "    bool removed = false;",
+            "    bool shrunk = false;",
+            "    root = removeNode(root, val, removed, shrunk);",
+            "    return removed;",
+            "  }",
+            "  void clear() {",
+            "    nodes.clear();",
+            "    root = NIL;",
+            "    freeHead = NIL;",
+            "    count = 0;",
+            "  }",
+            "",
+            "  void swap(CompactAVLAbstract &other) noexcept {",
+            "    nodes.swap(other.nodes);",
+            "    std::swap(root, other.root);",
+            "    std::swap(freeHead, other.freeHead);",
+            "    std::swap(count, other.count);",
+            "  }",
+            "",
+            "  void reserve(int n) { nodes.reserve(n); }",
+            "  int size() const { return count; }",
+            "  // Bytes held by the node array, including free and reserved slots.",
+            "  size_t memoryUsage() const {",
+            "    return nodes.capacity() * sizeof(CompactNode<T>);",
+            "  }",
+            "",
+            "  // Formats the whole tree into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    std::vector<std::pair<uint32_t, int>> stack;",
+            "    uint32_t node = root;",
+            "    int depth = 0;",
+            "    while (node != NIL || !stack.empty()) {",
+            "      while (node != NIL) {",
+            "        stack.push_back({node, depth});",
+            "        node = getRight(node);",
+            "        depth++;",
+            "      }",
+            "      node = stack.back().first;",
+            "      depth = stack.back().second;",
+            "      stack.pop_back();",
+            "",
+            "      for (int i = 0; i < depth; i++) {",
+            "        buffer << \"   \";",
+            "      }",
+            "      buffer << nodes[node].val << '\\n';",
+            "",
+            "      node = getLeft(node);",
+            "      depth++;",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "private:",
+            "  static const uint32_t NIL = 0x3FFFFFFF;",
+            "  static const uint32_t INDEX_MASK = 0x3FFFFFFF;",
+            "",
+            "  std::vector<CompactNode<T>> nodes;",
+            "  uint32_t root;",
+            "  uint32_t freeHead;",
+            "  int count;",
+            "",
+            "  static int compare(const T &a, const T &b) {",
+            "    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);",
+            "  }",
+            "",
+            "  uint32_t getLeft(uint32_t node) const {",
+            "    return nodes[node].left & INDEX_MASK;",
+            "  }",
+            "  uint32_t getRight(uint32_t node) const { return nodes[node].right; }",
+            "  int getBalance(uint32_t node) const {",
+            "    return static_cast<int>(nodes[node].left >> 30) - 1;",
+            "  }",
+            "",
+            "  void setLeft(uint32_t node, uint32_t child) {",
+            "    nodes[node].left = (nodes[node].left & ~INDEX_MASK) | child;",
+            "  }",
+            "  void setRight(uint32_t node, uint32_t child) { nodes[node].right = child; }",
+            "  void setBalance(uint32_t node, int balance) {",
+            "    nodes[node].left = (static_cast<uint32_t>(balance + 1) << 30) |",
+            "                       (nodes[node].left & INDEX_MASK);",
+            "  }",
+            "",
+            "  template <typename U> uint32_t allocNode(U &&val) {",
+            "    uint32_t node;",
+            "    if (freeHead != NIL) {",
+            "      node = freeHead;",
+            "      freeHead = nodes[node].left & INDEX_MASK;",
+            "      nodes[node].val = std::forward<U>(val);",
+            "    } else {",
+            "      if (nodes.size() >= NIL) {",
+            "        throw std::runtime_error(\"CompactAVL is full\");",
+            "      }",
+            "      node = static_cast<uint32_t>(nodes.size());",
+            "      nodes.push_back({std::forward<U>(val), 0, 0});",
+            "    }",
+            "    nodes[node].left = NIL;",
+            "    nodes[node].right = NIL;",
+            "    setBalance(node, 0);",
+            "    count++;",
+            "    return node;",
+            "  }",
+            "",
+            "  void freeNode(uint32_t node) {",
+            "    nodes[node].left = freeHead;",
+            "    freeHead = node;",
+            "    count--;",
+            "  }",
+            "",
+            "  // node is two levels heavier on the left. Rotates and returns the new",
+            "  // subtree root; shrunk tells whether the subtree lost a level.",
+            "  uint32_t fixLeft(uint32_t node, bool &shrunk) {",
+            "    uint32_t l = getLeft(node);",
+            "    int bl = getBalance(l);",
+            "",
+            "    // LL",
+            "    if (bl >= 0) {",
+            "      setLeft(node, getRight(l));",
+            "      setRight(l, node);",
+            "      setBalance(node, bl == 0 ? 1 : 0);",
+            "      setBalance(l, bl == 0 ? -1 : 0);",
+            "      shrunk = bl != 0;",
+            "      return l;",
+            "    }",
+            "",
+            "    // LR",
+            "    uint32_t lr = getRight(l);",
+            "    int b = getBalance(lr);",
+            "    setRight(l, getLeft(lr));",
+            "    setLeft(node, getRight(lr));",
+            "    setLeft(lr, l);",
+            "    setRight(lr, node);",
+            "    setBalance(node, b == 1 ? -1 : 0);",
+            "    setBalance(l, b == -1 ? 1 : 0);",
+            "    setBalance(lr, 0);",
+            "    shrunk = true;",
+            "    return lr;",
+            "  }",
+            "",
+            "  uint32_t fixRight(uint32_t node, bool &shrunk) {",
+            "    uint32_t r = getRight(node);",
+            "    int br = getBalance(r);",
+            "",
+            "    // RR",
+            "    if (br <= 0) {",
+            "      setRight(node, getLeft(r));",
+            "      setLeft(r, node);",
+            "      setBalance(node, br == 0 ? -1 : 0);",
+            "      setBalance(r, br == 0 ? 1 : 0);",
+            "      shrunk = br != 0;",
+            "      return r;",
+            "    }",
+            "",
+            "    // RL",
+            "    uint32_t rl = getLeft(r);",
+            "    int b = getBalance(rl);",
+            "    setLeft(r, getRight(rl));",
+            "    setRight(node, getLeft(rl));",
+            "    setRight(rl, r);",
+            "    setLeft(rl, node);",
+            "    setBalance(node, b == -1 ? 1 : 0);",
+            "    setBalance(r, b == 1 ? -1 : 0);",
+            "    setBalance(rl, 0);",
+            "    shrunk = true;",
+            "    return rl;",
+            "  }",
+            "",
+            "  // U is T or const T&; val is moved into the new node.",
+            "  template <typename U>",
+            "  uint32_t insertNode(uint32_t node, U &&val, bool &grew) {",
+            "    if (node == NIL) {",
+            "      grew = true;",
+            "      return allocNode(std::forward<U>(val));",
+            "    }",
+            "",
+            "    int r = compare(val, nodes[node].val);",
+            "    if (r == 0) {",
+            "      grew = false;",
+            "      return node;",
+            "    }",
+            "",
+            "    bool shrunk = false;",
+            "    if (r < 0) {",
+            "      setLeft(node, insertNode(getLeft(node), std::forward<U>(val), grew));",
+            "      if (!grew)",
+            "        return node;",
+            "      int b = getBalance(node);",
+            "      if (b < 1) {",
+            "        setBalance(node, b + 1);",
+            "        grew = b == 0;",
+            "        return node;",
+            "      }",
+            "      grew = false;",
+            "      return fixLeft(node, shrunk);",
+            "    }",
+            "",
+            "    setRight(node, insertNode(getRight(node), std::forward<U>(val), grew));",
+            "    if (!grew)",
+            "      return node;",
+            "    int b = getBalance(node);",
+            "    if (b > -1) {",
+            "      setBalance(node, b - 1);",
+            "      grew = b == 0;",
+            "      return node;",
+            "    }",
+            "    grew = false;",
+            "    return fixRight(node, shrunk);",
+            "  }",
+            "",
+            "  // The left subtree of node lost a level.",
+            "  uint32_t leftShrunk(uint32_t node, bool &shrunk) {",
+            "    int b = getBalance(node);",
+            "    if (b > -1) {",
+            "      setBalance(node, b - 1);",
+            "      shrunk = b == 1;",
+            "      return node;",
+            "    }",
+            "    return fixRight(node, shrunk);",
+            "  }",
+            "",
+            "  // The right subtree of node lost a level.",
+            "  uint32_t rightShrunk(uint32_t node, bool &shrunk) {",
+            "    int b = getBalance(node);",
+            "    if (b < 1) {",
+            "      setBalance(node, b + 1);",
+            "      shrunk = b == -1;",
+            "      return node;",
+            "    }",
+            "    return fixLeft(node, shrunk);",
+            "  }",
+            "",
+            "  uint32_t removeMin(uint32_t node, uint32_t &minNode, bool &shrunk) {",
+            "    if (getLeft(node) == NIL) {",
+            "      minNode = node;",
+            "      shrunk = true;",
+            "      return getRight(node);",
+            "    }",
+            "    setLeft(node, removeMin(getLeft(node), minNode, shrunk));",
+            "    return shrunk ? leftShrunk(node, shrunk) : node;",
+            "  }",
+            "",
+            "  uint32_t removeNode(uint32_t node, const T &val, bool &removed,",
+            "                      bool &shrunk) {",
+            "    if (node == NIL) {",
+            "      shrunk = false;",
+            "      return NIL;",
+            "    }",
+            "",
+            "    int r = compare(val, nodes[node].val);",
+            "    if (r < 0) {",
+            "      setLeft(node, removeNode(getLeft(node), val, removed, shrunk));",
+            "      return shrunk ? leftShrunk(node, shrunk) : node;",
+            "    }",
+            "    if (r > 0) {",
+            "      setRight(node, removeNode(getRight(node), val, removed, shrunk));",
+            "      return shrunk ? rightShrunk(node, shrunk) : node;",
+            "    }",
+            "",
+            "    removed = true;",
+            "    if (getLeft(node) == NIL || getRight(node) == NIL) {",
+            "      uint32_t child = getLeft(node) == NIL ? getRight(node) : getLeft(node);",
+            "      freeNode(node);",
+            "      shrunk = true;",
+            "      return child;",
+            "    }",
+            "",
+            "    uint32_t successor = NIL;",
+            "    setRight(node, removeMin(getRight(node), successor, shrunk));",
+            "    nodes[node].val = std::move(nodes[successor].val);",
+            "    freeNode(successor);",
+            "    return shrunk ? rightShrunk(node, shrunk) : node;",
+            "  }",
+            "};",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T>",
+            "using CompactAVLTree = CompactAVLAbstract<T, lessCompare<T>>;"
+        ]
+    },
+    {
+        "label": "Binary Search Tree",
+        "body": [
+            "#include <algorithm>",
+            "#include <cstdint>",
+            "#include <cstring>",
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <type_traits>",
+            "#include <utility>",
+            "#include <vector>",
+            "",
+            "template <typename T>",
+            "struct Node {",
+            "  T val;",
+            "  Node *left = nullptr;",
+            "  Node *right = nullptr;",
+            "  int count = 1; // copies of val, equal keys never get their own node",
+            "  Node(T v) : val(std::move(v)) {}",
+            "};",
+            "",
+            "// Binary dump layout: header followed by `count` raw elements. T must be",
+            "// trivially copyable, so the file can also be mmapped and searched in place.",
+            "struct DumpHeader {",
+            "  char magic[4];",
+            "  uint32_t elemSize;",
+            "  uint64_t count;",
+            "};",
+            "",
+            "// Reads the `count` elements that follow a DumpHeader into out. count comes",
+            "// from the file, so it is checked against the bytes left in the stream",
+            "// before out is sized. A stream that cannot seek is read in bounded steps",
+            "// instead, so a corrupt count ends in a short read, not a huge allocation.",
+            "template <typename T>",
+            "bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {",
+            "  uint64_t step = count;",
+            "  std::streampos here = in.tellg();",
+            "  if (here != std::streampos(-1) && in.seekg(0, std::ios::end)) {",
+            "    uint64_t left = static_cast<uint64_t>(in.tellg() - here);",
+            "    in.seekg(here);",
+            "    if (count > left / sizeof(T))",
+            "      return false;",
+            "  } else {",
+            "    in.clear();",
+            "    step = 1 << 16;",
+            "  }",
+            "  out.clear();",
+            "  while (out.size() < count) {",
+            "    size_t done = out.size();",
+            "    size_t n = static_cast<size_t>(std::min<uint64_t>(step, count - done));",
+            "    out.resize(done + n);",
+            "    in.read(reinterpret_cast<char *>(out.data() + done), n * sizeof(T));",
+            "    if (!in)",
+            "      return false;",
+            "  }",
+            "  return true;",
+            "}",
+            "",
+            "// Immutable search array in Eytzinger (BFS) order produced by freeze(). Node",
+            "// k has children 2k and 2k + 1, so the top levels share a few cache lines and",
+            "// lookup is a branchless descent that prefetches four levels ahead.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class FrozenTree {",
+            "public:",
+            "  explicit FrozenTree(const std::vector<T> &sorted) {",
+            "    arr.resize(sorted.size() + 1);",
+            "    int pos = 0;",
+            "    build(sorted, pos, 1);",
+            "  }",
+            "",
+            "  const T *search(const T &val) const {",
+            "    const int n = size();",
+            "    const int block = sizeof(T) < 64 ? 64 / sizeof(T) : 1;",
+            "    int k = 1;",
+            "    while (k <= n) {",
+            "#if defined(__GNUC__) || defined(__clang__)",
+            "      __builtin_prefetch(arr.data() + static_cast<size_t>(k) * block);",
+            "#endif",
+            "      k = 2 * k + Comp(arr[k], val);",
+            "    }",
+            "    // undo the trailing right turns to get the lower bound",
+            "    while (k & 1)",
+            "      k >>= 1;",
+            "    k >>= 1;",
+            "    if (k == 0 || Comp(val, arr[k]))",
+            "      return nullptr;",
+            "    return &arr[k];",
+            "  }",
+            "",
+            "  int size() const { return static_cast<int>(arr.size()) - 1; }",
+            "  bool empty() const { return size() == 0; }",
+            "",
+            "private:",
+            "  std::vector<T> arr; // arr[0] unused",
+            "",
+            "  void build(const std::vector<T> &sorted, int &pos, int k) {",
+            "    if (k > size())",
+            "      return;",
+            "    build(sorted, pos, 2 * k);",
+            "    arr[k] = sorted[pos++];",
+            "    build(sorted, pos, 2 * k + 1);",
+            "  }",
+            "};",
+            "",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class BSTAbstract {",
+            "public:",
+            "  BSTAbstract() { root = nullptr; }",
+            "",
+            "  // Deep copy with the same shape as other, see cloneTree.",
+            "  BSTAbstract(const BSTAbstract &other) { root = cloneTree(other.root); }",
+            "",
+            "  BSTAbstract(BSTAbstract &&other) noexcept {",
+            "    root = other.root;",
+            "    other.root = nullptr;",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  BSTAbstract &operator=(BSTAbstract other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~BSTAbstract() { clear(root); }",
+            "",
+            "  void swap(BSTAbstract &other) noexcept { std::swap(root, other.root); }",
+            "",
+            "  void insert(const T &val) { insertNode(root, val); }",
+            "  void insert(T &&val) { insertNode(root, std::move(val)); }",
+            "  T *search(const T &val) { return searchNode(root, val); }",
+            "  bool remove(const T &val) { return removeOne(val); }",
+            "  bool removeOne(const T &val) { return removeNode(root, val, false) > 0; }",
+            "  // Removes every copy of val and returns how many there were.",
+            "  int removeAll(const T &val) { return removeNode(root, val, true); }",
+            "  int count(const T &val) {",
+            "    Node<T> *node = root;",
+            "    while (node) {",
+            "      int r = compare(val, node->val);",
+            "      if (r == 0)",
+            "        return node->count;",
+            "      node = r < 0 ? node->left : node->right;",
+            "    }",
+            "    return 0;",
+            "  }",
+            "  void clear() {",
+            "    clear(root);",
+            "    root = nullptr;",
+            "  }",
+            "",
+            "  // Looks up every key in keys and stores the result (or nullptr) at the same",
+            "  // index of out. Descents run in groups that advance one level per round, so",
+            "  // the cache misses of different keys overlap instead of queueing up.",
+            "  void searchBatch(const std::vector<T> &keys, std::vector<T *> &out) {",
+            "    const size_t group = 16;",
+            "    Node<T> *cursor[group];",
+            "    out.assign(keys.size(), nullptr);",
+            "",
+            "    for (size_t base = 0; base < keys.size(); base += group) {",
+            "      size_t n = std::min(group, keys.size() - base);",
+            "      for (size_t i = 0; i < n; i++) {",
+            "        cursor[i] = root;",
+            "      }",
+            "",
+            "      size_t active = n;",
+            "      while (active > 0) {",
+            "        active = 0;",
+            "        for (size_t i = 0; i < n; i++) {",
+            "          Node<T> *node = cursor[i];",
+            "          if (!node)",
+            "            continue;",
+            "",
+            "          int r = compare(keys[base + i], node->val);",
+            "          if (r == 0) {",
+            "            out[base + i] = &(node->val);",
+            "            cursor[i] = nullptr;",
+            "            continue;",
+            "          }",
+            "",
+            "          node = r < 0 ? node->left : node->right;",
+            "#if defined(__GNUC__) || defined(__clang__)",
+            "          if (node)",
+            "            __builtin_prefetch(node);",
+            "#endif",
+            "          cursor[i] = node;",
+            "          if (node)",
+            "            active++;",
+            "        }",
+            "      }",
+            "    }",
+            "  }",
+            "",
+            "  // Formats the whole tree into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Tree structure:\" << '\\n';",
+            "    std::vector<std::pair<Node<T> *, int>> stack;",
+            "    Node<T> *node = root;",
+            "    int depth = 0;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back({node, depth});",
+            "        node = node->right;",
+            "        depth++;",
+            "      }",
+            "      node = stack.back().first;",
+            "      depth = stack.back().second;",
+            "      stack.pop_back();",
+            "",
+            "      for (int i = 0; i < depth; i++) {",
+            "        buffer << \"   \";",
+            "      }",
+            "      buffer << node->val;",
+            "      if (node->count > 1) {",
+            "        buffer << \" (x\" << node->count << \")\";",
+            "      }",
+            "      buffer << '\\n';",
+            "",
+            "      node = node->left;",
+            "      depth++;",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(val) for every key in sorted order, once per copy, without",
+            "  // recursion.",
+            "  template <typename Fn> void visitInOrder(Fn fn) const {",
+            "    visitNodesInOrder([&fn](const Node<T> *node) {",
+            "      for (int i = 0; i < node->count; i++) {",
+            "        fn(node->val);",
+            "      }",
+            "    });",
+            "  }",
+            "",
+            "  // Calls fn(val, depth) level by level, root first, once per node.",
+            "  template <typename Fn> void visitLevelOrder(Fn fn) const {",
+            "    std::vector<std::pair<Node<T> *, int>> level;",
+            "    if (root)",
+            "      level.push_back({root, 0});",
+            "    for (size_t i = 0; i < level.size(); i++) {",
+            "      Node<T> *node = level[i].first;",
+            "      int depth = level[i].second;",
+            "      fn(node->val, depth);",
+            "      if (node->left)",
+            "        level.push_back({node->left, depth + 1});",
+            "      if (node->right)",
+            "        level.push_back({node->right, depth + 1});",
+            "    }",
+            "  }",
+            "",
+            "  // Snapshot of the current keys for read-only phases, see FrozenTree.",
+            "  FrozenTree<T, Comp> freeze() const {",
+            "    std::vector<T> sorted;",
+            "    visitNodesInOrder([&sorted](const Node<T> *node) {",
+            "      sorted.push_back(node->val);",
+            "    });",
+            "    return FrozenTree<T, Comp>(sorted);",
+            "  }",
+            "",
+            "  // Writes the keys as a sorted array, see DumpHeader.",
+            "  void serialize(std::ostream &out) const {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"serialize requires a trivially copyable T\");",
+            "    std::vector<T> sorted;",
+            "    collect(sorted);",
+            "    DumpHeader header = {{'D', 'S', 'T', 'R'}, sizeof(T), sorted.size()};",
+            "    out.write(reinterpret_cast<const char *>(&header), sizeof(header));",
+            "    out.write(reinterpret_cast<const char *>(sorted.data()),",
+            "              sorted.size() * sizeof(T));",
+            "    if (!out) {",
+            "      throw std::runtime_error(\"Failed to write tree dump\");",
+            "    }",
+            "  }",
+            "",
+            "  // Replaces the contents with a dump written by serialize(). The tree is",
+            "  // built balanced from the sorted array in O(n), without re-inserting.",
+            "  void deserialize(std::istream &in) {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"deserialize requires a trivially copyable T\");",
+            "    DumpHeader header;",
+            "    in.read(reinterpret_cast<char *>(&header), sizeof(header));",
+            "    if (!in || std::memcmp(header.magic, \"DSTR\", 4) != 0 ||",
+            "        header.elemSize != sizeof(T)) {",
+            "      throw std::runtime_error(\"Invalid tree dump\");",
+            "    }",
+            "    std::vector<T> sorted;",
+            "    if (!readDumpElements(in, header.count, sorted)) {",
+            "      throw std::runtime_error(\"Truncated tree dump\");",
+            "    }",
+            "    // Copies of a key are written once each, so keys may repeat but must",
+            "    // never decrease.",
+            "    std::vector<std::pair<T, int>> runs;",
+            "    for (const T &val : sorted) {",
+            "      if (!runs.empty() && Comp(val, runs.back().first))",
+            "        throw std::runtime_error(\"Unsorted tree dump\");",
+            "      if (!runs.empty() && !Comp(runs.back().first, val))",
+            "        runs.back().second++;",
+            "      else",
+            "        runs.push_back({val, 1});",
+            "    }",
+            "    // Built before the old tree is freed, so a throw leaves it unchanged.",
+            "    Node<T> *fresh = build(runs, 0, static_cast<int>(runs.size()));",
+            "    clear(root);",
+            "    root = fresh;",
+            "  }",
+            "",
+            "private:",
+            "  Node<T> *root;",
+            "",
+            "  static int compare(const T &a, const T &b) {",
+            "    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);",
+            "  }",
+            "",
+            "  // U is T or const T&; val is moved into the new node, never copied on the",
+            "  // way down.",
+            "  template <typename U> void insertNode(Node<T> *&node, U &&val) {",
+            "    if (node == nullptr) {",
+            "      node = new Node<T>(std::forward<U>(val));",
+            "      return;",
+            "    }",
+            "",
+            "    int r = compare(val, node->val);",
+            "    if (r < 0) {",
+            "      insertNode(node->left, std::forward<U>(val));",
+            "    } else if (r > 0) {",
+            "      insertNode(node->right, std::forward<U>(val));",
+            "    } else {",
+            "      node->count++;",
+            "    }",
+            "  }",
+            "",
+            "  T *searchNode(Node<T> *node, const T &val) {",
+            "    if (node == nullptr) {",
+            "      return nullptr;",
+            "    }",
+            "",
+            "    int r = compare(val, node->val);",
+            "",
+            "    if (r < 0) {",
+            "      return searchNode(node->left, val);",
+            "    } else if (r > 0) {",
+            "      return searchNode(node->right, val);",
+            "    } else {",
+            "      return &(node->val);",
+            "    }",
+            "  }",
+            "",
+            "  // Removes one copy of val, or all of them if all is set, and returns the",
+            "  // number of copies removed.",
+            "  int removeNode(Node<T> *&node, const T &val, bool all) {",
+            "    if (node == nullptr) {",
+            "      return 0;",
+            "    }",
+            "",
+            "    int r = compare(val, node->val);",
+            "",
+            "    if (r < 0) {",
+            "      return removeNode(node->left, val, all);",
+            "    } else if (r > 0) {",
+            "      return removeNode(node->right, val, all);",
+            "    } else {",
+            "      if (!all && node->count > 1) {",
+            "        node->count--;",
+            "        return 1;",
+            "      }",
+            "",
+            "      int removed = node->count;",
+            "      if (node->left == nullptr && node->right == nullptr) {",
+            "        delete node;",
+            "        node = nullptr;",
+            "      } else if (node->left == nullptr) {",
+            "        Node<T> *temp = node;",
+            "        node = node->right;",
+            "        delete temp;",
+            "      } else if (node->right == nullptr) {",
+            "        Node<T> *temp = node;",
+            "        node = node->left;",
+            "        delete temp;",
+            "      } else {",
+            "        Node<T> *successor = findMin(node->right);",
+            "        node->val = successor->val;",
+            "        node->count = successor->count;",
+            "        removeNode(node->right, node->val, true);",
+            "      }",
+            "      return removed;",
+            "    }",
+            "  }",
+            "",
+            "  Node<T> *findMin(Node<T> *node) {",
+            "    while (node->left != nullptr) {",
+            "      node = node->left;",
+            "    }",
+            "    return node;",
+            "  }",
+            "",
+            "  template <typename Fn> void visitNodesInOrder(Fn fn) const {",
+            "    std::vector<Node<T> *> stack;",
+            "    Node<T> *node = root;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back(node);",
+            "        node = node->left;",
+            "      }",
+            "      node = stack.back();",
+            "      stack.pop_back();",
+            "      fn(node);",
+            "      node = node->right;",
+            "    }",
+            "  }",
+            "",
+            "  void collect(std::vector<T> &out) const {",
+            "    visitInOrder([&out](const T &val) { out.push_back(val); });",
+            "  }",
+            "",
+            "  // Balanced subtree over runs[lo, hi) of (key, copies). If allocating or",
+            "  // copying a key throws, the part built so far is freed.",
+            "  Node<T> *build(const std::vector<std::pair<T, int>> &runs, int lo, int hi) {",
+            "    if (lo >= hi)",
+            "      return nullptr;",
+            "    int mid = lo + (hi - lo) / 2;",
+            "    Node<T> *node = new Node<T>(runs[mid].first);",
+            "    node->count = runs[mid].second;",
+            "    try {",
+            "      node->left = build(runs, lo, mid);",
+            "      node->right = build(runs, mid + 1, hi);",
+            "    } catch (...) {",
+            "      clear(node);",
+            "      throw;",
+            "    }",
+            "    return node;",
+            "  }",
+            "",
+            "  // Copies src node by node with an explicit stack, keeping its shape, so a",
+            "  // degenerate tree is copied without deep recursion. If copying a value",
+            "  // throws, the partial copy is freed.",
+            "  static Node<T> *cloneTree(const Node<T> *src) {",
+            "    if (!src)",
+            "      return nullptr;",
+            "",
+            "    Node<T> *copy = cloneNode(src);",
+            "    std::vector<std::pair<const Node<T> *, Node<T> *>> stack;",
+            "    stack.push_back({src, copy});",
+            "    try {",
+            "      while (!stack.empty()) {",
+            "        const Node<T> *from = stack.back().first;",
+            "        Node<T> *to = stack.back().second;",
+            "        stack.pop_back();",
+            "        if (from->right) {",
+            "          to->right = cloneNode(from->right);",
+            "          stack.push_back({from->right, to->right});",
+            "        }",
+            "        if (from->left) {",
+            "          to->left = cloneNode(from->left);",
+            "          stack.push_back({from->left, to->left});",
+            "        }",
+            "      }",
+            "    } catch (...) {",
+            "      clear(copy);",
+            "      throw;",
+            "    }",
+            "    return copy;",
+            "  }",
+            "",
+            "  static Node<T> *cloneNode(const Node<T> *src) {",
+            "    Node<T> *node = new Node<T>(src->val);",
+            "    node->count = src->count;",
+            "    return node;",
+            "  }",
+            "",
+            "  static void clear(Node<T> *node) {",
+            "    if (!node)",
+            "      return;",
+            "    clear(node->left);",
+            "    clear(node->right);",
+            "    delete node;",
+            "  }",
+            "};",
+            "",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "void swap(BSTAbstract<T, Comp> &a, BSTAbstract<T, Comp> &b) noexcept {",
+            "  a.swap(b);",
+            "}",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T> using BST = BSTAbstract<T, lessCompare<T>>;"
+        ],
+        "threadSafe": true
+    },
+    {
+        "label": "Red-Black Tree",
+        "body": [
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <utility>",
+            "#include <vector>",
+            "",
+            "template <typename T>",
+            "struct Node {",
+            "  T val;",
+            "  Node *left = nullptr;",
+            "  Node *right = nullptr;",
+            "  Node *parent = nullptr;",
+            "  bool red = true;",
+            "",
+            "  Node(T v) : val(std::move(v)) {}",
+            "};",
+            "",
+            "// Red-black tree with the same interface as AVLAbstract. Insert does at most",
+            "// 2 rotations and remove at most 3, recoloring is the only O(log n) work.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class RBAbstract {",
+            "public:",
+            "  RBAbstract() { root = nullptr; }",
+            "",
+            "  // Deep copy with the same shape and colors as other, see cloneTree.",
+            "  RBAbstract(const RBAbstract &other) { root = cloneTree(other.root); }",
+            "",
+            "  RBAbstract(RBAbstract &&other) noexcept {",
+            "    root = other.root;",
+            "    other.root = nullptr;",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  RBAbstract &operator=(RBAbstract other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~RBAbstract() { clear(root); }",
+            "",
+            "  void swap(RBAbstract &other) noexcept { std::swap(root, other.root); }",
+            "",
+            "  // Returns false if an equal key was already present.",
+            "  bool insert(const T &val) { return insertNode(val); }",
+            "  bool insert(T &&val) { return insertNode(std::move(val)); }",
+            "  T *search(const T &val) {",
+            "    Node<T> *node = findNode(val);",
+            "    return node ? &(node->val) : nullptr;",
+            "  }",
+            "  bool remove(const T &val) {",
+            "    Node<T> *node = findNode(val);",
+            "    if (!node)",
+            "      return false;",
+            "    removeNode(node);",
+            "    return true;",
+            "  }",
+            "  void clear() {",
+            "    clear(root);",
+            "    root = nullptr;",
+            "  }",
+            "",
+            "  // Formats the whole tree into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    std::vector<std::pair<Node<T> *, int>> stack;",
+            "    Node<T> *node = root;",
+            "    int depth = 0;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back({node, depth});",
+            "        node = node->right;",
+            "        depth++;",
+            "      }",
+            "      node = stack.back().first;",
+            "      depth = stack.back().second;",
+            "      stack.pop_back();",
+            "",
+            "      for (int i = 0; i < depth; i++) {",
+            "        buffer << \"   \";",
+            "      }",
+            "      buffer << node->val << (node->red ? \"r\" : \"b\") << '\\n';",
+            "",
+            "      node = node->left;",
+            "      depth++;",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(val) for every key in sorted order, without recursion.",
+            "  template <typename Fn> void visitInOrder(Fn fn) const {",
+            "    std::vector<Node<T> *> stack;",
+            "    Node<T> *node = root;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back(node);",
+            "        node = node->left;",
+            "      }",
+            "      node = stack.back();",
+            "      stack.pop_back();",
+            "      fn(node->val);",
+            "      node = node->right;",
+            "    }",
+            "  }",
+            "",
+            "  // Calls fn(val, depth) level by level, root first.",
+            "  template <typename Fn> void visitLevelOrder(Fn fn) const {",
+            "    std::vector<std::pair<Node<T> *, int>> level;",
+            "    if (root)",
+            "      level.push_back({root, 0});",
+            "    for (size_t i = 0; i < level.size(); i++) {",
+            "      Node<T> *node = level[i].first;",
+            "      int depth = level[i].second;",
+            "      fn(node->val, depth);",
+            "      if (node->left)",
+            "        level.push_back({node->left, depth + 1});",
+            "      if (node->right)",
+            "        level.push_back({node->right, depth + 1});",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  Node<T> *root;",
+            "",
+            "  static int compare(const T &a, const T &b) {",
+            "    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);",
+            "  }",
+            "",
+            "  bool isRed(Node<T> *node) { return node && node->red; }",
+            "",
+            "  void replaceChild(Node<T> *parent, Node<T> *oldChild, Node<T> *newChild) {",
+            "    if (!parent) {",
+            "      root = newChild;",
+            "    } else if (parent->left == oldChild) {",
+            "      parent->left = newChild;",
+            "    } else {",
+            "      parent->right = newChild;",
+            "    }",
+            "    if (newChild)",
+            "      newChild->parent = parent;",
+            "  }",
+            "",
+            "  void rotateLeft(Node<T> *x) {",
+            "    Node<T> *y = x->right;",
+            "    x->right = y->left;",
+            "    if (y->left)",
+            "      y->left->parent = x;",
+            "    replaceChild(x->parent, x, y);",
+            "    y->left = x;",
+            "    x->parent = y;",
+            "  }",
+            "",
+            "  void rotateRight(Node<T> *y) {",
+            "    Node<T> *x = y->left;",
+            "    y->left = x->right;",
+            "    if (x->right)",
+            "      x->right->parent = y;",
+            "    replaceChild(y->parent, y, x);",
+            "    x->right = y;",
+            "    y->parent = x;",
+            "  }",
+            "",
+            "  Node<T> *findNode(const T &val) {",
+            "    Node<T> *node = root;",
+            "    while (node) {",
+            "      int r = compare(val, node->val);",
+            "      if (r < 0)",
+            "        node = node->left;",
+            "      else if (r > 0)",
+            "        node = node->right;",
+            "      else",
+            "        return node;",
+            "    }",
+            "    return nullptr;",
+            "  }",
+            "",
+            "  // U is T or const T&; val is moved into the new node.",
+            "  template <typename U> bool insertNode(U &&val) {",
+            "    Node<T> *parent = nullptr;",
+            "    Node<T> *cur = root;",
+            "    int r = 0;",
+            "    while (cur) {",
+            "      r = compare(val, cur->val);",
+            "      if (r == 0)",
+            "        return false;",
+            "      parent = cur;",
+            "      cur = r < 0 ? cur->left : cur->right;",
+            "    }",
+            "",
+            "    Node<T> *node = new Node<T>(std::forward<U>(val));",
+            "    node->parent = parent;",
+            "    if (!parent)",
+            "      root = node;",
+            "    else if (r < 0)",
+            "      parent->left = node;",
+            "    else",
+            "      parent->right = node;",
+            "",
+            "    insertFixup(node);",
+            "    return true;",
+            "  }",
+            "",
+            "  void insertFixup(Node<T> *node) {",
+            "    while (isRed(node->parent)) {",
+            "      Node<T> *parent = node->parent;",
+            "      Node<T> *grand = parent->parent;",
+            "",
+            "      if (parent == grand->left) {",
+            "        Node<T> *uncle = grand->right;",
+            "        if (isRed(uncle)) {",
+            "          parent->red = false;",
+            "          uncle->red = false;",
+            "          grand->red = true;",
+            "          node = grand;",
+            "          continue;",
+            "        }",
+            "        if (node == parent->right) {",
+            "          rotateLeft(parent);",
+            "          node = parent;",
+            "          parent = node->parent;",
+            "        }",
+            "        parent->red = false;",
+            "        grand->red = true;",
+            "        rotateRight(grand);",
+            "      } else {",
+            "        Node<T> *uncle = grand->left;",
+            "        if (isRed(uncle)) {",
+            "          parent->red = false;",
+            "          uncle->red = false;",
+            "          grand->red = true;",
+            "          node = grand;",
+            "          continue;",
+            "        }",
+            "        if (node == parent->left) {",
+            "          rotateRight(parent);",
+            "          node = parent;",
+            "          parent = node->parent;",
+            "        }",
+            "        parent->red = false;",
+            "        grand->red = true;",
+            "        rotateLeft(grand);",
+            "      }",
+            "    }",
+            "    root->red = false;",
+            "  }",
+            "",
+            "  Node<T> *findMin(Node<T> *node) {",
+            "    while (node && node->left) {",
+            "      node = node->left;",
+            "    }",
+            "    return node;",
+            "  }",
+            "",
+            "  void removeNode(Node<T> *node) {",
+            "    if (node->left && node->right) {",
+            "      Node<T> *successor = findMin(node->right);",
+            "      node->val = std::move(successor->val);",
+            "      node = successor;",
+            "    }",
+            "",
+            "    // node has at most one child now",
+            "    Node<T> *child = node->left ? node->left : node->right;",
+            "    Node<T> *parent = node->parent;",
+            "    bool wasBlack = !node->red;",
+            "",
+            "    replaceChild(parent, node, child);",
+            "    delete node;",
+            "",
+            "    if (wasBlack)",
+            "      removeFixup(child, parent);",
+            "  }",
+            "",
+            "  void removeFixup(Node<T> *node, Node<T> *parent) {",
+            "    while (node != root && !isRed(node)) {",
+            "      if (node == parent->left) {",
+            "        Node<T> *sibling = parent->right;",
+            "        if (isRed(sibling)) {",
+            "          sibling->red = false;",
+            "          parent->red = true;",
+            "          rotateLeft(parent);",
+            "          sibling = parent->right;",
+            "        }",
+            "        if (!isRed(sibling->left) && !isRed(sibling->right)) {",
+            "          sibling->red = true;",
+            "          node = parent;",
+            "          parent = node->parent;",
+            "          continue;",
+            "        }",
+            "        if (!isRed(sibling->right)) {",
+            "          sibling->left->red = false;",
+            "          sibling->red = true;",
+            "          rotateRight(sibling);",
+            "          sibling = parent->right;",
+            "        }",
+            "        sibling->red = parent->red;",
+            "        parent->red = false;",
+            "        sibling->right->red = false;",
+            "        rotateLeft(parent);",
+            "        node = root;",
+            "      } else {",
+            "        Node<T> *sibling = parent->left;",
+            "        if (isRed(sibling)) {",
+            "          sibling->red = false;",
+            "          parent->red = true;",
+            "          rotateRight(parent);",
+            "          sibling = parent->left;",
+            "        }",
+            "        if (!isRed(sibling->left) && !isRed(sibling->right)) {",
+            "          sibling->red = true;",
+            "          node = parent;",
+            "          parent = node->parent;",
+            "          continue;",
+            "        }",
+            "        if (!isRed(sibling->left)) {",
+            "          sibling->right->red = false;",
+            "          sibling->red = true;",
+            "          rotateLeft(sibling);",
+            "          sibling = parent->left;",
+            "        }",
+            "        sibling->red = parent->red;",
+            "        parent->red = false;",
+            "        sibling->left->red = false;",
+            "        rotateRight(parent);",
+            "        node = root;",
+            "      }",
+            "    }",
+            "    if (node)",
+            "      node->red = false;",
+            "  }",
+            "",
+            "  // Copies src node by node with an explicit stack, keeping its shape and",
+            "  // colors, so no fixup runs. If copying a value throws, the partial copy is",
+            "  // freed.",
+            "  static Node<T> *cloneTree(const Node<T> *src) {",
+            "    if (!src)",
+            "      return nullptr;",
+            "",
+            "    Node<T> *copy = cloneNode(src, nullptr);",
+            "    std::vector<std::pair<const Node<T> *, Node<T> *>> stack;",
+            "    stack.push_back({src, copy});",
+            "    try {",
+            "      while (!stack.empty()) {",
+            "        const Node<T> *from = stack.back().first;",
+            "        Node<T> *to = stack.back().second;",
+            "        stack.pop_back();",
+            "        if (from->right) {",
+            "          to->right = cloneNode(from->right, to);",
+            "          stack.push_back({from->right, to->right});",
+            "        }",
+            "        if (from->left) {",
+            "          to->left = cloneNode(from->left, to);",
+            "          stack.push_back({from->left, to->left});",
+            "        }",
+            "      }",
+            "    } catch (...) {",
+            "      clear(copy);",
+            "      throw;",
+            "    }",
+            "    return copy;",
+            "  }",
+            "",
+            "  static Node<T> *cloneNode(const Node<T> *src, Node<T> *parent) {",
+            "    Node<T> *node = new Node<T>(src->val);",
+            "    node->parent = parent;",
+            "    node->red = src->red;",
+            "    return node;",
+            "  }",
+            "",
+            "  static void clear(Node<T> *node) {",
+            "    if (!node)",
+            "      return;",
+            "    clear(node->left);",
+            "    clear(node->right);",
+            "    delete node;",
+            "  }",
+            "};",
+            "",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "void swap(RBAbstract<T, Comp> &a, RBAbstract<T, Comp> &b) noexcept {",
+            "  a.swap(b);",
+            "}",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T> using RBTree = RBAbstract<T, lessCompare<T>>;"
+        ],
+        "threadSafe": true
+    },
+    {
+        "label": "Persistent AVL Tree",
+        "body": [
+            "#include <iostream>",
+            "#include <memory>",
+            "#include <sstream>",
+            "#include <thread>",
+            "#include <utility>",
+            "#include <vector>",
+            "",
+            "template <typename T>",
+            "struct Node {",
+            "  T val;",
+            "  std::shared_ptr<const Node> left;",
+            "  std::shared_ptr<const Node> right;",
+            "  int height = 1;",
+            "",
+            "  Node(T v, std::shared_ptr<const Node> l, std::shared_ptr<const Node> r)",
+            "      : val(std::move(v)), left(std::move(l)), right(std::move(r)) {",
+            "    int hl = left ? left->height : 0;",
+            "    int hr = right ? right->height : 0;",
+            "    height = std::max(hl, hr) + 1;",
+            "  }",
+            "};",
+            "",
+            "// Persistent AVL tree. Nodes are immutable and shared between versions:",
+            "// insert/remove copy only the O(log n) nodes on the search path and return a",
+            "// new version, so copying a tree is an O(1) snapshot and the implicit copy",
+            "// and move operations are already cheap and safe. Unreachable nodes are",
+            "// freed by reference counting when the last version using them goes away.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class PersistentAVLAbstract {",
+            "public:",
+            "  using NodePtr = std::shared_ptr<const Node<T>>;",
+            "",
+            "  PersistentAVLAbstract() { root = nullptr; }",
+            "",
+            "  // If val is already present, returns the same version without copying.",
+            "  PersistentAVLAbstract insert(const T &val) const {",
+            "    bool inserted = false;",
+            "    return PersistentAVLAbstract(insertNode(root, val, inserted));",
+            "  }",
+            "  PersistentAVLAbstract insert(T &&val) const {",
+            "    bool inserted = false;",
+            "    return PersistentAVLAbstract(insertNode(root, std::move(val), inserted));",
+            "  }",
+            "  const T *search(const T &val) const { return searchNode(root.get(), val); }",
+            "  PersistentAVLAbstract remove(const T &val) const {",
+            "    bool removed = false;",
+            "    return remove(val, removed);",
+            "  }",
+            "  PersistentAVLAbstract remove(const T &val, bool &removed) const {",
+            "    removed = false;",
+            "    NodePtr newRoot = removeNode(root, val, removed);",
+            "    return removed ? PersistentAVLAbstract(newRoot) : *this;",
+            "  }",
+            "",
+            "  bool empty() const { return root == nullptr; }",
+            "",
+            "  void swap(PersistentAVLAbstract &other) noexcept { root.swap(other.root); }",
+            "",
+            "  // Thread-safe hand-off of versions between threads. A writer builds the",
+            "  // next version from snapshot() and publishes it; readers call snapshot()",
+            "  // and work on their own copy. Each call copies one shared_ptr atomically.",
+            "  // That is not lock-free in common standard libraries (libstdc++ guards it",
+            "  // with a small mutex pool), but the guard is never held during a search",
+            "  // or an update. C++20 deprecates these functions in favour of",
+            "  // std::atomic<std::shared_ptr>, which would make root non-copyable. With",
+            "  // several writers, updates must be serialized among the writers. Other",
+            "  // methods must not be called on an object that is being published to.",
+            "  void publish(const PersistentAVLAbstract &version) {",
+            "    std::atomic_store(&root, version.root);",
+            "  }",
+            "",
+            "  PersistentAVLAbstract snapshot() const {",
+            "    return PersistentAVLAbstract(std::atomic_load(&root));",
+            "  }",
+            "",
+            "  // Formats the whole tree into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    std::vector<std::pair<const Node<T> *, int>> stack;",
+            "    const Node<T> *node = root.get();",
+            "    int depth = 0;",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back({node, depth});",
+            "        node = node->right.get();",
+            "        depth++;",
+            "      }",
+            "      node = stack.back().first;",
+            "      depth = stack.back().second;",
+            "      stack.pop_back();",
+            "",
+            "      for (int i = 0; i < depth; i++) {",
+            "        buffer << \"   \";",
+            "      }",
+            "      buffer << node->val << '\\n';",
+            "",
+            "      node = node->left.get();",
+            "      depth++;",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(val) for every key in sorted order, without recursion.",
+            "  template <typename Fn> void visitInOrder(Fn fn) const {",
+            "    std::vector<const Node<T> *> stack;",
+            "    const Node<T> *node = root.get();",
+            "    while (node || !stack.empty()) {",
+            "      while (node) {",
+            "        stack.push_back(node);",
+            "        node = node->left.get();",
+            "      }",
+            "      node = stack.back();",
+            "      stack.pop_back();",
+            "      fn(node->val);",
+            "      node = node->right.get();",
+            "    }",
+            "  }",
+            "",
+            "  // Calls fn(val, depth) level by level, root first.",
+            "  template <typename Fn> void visitLevelOrder(Fn fn) const {",
+            "    std::vector<std::pair<const Node<T> *, int>> level;",
+            "    if (root)",
+            "      level.push_back({root.get(), 0});",
+            "    for (size_t i = 0; i < level.size(); i++) {",
+            "      const Node<T> *node = level[i].first;",
+            "      int depth = level[i].second;",
+            "      fn(node->val, depth);",
+            "      if (node->left)",
+            "        level.push_back({node->left.get(), depth + 1});",
+            "      if (node->right)",
+            "        level.push_back({node->right.get(), depth + 1});",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  NodePtr root;",
+            "",
+            "  explicit PersistentAVLAbstract(NodePtr r) : root(std::move(r)) {}",
+            "",
+            "  static int compare(const T &a, const T &b) {",
+            "    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);",
+            "  }",
+            "",
+            "  static int getHeight(const NodePtr &node) { return node ? node->height : 0; }",
+            "",
+            "  static NodePtr makeNode(T val, NodePtr left, NodePtr right) {",
+            "    return std::make_shared<const Node<T>>(std::move(val), std::move(left),",
+            "                                           std::move(right));",
+            "  }",
+            "",
+            "  // Builds a new node from val and two subtrees, rotating if they differ in",
+            "  // height by 2. Rotations allocate fresh nodes instead of relinking.",
+            "  static NodePtr balanceNode(T val, NodePtr left, NodePtr right) {",
+            "    int hl = getHeight(left);",
+            "    int hr = getHeight(right);",
+            "",
+            "    if (hl > hr + 1) {",
+            "      // LL",
+            "      if (getHeight(left->left) >= getHeight(left->right)) {",
+            "        return makeNode(left->val, left->left,",
+            "                        makeNode(val, left->right, std::move(right)));",
+            "      }",
+            "      // LR",
+            "      const Node<T> *lr = left->right.get();",
+            "      return makeNode(lr->val, makeNode(left->val, left->left, lr->left),",
+            "                      makeNode(val, lr->right, std::move(right)));",
+            "    }",
+            "",
+            "    if (hr > hl + 1) {",
+            "      // RR",
+            "      if (getHeight(right->right) >= getHeight(right->left)) {",
+            "        return makeNode(right->val,",
+            "                        makeNode(val, std::move(left), right->left),",
+            "                        right->right);",
+            "      }",
+            "      // RL",
+            "      const Node<T> *rl = right->left.get();",
+            "      return makeNode(rl->val, makeNode(val, std::move(left), rl->left),",
+            "                      makeNode(right->val, rl->right, right->right));",
+            "    }",
+            "",
+            "    return makeNode(std::move(val), std::move(left), std::move(right));",
+            "  }",
+            "",
+            "  // U is T or const T&; val is moved into the new leaf. Path nodes are",
+            "  // still copied, as every version needs its own, unless the key was",
+            "  // already there: then the original nodes are returned, like removeNode.",
+            "  template <typename U>",
+            "  static NodePtr insertNode(const NodePtr &node, U &&val, bool &inserted) {",
+            "    if (!node) {",
+            "      inserted = true;",
+            "      return makeNode(std::forward<U>(val), nullptr, nullptr);",
+            "    }",
+            "",
+            "    int r = compare(val, node->val);",
+            "    if (r < 0) {",
+            "      NodePtr left = insertNode(node->left, std::forward<U>(val), inserted);",
+            "      return inserted ? balanceNode(node->val, left, node->right) : node;",
+            "    } else if (r > 0) {",
+            "      NodePtr right = insertNode(node->right, std::forward<U>(val), inserted);",
+            "      return inserted ? balanceNode(node->val, node->left, right) : node;",
+            "    }",
+            "    return node;",
+            "  }",
+            "",
+            "  static const T *searchNode(const Node<T> *node, const T &val) {",
+            "    while (node) {",
+            "      int r = compare(val, node->val);",
+            "      if (r < 0)",
+            "        node = node->left.get();",
+            "      else if (r > 0)",
+            "        node = node->right.get();",
+            "      else",
+            "        return &(node->val);",
+            "    }",
+            "    return nullptr;",
+            "  }",
+            "",
+            "  static NodePtr removeMin(const NodePtr &node, T &minVal) {",
+            "    if (!node->left) {",
+            "      minVal = node->val;",
+            "      return node->right;",
+            "    }",
+            "    return balanceNode(node->val, removeMin(node->left, minVal), node->right);",
+            "  }",
+            "",
+            "  static NodePtr removeNode(const NodePtr &node, const T &val,",
+            "                            bool &removed) {",
+            "    if (!node) {",
+            "      return nullptr;",
+            "    }",
+            "",
+            "    int r = compare(val, node->val);",
+            "    if (r < 0) {",
+            "      NodePtr left = removeNode(node->left, val, removed);",
+            "      return removed ? balanceNode(node->val, left, node->right) : node;",
+            "    } else if (r > 0) {",
+            "      NodePtr right = removeNode(node->right, val, removed);",
+            "      return removed ? balanceNode(node->val, node->left, right) : node;",
+            "    }",
+            "",
+            "    removed = true;",
+            "    if (!node->left)",
+            "      return node->right;",
+            "    if (!node->right)",
+            "      return node->left;",
+            "",
+            "    T successor = node->val;",
+            "    NodePtr right = removeMin(node->right, successor);",
+            "    return balanceNode(successor, node->left, right);",
+            "  }",
+            "};",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T>",
+            "using PersistentAVLTree = PersistentAVLAbstract<T, lessCompare<T>>;"
+        ],
+        "threadSafe": false
+    },
+    {
+        "label": "Compact AVL Tree",
+        "body": [
+            "#include <algorithm>",
+            "#include <cstdint>",
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "#include <vector>",
+            "",
+            "// Node stored by value in one contiguous array. Children are 32-bit indices;",
+            "// the balance factor (height(left) - height(right), from -1 to 1) is kept as",
+            "// balance + 1 in the top 2 bits of `left`, which leaves 30 bits per index.",
+            "template <typename T>",
+            "struct CompactNode {",
+            "  T val;",
+            "  uint32_t left;",
+            "  uint32_t right;",
+            "};",
+            "",
+            "// AVL tree with the same interface as AVLAbstract, but without a heap",
+            "// allocation or 64-bit pointers per node. Freed slots are reused through a",
+            "// free list threaded through `left`. Nodes refer to each other by index, so",
+            "// the default copy is a shape-preserving deep copy in one allocation. A move",
+            "// steals the array and leaves the source empty.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class CompactAVLAbstract {",
+            "public:",
+            "  CompactAVLAbstract() {",
+            "    root = NIL;",
+            "    freeHead = NIL;",
+            "    count = 0;",
+            "  }",
+            "",
+            "  CompactAVLAbstract(const CompactAVLAbstract &other) = default;",
+            "  CompactAVLAbstract &operator=(const CompactAVLAbstract &other) = default;",
+            "",
+            "  // The implicit move would leave root and freeHead pointing into the",
+            "  // stolen array.",
+            "  CompactAVLAbstract(CompactAVLAbstract &&other) noexcept",
+            "      : CompactAVLAbstract() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  CompactAVLAbstract &operator=(CompactAVLAbstract &&other) noexcept {",
+            "    CompactAVLAbstract taken(std::move(other));",
+            "    swap(taken);",
+            "    return *this;",
+            "  }",
+            "",
+            "  // Returns false if an equal key was already present.",
+            "  bool insert(const T &val) {",
+            "    bool grew = false;",
+            "    int before = count;",
+            "    root = insertNode(root, val, grew);",
+            "    return count > before;",
+            "  }",
+            "  bool insert(T &&val) {",
+            "    bool grew = false;",
+            "    int before = count;",
+            "    root = insertNode(root, std::move(val), grew);",
+            "    return count > before;",
+            "  }",
+            "  T *search(const T &val) {",
+            "    uint32_t node = root;",
+            "    while (node != NIL) {",
+            "      int r = compare(val, nodes[node].val);",
+            "      if (r < 0)",
+            "        node = getLeft(node);",
+            "      else if (r > 0)",
+            "        node = getRight(node);",
+            "      else",
+            "        return &(nodes[node].val);",
+            "    }",
+            "    return nullptr;",
+            "  }",
+            "  bool remove(const T &val) {",
+            "    bool removed = false;",
+            "    bool shrunk = false;",
+            "    root = removeNode(root, val, removed, shrunk);",
+            "    return removed;",
+            "  }",
+            "  void clear() {",
+            "    nodes.clear();",
+            "    root = NIL;",
+            "    freeHead = NIL;",
+            "    count = 0;",
+            "  }",
+            "",
+            "  void swap(CompactAVLAbstract &other) noexcept {",
+            "    nodes.swap(other.nodes);",
+            "    std::swap(root, other.root);",
+            "    std::swap(freeHead, other.freeHead);",
+            "    std::swap(count, other.count);",
+            "  }",
+            "",
+            "  void reserve(int n) { nodes.reserve(n); }",
+            "  int size() const { return count; }",
+            "  // Bytes held by the node array, including free and reserved slots.",
+            "  size_t memoryUsage() const {",
+            "    return nodes.capacity() * sizeof(CompactNode<T>);",
+            "  }",
+            "",
+            "  // Formats the whole tree into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    std::vector<std::pair<uint32_t, int>> stack;",
+            "    uint32_t node = root;",
+            "    int depth = 0;",
+            "    while (node != NIL || !stack.empty()) {",
+            "      while (node != NIL) {",
+            "        stack.push_back({node, depth});",
+            "        node = getRight(node);",
+            "        depth++;",
+            "      }",
+            "      node = stack.back().first;",
+            "      depth = stack.back().second;",
+            "      stack.pop_back();",
+            "",
+            "      for (int i = 0; i < depth; i++) {",
+            "        buffer << \"   \";",
+            "      }",
+            "      buffer << nodes[node].val << '\\n';",
+            "",
+            "      node = getLeft(node);",
+            "      depth++;",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "private:",
+            "  static const uint32_t NIL = 0x3FFFFFFF;",
+            "  static const uint32_t INDEX_MASK = 0x3FFFFFFF;",
+            "",
+            "  std::vector<CompactNode<T>> nodes;",
+            "  uint32_t root;",
+            "  uint32_t freeHead;",
+            "  int count;",
+            "",
+            "  static int compare(const T &a, const T &b) {",
+            "    return Comp(a, b) ? -1 : (Comp(b, a) ? 1 : 0);",
+            "  }",
+            "",
+            "  uint32_t getLeft(uint32_t node) const {",
+            "    return nodes[node].left & INDEX_MASK;",
+            "  }",
+            "  uint32_t getRight(uint32_t node) const { return nodes[node].right; }",
+            "  int getBalance(uint32_t node) const {",
+            "    return static_cast<int>(nodes[node].left >> 30) - 1;",
+            "  }",
+            "",
+            "  void setLeft(uint32_t node, uint32_t child) {",
+            "    nodes[node].left = (nodes[node].left & ~INDEX_MASK) | child;",
+            "  }",
+            "  void setRight(uint32_t node, uint32_t child) { nodes[node].right = child; }",
+            "  void setBalance(uint32_t node, int balance) {",
+            "    nodes[node].left = (static_cast<uint32_t>(balance + 1) << 30) |",
+            "                       (nodes[node].left & INDEX_MASK);",
+            "  }",
+            "",
+            "  template <typename U> uint32_t allocNode(U &&val) {",
+            "    uint32_t node;",
+            "    if (freeHead != NIL) {",
+            "      node = freeHead;",
+            "      freeHead = nodes[node].left & INDEX_MASK;",
+            "      nodes[node].val = std::forward<U>(val);",
+            "    } else {",
+            "      if (nodes.size() >= NIL) {",
+            "        throw std::runtime_error(\"CompactAVL is full\");",
+            "      }",
+            "      node = static_cast<uint32_t>(nodes.size());",
+            "      nodes.push_back({std::forward<U>(val), 0, 0});",
+            "    }",
+            "    nodes[node].left = NIL;",
+            "    nodes[node].right = NIL;",
+            "    setBalance(node, 0);",
+            "    count++;",
+            "    return node;",
+            "  }",
+            "",
+            "  void freeNode(uint32_t node) {",
+            "    nodes[node].left = freeHead;",
+            "    freeHead = node;",
+            "    count--;",
+            "  }",
+            "",
+            "  // node is two levels heavier on the left. Rotates and returns the new",
+            "  // subtree root; shrunk tells whether the subtree lost a level.",
+            "  uint32_t fixLeft(uint32_t node, bool &shrunk) {",
+            "    uint32_t l = getLeft(node);",
+            "    int bl = getBalance(l);",
+            "",
+            "    // LL",
+            "    if (bl >= 0) {",
+            "      setLeft(node, getRight(l));",
+            "      setRight(l, node);",
+            "      setBalance(node, bl == 0 ? 1 : 0);",
+            "      setBalance(l, bl == 0 ? -1 : 0);",
+            "      shrunk = bl != 0;",
+            "      return l;",
+            "    }",
+            "",
+            "    // LR",
+            "    uint32_t lr = getRight(l);",
+            "    int b = getBalance(lr);",
+            "    setRight(l, getLeft(lr));",
+            "    setLeft(node, getRight(lr));",
+            "    setLeft(lr, l);",
+            "    setRight(lr, node);",
+            "    setBalance(node, b == 1 ? -1 : 0);",
+            "    setBalance(l, b == -1 ? 1 : 0);",
+            "    setBalance(lr, 0);",
+            "    shrunk = true;",
+            "    return lr;",
+            "  }",
+            "",
+            "  uint32_t fixRight(uint32_t node, bool &shrunk) {",
+            "    uint32_t r = getRight(node);",
+            "    int br = getBalance(r);",
+            "",
+            "    // RR",
+            "    if (br <= 0) {",
+            "      setRight(node, getLeft(r));",
+            "      setLeft(r, node);",
+            "      setBalance(node, br == 0 ? -1 : 0);",
+            "      setBalance(r, br == 0 ? 1 : 0);",
+            "      shrunk = br != 0;",
+            "      return r;",
+            "    }",
+            "",
+            "    // RL",
+            "    uint32_t rl = getLeft(r);",
+            "    int b = getBalance(rl);",
+            "    setLeft(r, getRight(rl));",
+            "    setRight(node, getLeft(rl));",
+            "    setRight(rl, r);",
+            "    setLeft(rl, node);",
+            "    setBalance(node, b == -1 ? 1 : 0);",
+            "    setBalance(r, b == 1 ? -1 : 0);",
+            "    setBalance(rl, 0);",
+            "    shrunk = true;",
+            "    return rl;",
+            "  }",
+            "",
+            "  // U is T or const T&; val is moved into the new node.",
+            "  template <typename U>",
+            "  uint32_t insertNode(uint32_t node, U &&val, bool &grew) {",
+            "    if (node == NIL) {",
+            "      grew = true;",
+            "      return allocNode(std::forward<U>(val));",
+            "    }",
+            "",
+            "    int r = compare(val, nodes[node].val);",
+            "    if (r == 0) {",
+            "      grew = false;",
+            "      return node;",
+            "    }",
+            "",
+            "    bool shrunk = false;",
+            "    if (r < 0) {",
+            "      setLeft(node, insertNode(getLeft(node), std::forward<U>(val), grew));",
+            "      if (!grew)",
+            "        return node;",
+            "      int b = getBalance(node);",
+            "      if (b < 1) {",
+            "        setBalance(node, b + 1);",
+            "        grew = b == 0;",
+            "        return node;",
+            "      }",
+            "      grew = false;",
+            "      return fixLeft(node, shrunk);",
+            "    }",
+            "",
+            "    setRight(node, insertNode(getRight(node), std::forward<U>(val), grew));",
+            "    if (!grew)",
+            "      return node;",
+            "    int b = getBalance(node);",
+            "    if (b > -1) {",
+            "      setBalance(node, b - 1);",
+            "      grew = b == 0;",
+            "      return node;",
+            "    }",
+            "    grew = false;",
+            "    return fixRight(node, shrunk);",
+            "  }",
+            "",
+            "  // The left subtree of node lost a level.",
+            "  uint32_t leftShrunk(uint32_t node, bool &shrunk) {",
+            "    int b = getBalance(node);",
+            "    if (b > -1) {",
+            "      setBalance(node, b - 1);",
+            "      shrunk = b == 1;",
+            "      return node;",
+            "    }",
+            "    return fixRight(node, shrunk);",
+            "  }",
+            "",
+            "  // The right subtree of node lost a level.",
+            "  uint32_t rightShrunk(uint32_t node, bool &shrunk) {",
+            "    int b = getBalance(node);",
+            "    if (b < 1) {",
+            "      setBalance(node, b + 1);",
+            "      shrunk = b == -1;",
+            "      return node;",
+            "    }",
+            "    return fixLeft(node, shrunk);",
+            "  }",
+            "",
+            "  uint32_t removeMin(uint32_t node, uint32_t &minNode, bool &shrunk) {",
+            "    if (getLeft(node) == NIL) {",
+            "      minNode = node;",
+            "      shrunk = true;",
+            "      return getRight(node);",
+            "    }",
+            "    setLeft(node, removeMin(getLeft(node), minNode, shrunk));",
+            "    return shrunk ? leftShrunk(node, shrunk) : node;",
+            "  }",
+            "",
+            "  uint32_t removeNode(uint32_t node, const T &val, bool &removed,",
+            "                      bool &shrunk) {",
+            "    if (node == NIL) {",
+            "      shrunk = false;",
+            "      return NIL;",
+            "    }",
+            "",
+            "    int r = compare(val, nodes[node].val);",
+            "    if (r < 0) {",
+            "      setLeft(node, removeNode(getLeft(node), val, removed, shrunk));",
+            "      return shrunk ? leftShrunk(node, shrunk) : node;",
+            "    }",
+            "    if (r > 0) {",
+            "      setRight(node, removeNode(getRight(node), val, removed, shrunk));",
+            "      return shrunk ? rightShrunk(node, shrunk) : node;",
+            "    }",
+            "",
+            "    removed = true;",
+            "    if (getLeft(node) == NIL || getRight(node) == NIL) {",
+            "      uint32_t child = getLeft(node) == NIL ? getRight(node) : getLeft(node);",
+            "      freeNode(node);",
+            "      shrunk = true;",
+            "      return child;",
+            "    }",
+            "",
+            "    uint32_t successor = NIL;",
+            "    setRight(node, removeMin(getRight(node), successor, shrunk));",
+            "    nodes[node].val = std::move(nodes[successor].val);",
+            "    freeNode(successor);",
+            "    return shrunk ? rightShrunk(node, shrunk) : node;",
+            "  }",
+            "};",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T>",
+            "using CompactAVLTree = CompactAVLAbstract<T, lessCompare<T>>;"
+        ],
+        "threadSafe": true
+    },
+    {
+        "label": "Mapped Set",
+        "body": [
+            "#include <cstdint>",
+            "#include <cstring>",
+            "#include <fcntl.h>",
+            "#include <iostream>",
+            "#include <stdexcept>",
+            "#include <sys/mman.h>",
+            "#include <sys/stat.h>",
+            "#include <unistd.h>",
+            "#include <utility>",
+            "",
+            "// Binary dump layout: header followed by `count` raw elements. Same layout as",
+            "// AVLAbstract::serialize / BSTAbstract::serialize (magic \"DSTR\").",
+            "struct DumpHeader {",
+            "  char magic[4];",
+            "  uint32_t elemSize;",
+            "  uint64_t count;",
+            "};",
+            "",
+            "// Read-only view of a tree dump mapped straight from disk (POSIX mmap).",
+            "// Opening is O(1) regardless of file size; pages are loaded lazily by the OS",
+            "// as lookups touch them.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class MappedSet {",
+            "public:",
+            "  explicit MappedSet(const char *path) {",
+            "    int fd = open(path, O_RDONLY);",
+            "    if (fd < 0) {",
+            "      throw std::runtime_error(\"Cannot open tree dump\");",
+            "    }",
+            "",
+            "    struct stat st;",
+            "    if (fstat(fd, &st) != 0 ||",
+            "        static_cast<size_t>(st.st_size) < sizeof(DumpHeader)) {",
+            "      close(fd);",
+            "      throw std::runtime_error(\"Invalid tree dump\");",
+            "    }",
+            "",
+            "    length = static_cast<size_t>(st.st_size);",
+            "    mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);",
+            "    close(fd);",
+            "    if (mapping == MAP_FAILED) {",
+            "      throw std::runtime_error(\"Cannot map tree dump\");",
+            "    }",
+            "",
+            "    const DumpHeader *header = static_cast<const DumpHeader *>(mapping);",
+            "    if (std::memcmp(header->magic, \"DSTR\", 4) != 0 ||",
+            "        header->elemSize != sizeof(T) ||",
+            "        header->count > (length - sizeof(DumpHeader)) / sizeof(T)) {",
+            "      munmap(mapping, length);",
+            "      throw std::runtime_error(\"Invalid tree dump\");",
+            "    }",
+            "",
+            "    count = static_cast<size_t>(header->count);",
+            "    data = reinterpret_cast<const T *>(static_cast<const char *>(mapping) +",
+            "                                       sizeof(DumpHeader));",
+            "  }",
+            "",
+            "  ~MappedSet() {",
+            "    if (mapping)",
+            "      munmap(mapping, length);",
+            "  }",
+            "",
+            "  // One mapping has one owner: a set can be moved but not copied. A",
+            "  // moved-from set is empty.",
+            "  MappedSet(const MappedSet &) = delete;",
+            "  MappedSet &operator=(const MappedSet &) = delete;",
+            "",
+            "  MappedSet(MappedSet &&other) noexcept {",
+            "    mapping = other.mapping;",
+            "    length = other.length;",
+            "    data = other.data;",
+            "    count = other.count;",
+            "    other.mapping = nullptr;",
+            "    other.length = 0;",
+            "    other.data = nullptr;",
+            "    other.count = 0;",
+            "  }",
+            "",
+            "  MappedSet &operator=(MappedSet &&other) noexcept {",
+            "    MappedSet moved(std::move(other));",
+            "    swap(moved);",
+            "    return *this;",
+            "  }",
+            "",
+            "  void swap(MappedSet &other) noexcept {",
+            "    std::swap(mapping, other.mapping);",
+            "    std::swap(length, other.length);",
+            "    std::swap(data, other.data);",
+            "    std::swap(count, other.count);",
+            "  }",
+            "",
+            "  // Branchless lower bound over the sorted array.",
+            "  const T *search(const T &val) const {",
+            "    if (count == 0)",
+            "      return nullptr;",
+            "",
+            "    const T *base = data;",
+            "    size_t n = count;",
+            "    while (n > 1) {",
+            "      size_t half = n / 2;",
+            "      base = Comp(base[half], val) ? base + half : base;",
+            "      n -= half;",
+            "    }",
+            "    base += Comp(*base, val);",
+            "",
+            "    if (base == data + count || Comp(val, *base))",
+            "      return nullptr;",
+            "    return base;",
+            "  }",
+            "",
+            "  int size() const { return static_cast<int>(count); }",
+            "  bool empty() const { return count == 0; }",
+            "",
+            "private:",
+            "  void *mapping;",
+            "  size_t length;",
+            "  const T *data;",
+            "  size_t count;",
+            "};",
+            "",
+            "template <typename T> bool lessCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T> using MappedTreeSet = MappedSet<T, lessCompare<T>>;"
+        ],
+        "threadSafe": false
+    },
+    {
+        "label": "Heap",
+        "body": [
+            "#include <algorithm>",
+            "#include <atomic>",
+            "#include <condition_variable>",
+            "#include <cstdint>",
+            "#include <cstring>",
+            "#include <exception>",
+            "#include <functional>",
+            "#include <iostream>",
+            "#include <mutex>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <thread>",
+            "#include <type_traits>",
+            "#include <utility>",
+            "#include <vector>",
+            "",
+            "// Binary dump layout: header followed by `count` raw elements in heap order.",
+            "struct DumpHeader {",
+            "  char magic[4];",
+            "  uint32_t elemSize;",
+            "  uint64_t count;",
+            "};",
+            "",
+            "// Reads the `count` elements that follow a DumpHeader into out. count comes",
+            "// from the file, so it is checked against the bytes left in the stream",
+            "// before out is sized. A stream that cannot seek is read in bounded steps",
+            "// instead, so a corrupt count ends in a short read, not a huge allocation.",
+            "template <typename T>",
+            "bool readDumpElements(std::istream &in, uint64_t count, std::vector<T> &out) {",
+            "  uint64_t step = count;",
+            "  std::streampos here = in.tellg();",
+            "  if (here != std::streampos(-1) && in.seekg(0, std::ios::end)) {",
+            "    uint64_t left = static_cast<uint64_t>(in.tellg() - here);",
+            "    in.seekg(here);",
+            "    if (count > left / sizeof(T))",
+            "      return false;",
+            "  } else {",
+            "    in.clear();",
+            "    step = 1 << 16;",
+            "  }",
+            "  out.clear();",
+            "  while (out.size() < count) {",
+            "    size_t done = out.size();",
+            "    size_t n = static_cast<size_t>(std::min<uint64_t>(step, count - done));",
+            "    out.resize(done + n);",
+            "    in.read(reinterpret_cast<char *>(out.data() + done), n * sizeof(T));",
+            "    if (!in)",
+            "      return false;",
+            "  }",
+            "  return true;",
+            "}",
+            "",
+            "// Fixed set of worker threads for the parallel bulk operations. run() is a",
+            "// fork-join step: the calling thread takes part, and it returns once every",
+            "// task is done. Tasks of one run() must not call run() on the same pool.",
+            "class ThreadPool {",
+            "public:",
+            "  // threads counts the calling thread, so ThreadPool(1) runs tasks inline.",
+            "  explicit ThreadPool(",
+            "      int threads = static_cast<int>(std::thread::hardware_concurrency())) {",
+            "    job = nullptr;",
+            "    jobSize = 0;",
+            "    next = 0;",
+            "    pending = 0;",
+            "    active = 0;",
+            "    generation = 0;",
+            "    stopping = false;",
+            "    for (int i = 1; i < threads; i++) {",
+            "      workers.emplace_back([this] { workerLoop(); });",
+            "    }",
+            "  }",
+            "",
+            "  ThreadPool(const ThreadPool &) = delete;",
+            "  ThreadPool &operator=(const ThreadPool &) = delete;",
+            "",
+            "  ~ThreadPool() {",
+            "    {",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      stopping = true;",
+            "    }",
+            "    wake.notify_all();",
+            "    for (std::thread &worker : workers) {",
+            "      worker.join();",
+            "    }",
+            "  }",
+            "",
+            "  int size() const { return static_cast<int>(workers.size()) + 1; }",
+            "",
+            "  // Calls fn(i) for every i in [0, count), spread over the pool. The first",
+            "  // exception thrown by a task is rethrown here after all tasks finished.",
+            "  template <typename Fn> void run(int count, Fn fn) {",
+            "    if (count <= 0)",
+            "      return;",
+            "    if (workers.empty() || count == 1) {",
+            "      for (int i = 0; i < count; i++) {",
+            "        fn(i);",
+            "      }",
+            "      return;",
+            "    }",
+            "",
+            "    std::function<void(int)> task = fn;",
+            "    {",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      job = &task;",
+            "      jobSize = count;",
+            "      next = 0;",
+            "      pending = count;",
+            "      error = nullptr;",
+            "      generation++;",
+            "    }",
+            "    wake.notify_all();",
+            "    work(task, count);",
+            "",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    done.wait(lock, [this] { return pending == 0 && active == 0; });",
+            "    job = nullptr;",
+            "    if (error) {",
+            "      std::rethrow_exception(error);",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  std::vector<std::thread> workers;",
+            "  std::mutex mutex;",
+            "  std::condition_variable wake;",
+            "  std::condition_variable done;",
+            "  const std::function<void(int)> *job;",
+            "  int jobSize;",
+            "  std::atomic<int> next; // next task index to hand out",
+            "  int pending;           // tasks not finished yet",
+            "  int active;            // workers inside work(), run() waits for them too",
+            "  uint64_t generation;",
+            "  bool stopping;",
+            "  std::exception_ptr error;",
+            "",
+            "  void workerLoop() {",
+            "    uint64_t seen = 0;",
+            "    for (;;) {",
+            "      const std::function<void(int)> *task;",
+            "      int count;",
+            "      {",
+            "        std::unique_lock<std::mutex> lock(mutex);",
+            "        wake.wait(lock, [&] { return stopping || generation != seen; });",
+            "        if (stopping)",
+            "          return;",
+            "        seen = generation;",
+            "        if (job == nullptr)",
+            "          continue;",
+            "        task = job;",
+            "        count = jobSize;",
+            "        active++;",
+            "      }",
+            "      work(*task, count);",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      active--;",
+            "      if (pending == 0 && active == 0)",
+            "        done.notify_all();",
+            "    }",
+            "  }",
+            "",
+            "  void work(const std::function<void(int)> &task, int count) {",
+            "    int finished = 0;",
+            "    for (int i; (i = next.fetch_add(1)) < count;) {",
+            "      try {",
+            "        task(i);",
+            "      } catch (...) {",
+            "        std::lock_guard<std::mutex> lock(mutex);",
+            "        if (!error)",
+            "          error = std::current_exception();",
+            "      }",
+            "      finished++;",
+            "    }",
+            "    if (finished > 0) {",
+            "      std::lock_guard<std::mutex> lock(mutex);",
+            "      pending -= finished;",
+            "      if (pending == 0 && active == 0)",
+            "        done.notify_all();",
+            "    }",
+            "  }",
+            "};",
+            "",
+            "// Array-backed binary heap. The implicit copy and move operations copy or",
+            "// steal the array.",
+            "template <typename T, bool (*Comp)(const T &, const T &)>",
+            "class Heap {",
+            "public:",
+            "  Heap() { std::vector<T> arr; }",
+            "",
+            "  void insert(const T &val) {",
+            "    arr.push_back(val);",
+            "    siftUp(arr.size() - 1);",
+            "  }",
+            "",
+            "  void insert(T &&val) {",
+            "    arr.push_back(std::move(val));",
+            "    siftUp(arr.size() - 1);",
+            "  }",
+            "",
+            "  T popRoot() {",
+            "    if (arr.empty()) {",
+            "      throw std::out_of_range(\"Heap is empty\");",
+            "    }",
+            "",
+            "    T result = std::move(arr[0]);",
+            "    int last = arr.size() - 1;",
+            "",
+            "    std::swap(arr[0], arr[last]);",
+            "    arr.pop_back();",
+            "",
+            "    if (!arr.empty()) {",
+            "      siftDown(0);",
+            "    }",
+            "",
+            "    return result;",
+            "  }",
+            "",
+            "  T peek() const {",
+            "    if (arr.empty()) {",
+            "      throw std::out_of_range(\"Heap is empty\");",
+            "    }",
+            "    return arr[0];",
+            "  }",
+            "",
+            "  bool empty() const { return arr.empty(); }",
+            "",
+            "  int size() const { return static_cast<int>(arr.size()); }",
+            "",
+            "  void clear() { arr.clear(); }",
+            "",
+            "  void swap(Heap &other) noexcept { arr.swap(other.arr); }",
+            "",
+            "  // Replaces the contents with data, heapified bottom-up in O(n). The nodes",
+            "  // of one level head disjoint subtrees, so each level's sift-downs are",
+            "  // split into pool tasks, deepest level first. Levels near the root have",
+            "  // too few nodes to be worth splitting and run inline.",
+            "  void buildParallel(std::vector<T> data, ThreadPool &pool) {",
+            "    arr = std::move(data);",
+            "    int last = static_cast<int>(arr.size()) / 2 - 1; // last node with a child",
+            "    if (last < 0)",
+            "      return;",
+            "",
+            "    int level = 0;",
+            "    while ((2 << level) - 1 <= last)",
+            "      level++;",
+            "    for (; level >= 0; level--) {",
+            "      int first = (1 << level) - 1;",
+            "      int count = std::min(last + 1, (2 << level) - 1) - first;",
+            "      int tasks = std::min(count / HEAPIFY_GRAIN, 4 * pool.size());",
+            "      if (tasks < 2) {",
+            "        for (int i = first; i < first + count; i++)",
+            "          siftDown(i);",
+            "        continue;",
+            "      }",
+            "      pool.run(tasks, [&](int t) {",
+            "        int lo = first + static_cast<int>(int64_t(count) * t / tasks);",
+            "        int hi = first + static_cast<int>(int64_t(count) * (t + 1) / tasks);",
+            "        for (int i = lo; i < hi; i++)",
+            "          siftDown(i);",
+            "      });",
+            "    }",
+            "  }",
+            "",
+            "  // Formats the whole heap into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    print(buffer, 0, 0);",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(val, depth) in array order, which is level order for a heap.",
+            "  template <typename Fn> void visitLevelOrder(Fn fn) const {",
+            "    int depth = 0;",
+            "    for (size_t i = 0; i < arr.size(); i++) {",
+            "      if (i + 1 == (size_t(1) << (depth + 1)))",
+            "        depth++;",
+            "      fn(arr[i], depth);",
+            "    }",
+            "  }",
+            "",
+            "  // Writes arr as is, see DumpHeader.",
+            "  void serialize(std::ostream &out) const {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"serialize requires a trivially copyable T\");",
+            "    DumpHeader header = {{'D', 'S', 'H', 'P'}, sizeof(T), arr.size()};",
+            "    out.write(reinterpret_cast<const char *>(&header), sizeof(header));",
+            "    out.write(reinterpret_cast<const char *>(arr.data()),",
+            "              arr.size() * sizeof(T));",
+            "    if (!out) {",
+            "      throw std::runtime_error(\"Failed to write heap dump\");",
+            "    }",
+            "  }",
+            "",
+            "  // Replaces the contents with a dump written by serialize(). The array is",
+            "  // already in heap order, so it is only checked in O(n), with no sifting.",
+            "  // The dump is read into a separate array, so if loading throws the heap",
+            "  // is left unchanged.",
+            "  void deserialize(std::istream &in) {",
+            "    static_assert(std::is_trivially_copyable<T>::value,",
+            "                  \"deserialize requires a trivially copyable T\");",
+            "    DumpHeader header;",
+            "    in.read(reinterpret_cast<char *>(&header), sizeof(header));",
+            "    if (!in || std::memcmp(header.magic, \"DSHP\", 4) != 0 ||",
+            "        header.elemSize != sizeof(T)) {",
+            "      throw std::runtime_error(\"Invalid heap dump\");",
+            "    }",
+            "    std::vector<T> loaded;",
+            "    if (!readDumpElements(in, header.count, loaded)) {",
+            "      throw std::runtime_error(\"Truncated heap dump\");",
+            "    }",
+            "    for (size_t i = 1; i < loaded.size(); i++) {",
+            "      if (Comp(loaded[i], loaded[(i - 1) / 2])) {",
+            "        throw std::runtime_error(\"Heap dump is not in heap order\");",
+            "      }",
+            "    }",
+            "    arr.swap(loaded);",
+            "  }",
+            "",
+            "private:",
+            "  // Fewest sift-downs worth handing to the pool as one task.",
+            "  static const int HEAPIFY_GRAIN = 1024;",
+            "",
+            "  std::vector<T> arr;",
+            "",
+            "  void siftUp(int i) {",
+            "    while (i > 0) {",
+            "      int p = (i - 1) / 2;",
+            "      if (Comp(arr[i], arr[p])) {",
+            "        std::swap(arr[i], arr[p]);",
+            "        i = p;",
+            "      } else {",
+            "        break;",
+            "      }",
+            "    }",
+            "  }",
+            "",
+            "  void siftDown(int i) {",
+            "    int n = static_cast<int>(arr.size());",
+            "    while (true) {",
+            "      int left = 2 * i + 1;",
+            "      int right = 2 * i + 2;",
+            "      int nest = i;",
+            "",
+            "      if (left < n && Comp(arr[left], arr[nest])) {",
+            "        nest = left;",
+            "      }",
+            "      if (right < n && Comp(arr[right], arr[nest])) {",
+            "        nest = right;",
+            "      }",
+            "",
+            "      if (nest != i) {",
+            "        std::swap(arr[i], arr[nest]);",
+            "        i = nest;",
+            "      } else {",
+            "        break;",
+            "      }",
+            "    }",
+            "  }",
+            "",
+            "  void print(std::ostringstream &buffer, int index, int depth) const {",
+            "    if (index >= static_cast<int>(arr.size()))",
+            "      return;",
+            "",
+            "    int right = 2 * index + 2;",
+            "    int left = 2 * index + 1;",
+            "",
+            "    print(buffer, right, depth + 1);",
+            "",
+            "    for (int i = 0; i < depth; ++i) {",
+            "      buffer << \"   \";",
+            "    }",
+            "",
+            "    buffer << arr[index] << '\\n';",
+            "    print(buffer, left, depth + 1);",
+            "  }",
+            "};",
+            "",
+            "template <typename T> bool minCompare(const T &a, const T &b) { return a < b; }",
+            "template <typename T> bool maxCompare(const T &a, const T &b) { return a > b; }",
+            "",
+            "template <typename T = int> using MinHeap = Heap<T, minCompare<T>>;",
+            "template <typename T = int> using MaxHeap = Heap<T, maxCompare<T>>;",
+            "",
+            "// Timer parked in the TimingWheel overflow heap, ordered by deadline. The",
+            "// generation tells whether the timer was cancelled while parked.",
+            "struct FarTimer {",
+            "  uint64_t deadline;",
+            "  uint32_t index;",
+            "  uint32_t generation;",
+            "",
+            "  bool operator<(const FarTimer &other) const {",
+            "    return deadline < other.deadline;",
+            "  }",
+            "};",
+            "",
+            "// Timer queue for large numbers of timeouts, most of which are cancelled",
+            "// before they fire. Time is counted in ticks. A deadline less than",
+            "// 2^(8 * Levels) ticks ahead goes into a hierarchy of 256-slot wheels, where",
+            "// schedule and cancel are O(1) list splices. Each level's slots are 256",
+            "// times wider than the level below, and a slot is redistributed to lower",
+            "// levels when time reaches it. Deadlines further away wait in a MinHeap and",
+            "// move into the wheels when the top level wraps. Timers live in one node",
+            "// array recycled through a free list, so steady-state use does not",
+            "// allocate. T must be default constructible.",
+            "template <typename T, int Levels = 4> class TimingWheel {",
+            "  static_assert(Levels >= 1 && Levels <= 7, \"Levels must be in 1..7\");",
+            "",
+            "public:",
+            "  // Handle returned by schedule(): node index and its generation. Handles",
+            "  // of fired or cancelled timers are detected through the generation.",
+            "  using TimerId = uint64_t;",
+            "",
+            "  explicit TimingWheel(uint64_t start = 0) {",
+            "    current = start;",
+            "    freeList = NIL;",
+            "    wheelCount = 0;",
+            "    farCount = 0;",
+            "    staleFar = 0;",
+            "    for (uint32_t &head : slots) {",
+            "      head = NIL;",
+            "    }",
+            "  }",
+            "",
+            "  // Arms a timer that fires on the first tick at or after deadline.",
+            "  // Deadlines not after now() fire on the next tick.",
+            "  TimerId schedule(uint64_t deadline, T payload) {",
+            "    uint32_t index = allocate();",
+            "    TimerNode &node = nodes[index];",
+            "    node.payload = std::move(payload);",
+            "    node.deadline = deadline > current ? deadline : current + 1;",
+            "    place(index);",
+            "    return (static_cast<uint64_t>(node.generation) << 32) | index;",
+            "  }",
+            "",
+            "  // Disarms a timer. Returns false if it already fired or was cancelled.",
+            "  // A timer parked in the heap is only marked stale there; the heap is",
+            "  // rebuilt once stale entries outnumber the live ones.",
+            "  bool cancel(TimerId id) {",
+            "    uint32_t index = static_cast<uint32_t>(id);",
+            "    if (index >= nodes.size() || nodes[index].slot == FREE ||",
+            "        nodes[index].generation != static_cast<uint32_t>(id >> 32)) {",
+            "      return false;",
+            "    }",
+            "",
+            "    if (nodes[index].slot == FAR) {",
+            "      farCount--;",
+            "      staleFar++;",
+            "    } else {",
+            "      unlink(index);",
+            "    }",
+            "    release(index);",
+            "",
+            "    if (staleFar > MIN_COMPACT && staleFar > farCount) {",
+            "      compactFar();",
+            "    }",
+            "    return true;",
+            "  }",
+            "",
+            "  // Moves time forward to `time`, calling fire(T&&) for every timer that",
+            "  // expires on the way, in tick order. All timers due on one tick are",
+            "  // unlinked as a batch before fire() runs for them, so fire() may schedule",
+            "  // and cancel timers, but must not call advance(). Returns the number of",
+            "  // timers fired.",
+            "  template <typename Fn> size_t advance(uint64_t time, Fn fire) {",
+            "    size_t fired = 0;",
+            "    while (current < time) {",
+            "      if (wheelCount == 0) {",
+            "        // Nothing can fire before the top level wraps, so skip to there.",
+            "        uint64_t idle = current | (RANGE - 1);",
+            "        if (idle >= time) {",
+            "          current = time;",
+            "          break;",
+            "        }",
+            "        current = idle;",
+            "      }",
+            "",
+            "      tick();",
+            "      for (T &payload : expired) {",
+            "        fire(std::move(payload));",
+            "      }",
+            "      fired += expired.size();",
+            "      expired.clear();",
+            "    }",
+            "    return fired;",
+            "  }",
+            "",
+            "  // Disarms every timer; handles issued so far become stale.",
+            "  void clear() {",
+            "    for (uint32_t i = 0; i < nodes.size(); i++) {",
+            "      if (nodes[i].slot != FREE)",
+            "        release(i);",
+            "    }",
+            "    for (uint32_t &head : slots) {",
+            "      head = NIL;",
+            "    }",
+            "    far.clear();",
+            "    wheelCount = 0;",
+            "    farCount = 0;",
+            "    staleFar = 0;",
+            "  }",
+            "",
+            "  uint64_t now() const { return current; }",
+            "",
+            "  int size() const { return static_cast<int>(wheelCount + farCount); }",
+            "",
+            "  bool empty() const { return size() == 0; }",
+            "",
+            "private:",
+            "  static const int SLOT_BITS = 8;",
+            "  static const uint32_t SLOTS = 1u << SLOT_BITS;",
+            "  static const uint64_t RANGE = uint64_t(1) << (SLOT_BITS * Levels);",
+            "  static const uint32_t NIL = 0xFFFFFFFFu;",
+            "  static const uint32_t FAR = 0xFFFFFFFEu;  // slot of a timer in the heap",
+            "  static const uint32_t FREE = 0xFFFFFFFDu; // slot of a node on the free list",
+            "  static const size_t MIN_COMPACT = 1024;",
+            "",
+            "  struct TimerNode {",
+            "    T payload;",
+            "    uint64_t deadline = 0;",
+            "    uint32_t next = NIL; // also links the free list",
+            "    uint32_t prev = NIL;",
+            "    uint32_t slot = FREE;",
+            "    uint32_t generation = 1;",
+            "  };",
+            "",
+            "  std::vector<TimerNode> nodes;",
+            "  uint32_t slots[Levels * SLOTS]; // list heads, level by level",
+            "  MinHeap<FarTimer> far;",
+            "  std::vector<T> expired; // batch of the current tick, reused",
+            "  uint64_t current;",
+            "  uint32_t freeList;",
+            "  size_t wheelCount;",
+            "  size_t farCount;",
+            "  size_t staleFar; // cancelled entries still in far",
+            "",
+            "  uint32_t allocate() {",
+            "    if (freeList == NIL) {",
+            "      nodes.emplace_back();",
+            "      return static_cast<uint32_t>(nodes.size() - 1);",
+            "    }",
+            "    uint32_t index = freeList;",
+            "    freeList = nodes[index].next;",
+            "    return index;",
+            "  }",
+            "",
+            "  // Resets the payload and bumps the generation, which invalidates the",
+            "  // handle and any heap entry for the node.",
+            "  void release(uint32_t index) {",
+            "    TimerNode &node = nodes[index];",
+            "    node.payload = T();",
+            "    node.generation++;",
+            "    node.slot = FREE;",
+            "    node.prev = NIL;",
+            "    node.next = freeList;",
+            "    freeList = index;",
+            "  }",
+            "",
+            "  // Files the node by how far its deadline is from now: the lowest level",
+            "  // whose slots cover every bit in which the deadline differs from now.",
+            "  // That slot is always ahead of now within its level, so the node is",
+            "  // reached before the level wraps.",
+            "  void place(uint32_t index) {",
+            "    TimerNode &node = nodes[index];",
+            "    uint64_t diff = node.deadline ^ current;",
+            "    if (diff >= RANGE) {",
+            "      node.slot = FAR;",
+            "      far.insert({node.deadline, index, node.generation});",
+            "      farCount++;",
+            "      return;",
+            "    }",
+            "",
+            "    int level = 0;",
+            "    while (diff >> (SLOT_BITS * (level + 1))) {",
+            "      level++;",
+            "    }",
+            "    uint32_t digit = (node.deadline >> (SLOT_BITS * level)) & (SLOTS - 1);",
+            "    uint32_t slot = level * SLOTS + digit;",
+            "    node.slot = slot;",
+            "    node.prev = NIL;",
+            "    node.next = slots[slot];",
+            "    if (node.next != NIL)",
+            "      nodes[node.next].prev = index;",
+            "    slots[slot] = index;",
+            "    wheelCount++;",
+            "  }",
+            "",
+            "  void unlink(uint32_t index) {",
+            "    TimerNode &node = nodes[index];",
+            "    if (node.prev != NIL) {",
+            "      nodes[node.prev].next = node.next;",
+            "    } else {",
+            "      slots[node.slot] = node.next;",
+            "    }",
+            "    if (node.next != NIL)",
+            "      nodes[node.next].prev = node.prev;",
+            "    wheelCount--;",
+            "  }",
+            "",
+            "  // One step of time. At a multiple of 256^k ticks the level k slot for the",
+            "  // new time is redistributed downwards, highest level first, and at a wrap",
+            "  // of the top level the heap hands over the deadlines that now fit. Then",
+            "  // the level 0 slot is due and its timers move into `expired`.",
+            "  void tick() {",
+            "    current++;",
+            "    if ((current & (RANGE - 1)) == 0)",
+            "      migrateFar();",
+            "    for (int level = Levels - 1; level > 0; level--) {",
+            "      uint64_t below = (uint64_t(1) << (SLOT_BITS * level)) - 1;",
+            "      if ((current & below) == 0) {",
+            "        uint32_t digit = (current >> (SLOT_BITS * level)) & (SLOTS - 1);",
+            "        cascade(level * SLOTS + digit);",
+            "      }",
+            "    }",
+            "",
+            "    uint32_t &head = slots[current & (SLOTS - 1)];",
+            "    for (uint32_t index = head; index != NIL;) {",
+            "      uint32_t next = nodes[index].next;",
+            "      expired.push_back(std::move(nodes[index].payload));",
+            "      release(index);",
+            "      wheelCount--;",
+            "      index = next;",
+            "    }",
+            "    head = NIL;",
+            "  }",
+            "",
+            "  void cascade(uint32_t slot) {",
+            "    uint32_t index = slots[slot];",
+            "    slots[slot] = NIL;",
+            "    while (index != NIL) {",
+            "      uint32_t next = nodes[index].next;",
+            "      wheelCount--;",
+            "      place(index);",
+            "      index = next;",
+            "    }",
+            "  }",
+            "",
+            "  void migrateFar() {",
+            "    while (!far.empty() && far.peek().deadline / RANGE == current / RANGE) {",
+            "      FarTimer entry = far.popRoot();",
+            "      if (nodes[entry.index].generation != entry.generation) {",
+            "        staleFar--;",
+            "        continue;",
+            "      }",
+            "      farCount--;",
+            "      place(entry.index);",
+            "    }",
+            "  }",
+            "",
+            "  // Rebuilds the heap from its live entries in O(n). ThreadPool(1) runs",
+            "  // the heapify inline.",
+            "  void compactFar() {",
+            "    std::vector<FarTimer> live;",
+            "    live.reserve(farCount);",
+            "    far.visitLevelOrder([&](const FarTimer &entry, int) {",
+            "      if (nodes[entry.index].generation == entry.generation)",
+            "        live.push_back(entry);",
+            "    });",
+            "    ThreadPool pool(1);",
+            "    far.buildParallel(std::move(live), pool);",
+            "    staleFar = 0;",
+            "  }",
+            "};"
+        ],
+        "threadSafe": true
+    },
+    {
+        "label": "Stack",
+        "body": [
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "",
+            "template <typename T>",
+            "struct Node {",
+            "  T data;",
+            "  Node<T> *next;",
+            "};",
+            "",
+            "template <typename T>",
+            "class Stack {",
+            "public:",
+            "  Stack() {",
+            "    head = nullptr;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  // Deep copy in the same order, without recursion.",
+            "  Stack(const Stack &other) {",
+            "    head = nullptr;",
+            "    size = 0;",
+            "    Node<T> **link = &head;",
+            "    try {",
+            "      for (Node<T> *current = other.head; current != nullptr;",
+            "           current = current->next) {",
+            "        *link = new Node<T>{current->data, nullptr};",
+            "        link = &(*link)->next;",
+            "        size++;",
+            "      }",
+            "    } catch (...) {",
+            "      clear();",
+            "      throw;",
+            "    }",
+            "  }",
+            "",
+            "  Stack(Stack &&other) noexcept {",
+            "    head = other.head;",
+            "    size = other.size;",
+            "    other.head = nullptr;",
+            "    other.size = 0;",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  Stack &operator=(Stack other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~Stack() { clear(); }",
+            "",
+            "  void swap(Stack &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  T pop() {",
+            "    if (isEmpty()) {",
+            "      throw std::runtime_error(\"Stack is empty\");",
+            "    }",
+            "",
+            "    size--;",
+            "    Node<T> *oldHead = head;",
+            "    T data = std::move(oldHead->data);",
+            "    head = oldHead->next;",
+            "    delete oldHead;",
+            "    return data;",
+            "  }",
+            "",
+            "  void push(const T &data) {",
+            "    head = new Node<T>{data, head};",
+            "    size++;",
+            "  }",
+            "",
+            "  void push(T &&data) {",
+            "    head = new Node<T>{std::move(data), head};",
+            "    size++;",
+            "  }",
+            "",
+            "  void clear() {",
+            "    while (head != nullptr) {",
+            "      Node<T> *next = head->next;",
+            "      delete head;",
+            "      head = next;",
+            "    }",
+            "    size = 0;",
+            "  }",
+            "",
+            "  bool isEmpty() { return size == 0; }",
+            "",
+            "  int getSize() { return size; }",
+            "",
+            "  // Formats all elements into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Stack (size=\" << size << \"): \";",
+            "    visit([&buffer](const T &data) { buffer << data << \" \"; });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(data) for every element from top to bottom.",
+            "  template <typename Fn> void visit(Fn fn) const {",
+            "    for (Node<T> *current = head; current != nullptr;",
+            "         current = current->next) {",
+            "      fn(current->data);",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  Node<T> *head;",
+            "  int size;",
+            "};"
+        ],
+        "threadSafe": true
+    },
+    {
+        "label": "Queue",
+        "body": [
+            "#include <algorithm>",
+            "#include <atomic>",
+            "#include <chrono>",
+            "#include <condition_variable>",
+            "#include <iostream>",
+            "#include <mutex>",
+            "#include <optional>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "#include <vector>",
+            "#if defined(__SSE2__)",
+            "#include <emmintrin.h>",
+            "#endif",
+            "#if defined(__cpp_impl_coroutine)",
+            "#include <coroutine>",
+            "#endif",
+            "",
+            "template <typename T> struct Node {",
+            "  T data;",
+            "  Node<T> *next;",
+            "",
+            "  Node(T data, Node<T> *next = nullptr) : data(std::move(data)), next(next) {}",
+            "};",
+            "",
+            "template <typename T> class Queue {",
+            "public:",
+            "  Queue() {",
+            "    head = nullptr;",
+            "    tail = nullptr;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  // Deep copy in the same order.",
+            "  Queue(const Queue &other) : Queue() {",
+            "    try {",
+            "      other.visit([this](const T &data) { enqueue(data); });",
+            "    } catch (...) {",
+            "      clear();",
+            "      throw;",
+            "    }",
+            "  }",
+            "",
+            "  Queue(Queue &&other) noexcept {",
+            "    head = other.head;",
+            "    tail = other.tail;",
+            "    size = other.size;",
+            "    other.head = nullptr;",
+            "    other.tail = nullptr;",
+            "    other.size = 0;",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  Queue &operator=(Queue other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~Queue() { clear(); }",
+            "",
+            "  void swap(Queue &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(tail, other.tail);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void enqueue(const T &data) { link(new Node<T>(data)); }",
+            "",
+            "  void enqueue(T &&data) { link(new Node<T>(std::move(data))); }",
+            "",
+            "  T dequeue() {",
+            "    if (size == 0) {",
+            "      throw std::out_of_range(\"Queue is empty\");",
+            "    }",
+            "",
+            "    size--;",
+            "    T data = std::move(head->data);",
+            "    Node<T> *oldHead = head;",
+            "    head = head->next;",
+            "    delete oldHead;",
+            "",
+            "    if (head == nullptr) {",
+            "      tail = nullptr;",
+            "    }",
+            "",
+            "    return data;",
+            "  }",
+            "",
+            "  void clear() {",
+            "    while (head != nullptr) {",
+            "      Node<T> *next = head->next;",
+            "      delete head;",
+            "      head = next;",
+            "    }",
+            "    tail = nullptr;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  bool isEmpty() { return size == 0; }",
+            "",
+            "  int getSize() { return size; }",
+            "",
+            "  // Formats all elements into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Queue (size=\" << size << \"): \";",
+            "    visit([&buffer](const T &data) { buffer << data << \" \"; });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(data) for every element from front to back.",
+            "  template <typename Fn> void visit(Fn fn) const {",
+            "    for (Node<T> *current = head; current != nullptr;",
+            "         current = current->next) {",
+            "      fn(current->data);",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  Node<T> *head;",
+            "  Node<T> *tail;",
+            "  int size;",
+            "",
+            "  void link(Node<T> *node) {",
+            "    size++;",
+            "    if (tail == nullptr) {",
+            "      head = tail = node;",
+            "    } else {",
+            "      tail->next = node;",
+            "      tail = node;",
+            "    }",
+            "  }",
+            "};",
+            "",
+            "// Hint to the CPU that we are in a spin-wait loop.",
+            "inline void cpuRelax() {",
+            "#if defined(__SSE2__)",
+            "  _mm_pause();",
+            "#endif",
+            "}",
+            "",
+            "// Bounded thread-safe queue on top of Queue. Producers block while it is full",
+            "// and consumers block while it is empty. A waiter first spins for a moment on",
+            "// the lock-free size, then parks on a condition variable (a futex on Linux).",
+            "// The other side only pays for a wakeup when somebody is actually parked.",
+            "template <typename T> class BlockingQueue {",
+            "public:",
+            "  explicit BlockingQueue(int capacity) {",
+            "    if (capacity <= 0) {",
+            "      throw std::invalid_argument(\"Capacity must be positive\");",
+            "    }",
+            "    this->capacity = capacity;",
+            "    count = 0;",
+            "    closed = false;",
+            "    waitingPush = 0;",
+            "    waitingPop = 0;",
+            "  }",
+            "",
+            "  // Parked threads and coroutines point into the queue, so it can be",
+            "  // neither copied nor moved.",
+            "  BlockingQueue(const BlockingQueue &) = delete;",
+            "  BlockingQueue &operator=(const BlockingQueue &) = delete;",
+            "",
+            "  // Blocks while the queue is full. Throws once the queue is closed.",
+            "  void push(T data) {",
+            "    if (!pushWait(data, false, {})) {",
+            "      throw std::runtime_error(\"Queue is closed\");",
+            "    }",
+            "  }",
+            "",
+            "  // Returns false instead of blocking when the queue is full or closed.",
+            "  bool tryPush(T data) {",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    if (closed || items.getSize() >= capacity)",
+            "      return false;",
+            "    putLocked(lock, data);",
+            "    return true;",
+            "  }",
+            "",
+            "  // Waits at most timeout for a free slot.",
+            "  bool tryPush(T data, std::chrono::nanoseconds timeout) {",
+            "    return pushWait(data, true, std::chrono::steady_clock::now() + timeout);",
+            "  }",
+            "",
+            "  // Pushes every element, blocking whenever the queue is full. Consumers are",
+            "  // woken once per run of elements that fit, not once per element.",
+            "  void pushAll(const std::vector<T> &data) {",
+            "    size_t next = 0;",
+            "    while (next < data.size()) {",
+            "      spinUntil([this] {",
+            "        return count.load(std::memory_order_relaxed) < capacity ||",
+            "               closed.load(std::memory_order_relaxed);",
+            "      });",
+            "      std::unique_lock<std::mutex> lock(mutex);",
+            "      while (!closed && items.getSize() >= capacity) {",
+            "        park(notFull, lock, waitingPush, false, {});",
+            "      }",
+            "      if (closed) {",
+            "        throw std::runtime_error(\"Queue is closed\");",
+            "      }",
+            "",
+            "#if defined(__cpp_impl_coroutine)",
+            "      if (!asyncWaiters.isEmpty()) {",
+            "        T item = data[next++];",
+            "        putLocked(lock, item);",
+            "        continue;",
+            "      }",
+            "#endif",
+            "",
+            "      int added = 0;",
+            "      while (next < data.size() && items.getSize() < capacity) {",
+            "        items.enqueue(data[next++]);",
+            "        added++;",
+            "      }",
+            "      count.store(items.getSize(), std::memory_order_relaxed);",
+            "      int wake = std::min(added, waitingPop);",
+            "      lock.unlock();",
+            "      wakeUp(notEmpty, wake);",
+            "    }",
+            "  }",
+            "",
+            "  // Blocks while the queue is empty. Throws once the queue is closed and",
+            "  // drained.",
+            "  T pop() {",
+            "    std::optional<T> data;",
+            "    if (!popWait(data, false, {})) {",
+            "      throw std::out_of_range(\"Queue is closed\");",
+            "    }",
+            "    return std::move(*data);",
+            "  }",
+            "",
+            "  // Returns false instead of blocking when the queue is empty.",
+            "  bool tryPop(T &data) {",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    if (items.isEmpty())",
+            "      return false;",
+            "    data = takeLocked(lock);",
+            "    return true;",
+            "  }",
+            "",
+            "  // Waits at most timeout for an element.",
+            "  bool tryPop(T &data, std::chrono::nanoseconds timeout) {",
+            "    std::optional<T> item;",
+            "    if (!popWait(item, true, std::chrono::steady_clock::now() + timeout))",
+            "      return false;",
+            "    data = std::move(*item);",
+            "    return true;",
+            "  }",
+            "",
+            "  // Waits for at least one element, then moves up to max elements into out.",
+            "  // Returns how many were taken, 0 once the queue is closed and drained.",
+            "  int popBatch(std::vector<T> &out, int max) {",
+            "    spinUntil([this] {",
+            "      return count.load(std::memory_order_relaxed) > 0 ||",
+            "             closed.load(std::memory_order_relaxed);",
+            "    });",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    while (!closed && items.isEmpty()) {",
+            "      park(notEmpty, lock, waitingPop, false, {});",
+            "    }",
+            "",
+            "    int taken = 0;",
+            "    while (taken < max && !items.isEmpty()) {",
+            "      out.push_back(items.dequeue());",
+            "      taken++;",
+            "    }",
+            "    count.store(items.getSize(), std::memory_order_relaxed);",
+            "    int wake = std::min(taken, waitingPush);",
+            "    lock.unlock();",
+            "    wakeUp(notFull, wake);",
+            "    return taken;",
+            "  }",
+            "",
+            "  // Wakes every waiter. Pushes fail from now on; pops drain what is left and",
+            "  // then fail.",
+            "  void close() {",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    closed = true;",
+            "#if defined(__cpp_impl_coroutine)",
+            "    std::vector<PopAwaiter *> waiters;",
+            "    while (!asyncWaiters.isEmpty()) {",
+            "      waiters.push_back(asyncWaiters.dequeue());",
+            "    }",
+            "#endif",
+            "    lock.unlock();",
+            "    notEmpty.notify_all();",
+            "    notFull.notify_all();",
+            "#if defined(__cpp_impl_coroutine)",
+            "    for (PopAwaiter *waiter : waiters) {",
+            "      waiter->handle.resume();",
+            "    }",
+            "#endif",
+            "  }",
+            "",
+            "  bool isClosed() const { return closed.load(); }",
+            "",
+            "  int getSize() const { return count.load(std::memory_order_relaxed); }",
+            "",
+            "  int getCapacity() const { return capacity; }",
+            "",
+            "#if defined(__cpp_impl_coroutine)",
+            "  class PopAwaiter {",
+            "  public:",
+            "    explicit PopAwaiter(BlockingQueue *queue) : queue(queue) {}",
+            "",
+            "    bool await_ready() { return false; }",
+            "",
+            "    // Takes an element right away if there is one. Otherwise registers the",
+            "    // coroutine while still holding the lock, so a concurrent push cannot",
+            "    // slip in between the check and the registration.",
+            "    bool await_suspend(std::coroutine_handle<> h) {",
+            "      std::unique_lock<std::mutex> lock(queue->mutex);",
+            "      if (!queue->items.isEmpty()) {",
+            "        data = queue->takeLocked(lock);",
+            "        return false;",
+            "      }",
+            "      if (queue->closed)",
+            "        return false;",
+            "      handle = h;",
+            "      queue->asyncWaiters.enqueue(this);",
+            "      return true;",
+            "    }",
+            "",
+            "    T await_resume() {",
+            "      if (!data) {",
+            "        throw std::out_of_range(\"Queue is closed\");",
+            "      }",
+            "      return std::move(*data);",
+            "    }",
+            "",
+            "  private:",
+            "    friend class BlockingQueue;",
+            "",
+            "    BlockingQueue *queue;",
+            "    std::coroutine_handle<> handle;",
+            "    std::optional<T> data;",
+            "  };",
+            "",
+            "  // `co_await queue.popAsync()` suspends the coroutine instead of blocking",
+            "  // the thread. The pushing thread hands over the element and resumes the",
+            "  // coroutine. Throws like pop() once the queue is closed and drained; call",
+            "  // close() before destroying a queue that coroutines may still wait on.",
+            "  PopAwaiter popAsync() { return PopAwaiter(this); }",
+            "#endif",
+            "",
+            "private:",
+            "  static const int SPIN_COUNT = 256;",
+            "",
+            "  Queue<T> items;",
+            "  int capacity;",
+            "  std::mutex mutex;",
+            "  std::condition_variable notEmpty;",
+            "  std::condition_variable notFull;",
+            "  std::atomic<int> count; // items.getSize(), readable without the lock",
+            "  std::atomic<bool> closed;",
+            "  int waitingPush;",
+            "  int waitingPop;",
+            "#if defined(__cpp_impl_coroutine)",
+            "  Queue<PopAwaiter *> asyncWaiters;",
+            "#endif",
+            "",
+            "  template <typename Pred> static void spinUntil(Pred ready) {",
+            "    for (int i = 0; i < SPIN_COUNT && !ready(); i++) {",
+            "      cpuRelax();",
+            "    }",
+            "  }",
+            "",
+            "  // Waits on cv with the lock held. Returns false on timeout.",
+            "  static bool park(std::condition_variable &cv,",
+            "                   std::unique_lock<std::mutex> &lock, int &waiting,",
+            "                   bool timed, std::chrono::steady_clock::time_point deadline) {",
+            "    waiting++;",
+            "    bool woken = true;",
+            "    if (timed) {",
+            "      woken = cv.wait_until(lock, deadline) == std::cv_status::no_timeout;",
+            "    } else {",
+            "      cv.wait(lock);",
+            "    }",
+            "    waiting--;",
+            "    return woken;",
+            "  }",
+            "",
+            "  static void wakeUp(std::condition_variable &cv, int waiters) {",
+            "    if (waiters > 1) {",
+            "      cv.notify_all();",
+            "    } else if (waiters == 1) {",
+            "      cv.notify_one();",
+            "    }",
+            "  }",
+            "",
+            "  bool pushWait(T &data, bool timed,",
+            "                std::chrono::steady_clock::time_point deadline) {",
+            "    spinUntil([this] {",
+            "      return count.load(std::memory_order_relaxed) < capacity ||",
+            "             closed.load(std::memory_order_relaxed);",
+            "    });",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    while (!closed && items.getSize() >= capacity) {",
+            "      if (!park(notFull, lock, waitingPush, timed, deadline))",
+            "        break;",
+            "    }",
+            "    if (closed || items.getSize() >= capacity)",
+            "      return false;",
+            "    putLocked(lock, data);",
+            "    return true;",
+            "  }",
+            "",
+            "  bool popWait(std::optional<T> &data, bool timed,",
+            "               std::chrono::steady_clock::time_point deadline) {",
+            "    spinUntil([this] {",
+            "      return count.load(std::memory_order_relaxed) > 0 ||",
+            "             closed.load(std::memory_order_relaxed);",
+            "    });",
+            "    std::unique_lock<std::mutex> lock(mutex);",
+            "    while (!closed && items.isEmpty()) {",
+            "      if (!park(notEmpty, lock, waitingPop, timed, deadline))",
+            "        break;",
+            "    }",
+            "    if (items.isEmpty())",
+            "      return false;",
+            "    data = takeLocked(lock);",
+            "    return true;",
+            "  }",
+            "",
+            "  // Hands data to a suspended coroutine if one is waiting, otherwise queues",
+            "  // it and wakes one parked consumer. Releases the lock.",
+            "  void putLocked(std::unique_lock<std::mutex> &lock, T &data) {",
+            "#if defined(__cpp_impl_coroutine)",
+            "    if (!asyncWaiters.isEmpty()) {",
+            "      PopAwaiter *waiter = asyncWaiters.dequeue();",
+            "      waiter->data = std::move(data);",
+            "      lock.unlock();",
+            "      waiter->handle.resume();",
+            "      return;",
+            "    }",
+            "#endif",
+            "    items.enqueue(std::move(data));",
+            "    count.store(items.getSize(), std::memory_order_relaxed);",
+            "    int wake = std::min(1, waitingPop);",
+            "    lock.unlock();",
+            "    wakeUp(notEmpty, wake);",
+            "  }",
+            "",
+            "  // Dequeues one element and wakes one parked producer. Releases the lock.",
+            "  T takeLocked(std::unique_lock<std::mutex> &lock) {",
+            "    T data = items.dequeue();",
+            "    count.store(items.getSize(), std::memory_order_relaxed);",
+            "    int wake = std::min(1, waitingPush);",
+            "    lock.unlock();",
+            "    wakeUp(notFull, wake);",
+            "    return data;",
+            "  }",
+            "};"
+        ],
+        "threadSafe": false
+    },
+    {
+        "label": "Deque",
+        "body": [
+            "#include <algorithm>",
+            "#include <cstddef>",
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "",
+            "template <typename T> struct Node {",
+            "  T data;",
+            "  Node<T> *next;",
+            "  Node<T> *prev;",
+            "",
+            "  Node(T v) : data(std::move(v)) {",
+            "    next = nullptr;",
+            "    prev = nullptr;",
+            "  }",
+            "};",
+            "",
+            "template <typename T> class Queue {",
+            "public:",
+            "  Node<T> *head;",
+            "  Node<T> *tail;",
+            "  int size;",
+            "  Queue() {",
+            "    head = nullptr;",
+            "    tail = nullptr;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  // Deep copy in the same order.",
+            "  Queue(const Queue &other) : Queue() {",
+            "    try {",
+            "      other.visit([this](const T &data) { pushBack(data); });",
+            "    } catch (...) {",
+            "      clear();",
+            "      throw;",
+            "    }",
+            "  }",
+            "",
+            "  Queue(Queue &&other) noexcept {",
+            "    head = other.head;",
+            "    tail = other.tail;",
+            "    size = other.size;",
+            "    other.head = nullptr;",
+            "    other.tail = nullptr;",
+            "    other.size = 0;",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  Queue &operator=(Queue other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~Queue() { clear(); }",
+            "",
+            "  void swap(Queue &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(tail, other.tail);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void clear() {",
+            "    while (head != nullptr) {",
+            "      Node<T> *next = head->next;",
+            "      delete head;",
+            "      head = next;",
+            "    }",
+            "    tail = nullptr;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  T popBack() {",
+            "    if (tail == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "",
+            "    Node<T> *nodeToDelete = tail;",
+            "    T data = std::move(tail->data);",
+            "",
+            "    if (head == tail) {",
+            "      head = nullptr;",
+            "      tail = nullptr;",
+            "    } else {",
+            "      tail = tail->prev;",
+            "      tail->next = nullptr;",
+            "    }",
             "",
-            "  void clear() { arr.clear(); }",
+            "    delete nodeToDelete;",
+            "    size--;",
+            "    return data;",
+            "  }",
+            "",
+            "  T popForward() {",
+            "    if (head == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "",
+            "    Node<T> *nodeToDelete = head;",
+            "    T data = std::move(head->data);",
+            "",
+            "    if (head == tail) {",
+            "      head = nullptr;",
+            "      tail = nullptr;",
+            "    } else {",
+            "      head = head->next;",
+            "      head->prev = nullptr;",
+            "    }",
+            "",
+            "    delete nodeToDelete;",
+            "    size--;",
+            "    return data;",
+            "  }",
+            "",
+            "  void pushBack(const T &data) { linkBack(new Node<T>(data)); }",
+            "",
+            "  void pushBack(T &&data) { linkBack(new Node<T>(std::move(data))); }",
+            "",
+            "  void pushForward(const T &data) { linkForward(new Node<T>(data)); }",
             "",
-            "  void print() const {",
-            "    print(0, 0);",
-            "    std::cout << std::endl;",
+            "  void pushForward(T &&data) { linkForward(new Node<T>(std::move(data))); }",
+            "",
+            "  // Formats all elements into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Deque (size=\" << size << \"): \";",
+            "    visit([&buffer](const T &data) { buffer << data << \" \"; });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(data) for every element from front to back.",
+            "  template <typename Fn> void visit(Fn fn) const {",
+            "    for (Node<T> *current = head; current != nullptr;",
+            "         current = current->next) {",
+            "      fn(current->data);",
+            "    }",
             "  }",
             "",
             "private:",
-            "  std::vector<int> arr;",
+            "  void linkBack(Node<T> *node) {",
+            "    if (tail == nullptr) {",
+            "      head = node;",
+            "      tail = node;",
+            "    } else {",
+            "      tail->next = node;",
+            "      node->prev = tail;",
+            "      tail = node;",
+            "    }",
+            "    size++;",
+            "  }",
             "",
-            "  void siftUp(int i) {",
-            "    while (i > 0) {",
-            "      int p = (i - 1) / 2;",
-            "      if (Comp(arr[i], arr[p])) {",
-            "        std::swap(arr[i], arr[p]);",
-            "        i = p;",
-            "      } else {",
+            "  void linkForward(Node<T> *node) {",
+            "    if (head == nullptr) {",
+            "      head = node;",
+            "      tail = node;",
+            "    } else {",
+            "      head->prev = node;",
+            "      node->next = head;",
+            "      head = node;",
+            "    }",
+            "    size++;",
+            "  }",
+            "};",
+            "",
+            "// Contiguous run of elements inside a ChunkedDeque, laid out like iovec.",
+            "template <typename T> struct Segment {",
+            "  T *data;",
+            "  size_t size;",
+            "};",
+            "",
+            "template <typename T, int ChunkSize> struct Chunk {",
+            "  T data[ChunkSize];",
+            "  int begin; // first live element",
+            "  int end;   // one past the last live element",
+            "  Chunk *next;",
+            "  Chunk *prev;",
+            "};",
+            "",
+            "// Deque stored as a doubly-linked list of fixed-size chunks instead of one",
+            "// node per element, so its contents can be handed to writev/readv as a few",
+            "// contiguous segments. frontSegments + consume drain the front without",
+            "// popping element by element. backSegments + commit let the caller fill",
+            "// free space at the back in place. T must be default constructible; for",
+            "// readv into the back segments it should also be trivially copyable.",
+            "template <typename T,",
+            "          int ChunkSize = (sizeof(T) < 256 ? 4096 / sizeof(T) : 16)>",
+            "class ChunkedDeque {",
+            "public:",
+            "  ChunkedDeque() {",
+            "    head = nullptr;",
+            "    tail = nullptr;",
+            "    spare = nullptr;",
+            "    spareCount = 0;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  // Deep copy of the elements; spare chunks are not copied.",
+            "  ChunkedDeque(const ChunkedDeque &other) : ChunkedDeque() {",
+            "    try {",
+            "      other.visit([this](const T &data) { pushBack(data); });",
+            "    } catch (...) {",
+            "      freeList(head);",
+            "      freeList(spare);",
+            "      throw;",
+            "    }",
+            "  }",
+            "",
+            "  ChunkedDeque(ChunkedDeque &&other) noexcept : ChunkedDeque() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  ChunkedDeque &operator=(ChunkedDeque other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~ChunkedDeque() {",
+            "    freeList(head);",
+            "    freeList(spare);",
+            "  }",
+            "",
+            "  void swap(ChunkedDeque &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(tail, other.tail);",
+            "    std::swap(spare, other.spare);",
+            "    std::swap(spareCount, other.spareCount);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void pushBack(const T &data) { pushBackValue(data); }",
+            "  void pushBack(T &&data) { pushBackValue(std::move(data)); }",
+            "  void pushForward(const T &data) { pushForwardValue(data); }",
+            "  void pushForward(T &&data) { pushForwardValue(std::move(data)); }",
+            "",
+            "  T popBack() {",
+            "    if (tail == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "    T data = std::move(tail->data[--tail->end]);",
+            "    size--;",
+            "    if (tail->begin == tail->end) {",
+            "      unlink(tail);",
+            "    }",
+            "    return data;",
+            "  }",
+            "",
+            "  T popForward() {",
+            "    if (head == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "    T data = std::move(head->data[head->begin++]);",
+            "    size--;",
+            "    if (head->begin == head->end) {",
+            "      unlink(head);",
+            "    }",
+            "    return data;",
+            "  }",
+            "",
+            "  // Writes up to max segments covering the deque from the front, in order,",
+            "  // and returns how many were written. Segments stay valid until the deque",
+            "  // is modified.",
+            "  int frontSegments(Segment<T> *out, int max) const {",
+            "    int n = 0;",
+            "    for (Chunk<T, ChunkSize> *chunk = head; chunk != nullptr && n < max;",
+            "         chunk = chunk->next) {",
+            "      out[n++] = {chunk->data + chunk->begin,",
+            "                  static_cast<size_t>(chunk->end - chunk->begin)};",
+            "    }",
+            "    return n;",
+            "  }",
+            "",
+            "  // Drops count elements from the front, e.g. after writev sent them.",
+            "  void consume(size_t count) {",
+            "    if (count > static_cast<size_t>(size)) {",
+            "      throw std::out_of_range(\"Deque has fewer elements\");",
+            "    }",
+            "    size -= static_cast<int>(count);",
+            "    while (count > 0) {",
+            "      size_t available = head->end - head->begin;",
+            "      if (count < available) {",
+            "        head->begin += static_cast<int>(count);",
             "        break;",
             "      }",
+            "      count -= available;",
+            "      unlink(head);",
             "    }",
             "  }",
             "",
-            "  void siftDown(int i) {",
-            "    int n = static_cast<int>(arr.size());",
-            "    while (true) {",
-            "      int left = 2 * i + 1;",
-            "      int right = 2 * i + 2;",
-            "      int nest = i;",
+            "  // Writes up to max segments of free space at the back, together at least",
+            "  // want elements long when max allows, and returns how many were written.",
+            "  // Fill them (e.g. with readv), then call commit. No other modification may",
+            "  // happen in between.",
+            "  int backSegments(Segment<T> *out, int max, size_t want) {",
+            "    int n = 0;",
+            "    size_t room = 0;",
+            "    if (tail != nullptr && tail->end < ChunkSize && n < max) {",
+            "      out[n++] = {tail->data + tail->end,",
+            "                  static_cast<size_t>(ChunkSize - tail->end)};",
+            "      room += ChunkSize - tail->end;",
+            "    }",
+            "    Chunk<T, ChunkSize> **link = &spare;",
+            "    while (room < want && n < max) {",
+            "      if (*link == nullptr) {",
+            "        *link = new Chunk<T, ChunkSize>;",
+            "        (*link)->next = nullptr;",
+            "        spareCount++;",
+            "      }",
+            "      out[n++] = {(*link)->data, static_cast<size_t>(ChunkSize)};",
+            "      room += ChunkSize;",
+            "      link = &(*link)->next;",
+            "    }",
+            "    return n;",
+            "  }",
             "",
-            "      if (left < n && Comp(arr[left], arr[nest])) {",
-            "        nest = left;",
+            "  // Appends count elements that were written into the back segments.",
+            "  void commit(size_t count) {",
+            "    size_t room = static_cast<size_t>(spareCount) * ChunkSize;",
+            "    if (tail != nullptr) {",
+            "      room += ChunkSize - tail->end;",
+            "    }",
+            "    if (count > room) {",
+            "      throw std::out_of_range(\"Commit exceeds reserved space\");",
+            "    }",
+            "",
+            "    size += static_cast<int>(count);",
+            "    if (tail != nullptr && tail->end < ChunkSize) {",
+            "      size_t filled =",
+            "          std::min(count, static_cast<size_t>(ChunkSize - tail->end));",
+            "      tail->end += static_cast<int>(filled);",
+            "      count -= filled;",
+            "    }",
+            "    while (count > 0) {",
+            "      // Spares come out in the order backSegments handed them out.",
+            "      Chunk<T, ChunkSize> *chunk = takeChunk(0);",
+            "      chunk->end = static_cast<int>(std::min(count, size_t(ChunkSize)));",
+            "      count -= chunk->end;",
+            "      linkBack(chunk);",
+            "    }",
+            "  }",
+            "",
+            "  bool isEmpty() const { return size == 0; }",
+            "",
+            "  int getSize() const { return size; }",
+            "",
+            "  // Formats all elements into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Deque (size=\" << size << \"): \";",
+            "    visit([&buffer](const T &data) { buffer << data << \" \"; });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(data) for every element from front to back.",
+            "  template <typename Fn> void visit(Fn fn) const {",
+            "    for (Chunk<T, ChunkSize> *chunk = head; chunk != nullptr;",
+            "         chunk = chunk->next) {",
+            "      for (int i = chunk->begin; i < chunk->end; i++) {",
+            "        fn(chunk->data[i]);",
             "      }",
-            "      if (right < n && Comp(arr[right], arr[nest])) {",
-            "        nest = right;",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  // Spare chunks kept after they empty out, so a deque used as an I/O buffer",
+            "  // does not allocate in steady state.",
+            "  static const int MAX_SPARE = 2;",
+            "",
+            "  Chunk<T, ChunkSize> *head;",
+            "  Chunk<T, ChunkSize> *tail;",
+            "  Chunk<T, ChunkSize> *spare; // singly linked through next",
+            "  int spareCount;",
+            "  int size;",
+            "",
+            "  // The element is assigned before tail->end moves, and a new chunk is",
+            "  // linked only once the assignment into it succeeded, so a throwing",
+            "  // assignment leaves the deque unchanged.",
+            "  template <typename U> void pushBackValue(U &&data) {",
+            "    if (tail != nullptr && tail->end < ChunkSize) {",
+            "      tail->data[tail->end] = std::forward<U>(data);",
+            "      tail->end++;",
+            "    } else {",
+            "      Chunk<T, ChunkSize> *chunk = takeChunk(0);",
+            "      try {",
+            "        chunk->data[0] = std::forward<U>(data);",
+            "      } catch (...) {",
+            "        release(chunk);",
+            "        throw;",
             "      }",
+            "      chunk->end = 1;",
+            "      linkBack(chunk);",
+            "    }",
+            "    size++;",
+            "  }",
             "",
-            "      if (nest != i) {",
-            "        std::swap(arr[i], arr[nest]);",
-            "        i = nest;",
-            "      } else {",
+            "  // Mirror of pushBackValue.",
+            "  template <typename U> void pushForwardValue(U &&data) {",
+            "    if (head != nullptr && head->begin > 0) {",
+            "      head->data[head->begin - 1] = std::forward<U>(data);",
+            "      head->begin--;",
+            "    } else {",
+            "      Chunk<T, ChunkSize> *chunk = takeChunk(ChunkSize);",
+            "      try {",
+            "        chunk->data[ChunkSize - 1] = std::forward<U>(data);",
+            "      } catch (...) {",
+            "        release(chunk);",
+            "        throw;",
+            "      }",
+            "      chunk->begin = ChunkSize - 1;",
+            "      linkForward(chunk);",
+            "    }",
+            "    size++;",
+            "  }",
+            "",
+            "  // Returns an empty chunk with begin = end = at, reusing a spare if any.",
+            "  Chunk<T, ChunkSize> *takeChunk(int at) {",
+            "    Chunk<T, ChunkSize> *chunk = spare;",
+            "    if (chunk != nullptr) {",
+            "      spare = chunk->next;",
+            "      spareCount--;",
+            "    } else {",
+            "      chunk = new Chunk<T, ChunkSize>;",
+            "    }",
+            "    chunk->begin = at;",
+            "    chunk->end = at;",
+            "    chunk->next = nullptr;",
+            "    chunk->prev = nullptr;",
+            "    return chunk;",
+            "  }",
+            "",
+            "  void linkBack(Chunk<T, ChunkSize> *chunk) {",
+            "    chunk->prev = tail;",
+            "    if (tail == nullptr) {",
+            "      head = chunk;",
+            "    } else {",
+            "      tail->next = chunk;",
+            "    }",
+            "    tail = chunk;",
+            "  }",
+            "",
+            "  void linkForward(Chunk<T, ChunkSize> *chunk) {",
+            "    chunk->next = head;",
+            "    if (head == nullptr) {",
+            "      tail = chunk;",
+            "    } else {",
+            "      head->prev = chunk;",
+            "    }",
+            "    head = chunk;",
+            "  }",
+            "",
+            "  // Removes an empty chunk from the list and keeps or frees it.",
+            "  void unlink(Chunk<T, ChunkSize> *chunk) {",
+            "    if (chunk->prev) {",
+            "      chunk->prev->next = chunk->next;",
+            "    } else {",
+            "      head = chunk->next;",
+            "    }",
+            "    if (chunk->next) {",
+            "      chunk->next->prev = chunk->prev;",
+            "    } else {",
+            "      tail = chunk->prev;",
+            "    }",
+            "    release(chunk);",
+            "  }",
+            "",
+            "  // Keeps an unlinked chunk as a spare, or frees it.",
+            "  void release(Chunk<T, ChunkSize> *chunk) {",
+            "    if (spareCount < MAX_SPARE) {",
+            "      chunk->next = spare;",
+            "      spare = chunk;",
+            "      spareCount++;",
+            "    } else {",
+            "      delete chunk;",
+            "    }",
+            "  }",
+            "",
+            "  static void freeList(Chunk<T, ChunkSize> *chunk) {",
+            "    while (chunk != nullptr) {",
+            "      Chunk<T, ChunkSize> *next = chunk->next;",
+            "      delete chunk;",
+            "      chunk = next;",
+            "    }",
+            "  }",
+            "};"
+        ],
+        "threadSafe": true,
+        "arrayBacked": [
+            "#include <algorithm>",
+            "#include <cstddef>",
+            "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "",
+            "template <typename T> struct Segment {",
+            "  T *data;",
+            "  size_t size;",
+            "};",
+            "",
+            "template <typename T, int ChunkSize> struct Chunk {",
+            "  T data[ChunkSize];",
+            "  int begin; // first live element",
+            "  int end;   // one past the last live element",
+            "  Chunk *next;",
+            "  Chunk *prev;",
+            "};",
+            "",
+            "// Deque stored as a doubly-linked list of fixed-size chunks instead of one",
+            "// node per element, so its contents can be handed to writev/readv as a few",
+            "// contiguous segments. frontSegments + consume drain the front without",
+            "// popping element by element. backSegments + commit let the caller fill",
+            "// free space at the back in place. T must be default constructible; for",
+            "// readv into the back segments it should also be trivially copyable.",
+            "template <typename T,",
+            "          int ChunkSize = (sizeof(T) < 256 ? 4096 / sizeof(T) : 16)>",
+            "class ChunkedDeque {",
+            "public:",
+            "  ChunkedDeque() {",
+            "    head = nullptr;",
+            "    tail = nullptr;",
+            "    spare = nullptr;",
+            "    spareCount = 0;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  // Deep copy of the elements; spare chunks are not copied.",
+            "  ChunkedDeque(const ChunkedDeque &other) : ChunkedDeque() {",
+            "    try {",
+            "      other.visit([this](const T &data) { pushBack(data); });",
+            "    } catch (...) {",
+            "      freeList(head);",
+            "      freeList(spare);",
+            "      throw;",
+            "    }",
+            "  }",
+            "",
+            "  ChunkedDeque(ChunkedDeque &&other) noexcept : ChunkedDeque() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  // Copy-and-swap: copies when given an lvalue, steals when given an rvalue.",
+            "  ChunkedDeque &operator=(ChunkedDeque other) noexcept {",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~ChunkedDeque() {",
+            "    freeList(head);",
+            "    freeList(spare);",
+            "  }",
+            "",
+            "  void swap(ChunkedDeque &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(tail, other.tail);",
+            "    std::swap(spare, other.spare);",
+            "    std::swap(spareCount, other.spareCount);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void pushBack(const T &data) { pushBackValue(data); }",
+            "  void pushBack(T &&data) { pushBackValue(std::move(data)); }",
+            "  void pushForward(const T &data) { pushForwardValue(data); }",
+            "  void pushForward(T &&data) { pushForwardValue(std::move(data)); }",
+            "",
+            "  T popBack() {",
+            "    if (tail == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "    T data = std::move(tail->data[--tail->end]);",
+            "    size--;",
+            "    if (tail->begin == tail->end) {",
+            "      unlink(tail);",
+            "    }",
+            "    return data;",
+            "  }",
+            "",
+            "  T popForward() {",
+            "    if (head == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "    T data = std::move(head->data[head->begin++]);",
+            "    size--;",
+            "    if (head->begin == head->end) {",
+            "      unlink(head);",
+            "    }",
+            "    return data;",
+            "  }",
+            "",
+            "  // Writes up to max segments covering the deque from the front, in order,",
+            "  // and returns how many were written. Segments stay valid until the deque",
+            "  // is modified.",
+            "  int frontSegments(Segment<T> *out, int max) const {",
+            "    int n = 0;",
+            "    for (Chunk<T, ChunkSize> *chunk = head; chunk != nullptr && n < max;",
+            "         chunk = chunk->next) {",
+            "      out[n++] = {chunk->data + chunk->begin,",
+            "                  static_cast<size_t>(chunk->end - chunk->begin)};",
+            "    }",
+            "    return n;",
+            "  }",
+            "",
+            "  // Drops count elements from the front, e.g. after writev sent them.",
+            "  void consume(size_t count) {",
+            "    if (count > static_cast<size_t>(size)) {",
+            "      throw std::out_of_range(\"Deque has fewer elements\");",
+            "    }",
+            "    size -= static_cast<int>(count);",
+            "    while (count > 0) {",
+            "      size_t available = head->end - head->begin;",
+            "      if (count < available) {",
+            "        head->begin += static_cast<int>(count);",
             "        break;",
             "      }",
+            "      count -= available;",
+            "      unlink(head);",
+            "    }",
+            "  }",
+            "",
+            "  // Writes up to max segments of free space at the back, together at least",
+            "  // want elements long when max allows, and returns how many were written.",
+            "  // Fill them (e.g. with readv), then call commit. No other modification may",
+            "  // happen in between.",
+            "  int backSegments(Segment<T> *out, int max, size_t want) {",
+            "    int n = 0;",
+            "    size_t room = 0;",
+            "    if (tail != nullptr && tail->end < ChunkSize && n < max) {",
+            "      out[n++] = {tail->data + tail->end,",
+            "                  static_cast<size_t>(ChunkSize - tail->end)};",
+            "      room += ChunkSize - tail->end;",
+            "    }",
+            "    Chunk<T, ChunkSize> **link = &spare;",
+            "    while (room < want && n < max) {",
+            "      if (*link == nullptr) {",
+            "        *link = new Chunk<T, ChunkSize>;",
+            "        (*link)->next = nullptr;",
+            "        spareCount++;",
+            "      }",
+            "      out[n++] = {(*link)->data, static_cast<size_t>(ChunkSize)};",
+            "      room += ChunkSize;",
+            "      link = &(*link)->next;",
+            "    }",
+            "    return n;",
+            "  }",
+            "",
+            "  // Appends count elements that were written into the back segments.",
+            "  void commit(size_t count) {",
+            "    size_t room = static_cast<size_t>(spareCount) * ChunkSize;",
+            "    if (tail != nullptr) {",
+            "      room += ChunkSize - tail->end;",
+            "    }",
+            "    if (count > room) {",
+            "      throw std::out_of_range(\"Commit exceeds reserved space\");",
+            "    }",
+            "",
+            "    size += static_cast<int>(count);",
+            "    if (tail != nullptr && tail->end < ChunkSize) {",
+            "      size_t filled =",
+            "          std::min(count, static_cast<size_t>(ChunkSize - tail->end));",
+            "      tail->end += static_cast<int>(filled);",
+            "      count -= filled;",
+            "    }",
+            "    while (count > 0) {",
+            "      // Spares come out in the order backSegments handed them out.",
+            "      Chunk<T, ChunkSize> *chunk = takeChunk(0);",
+            "      chunk->end = static_cast<int>(std::min(count, size_t(ChunkSize)));",
+            "      count -= chunk->end;",
+            "      linkBack(chunk);",
+            "    }",
+            "  }",
+            "",
+            "  bool isEmpty() const { return size == 0; }",
+            "",
+            "  int getSize() const { return size; }",
+            "",
+            "  // Formats all elements into one buffer and writes it with a single flush.",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Deque (size=\" << size << \"): \";",
+            "    visit([&buffer](const T &data) { buffer << data << \" \"; });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "  // Calls fn(data) for every element from front to back.",
+            "  template <typename Fn> void visit(Fn fn) const {",
+            "    for (Chunk<T, ChunkSize> *chunk = head; chunk != nullptr;",
+            "         chunk = chunk->next) {",
+            "      for (int i = chunk->begin; i < chunk->end; i++) {",
+            "        fn(chunk->data[i]);",
+            "      }",
+            "    }",
+            "  }",
+            "",
+            "private:",
+            "  // Spare chunks kept after they empty out, so a deque used as an I/O buffer",
+            "  // does not allocate in steady state.",
+            "  static const int MAX_SPARE = 2;",
+            "",
+            "  Chunk<T, ChunkSize> *head;",
+            "  Chunk<T, ChunkSize> *tail;",
+            "  Chunk<T, ChunkSize> *spare; // singly linked through next",
+            "  int spareCount;",
+            "  int size;",
+            "",
+            "  // The element is assigned before tail->end moves, and a new chunk is",
+            "  // linked only once the assignment into it succeeded, so a throwing",
+            "  // assignment leaves the deque unchanged.",
+            "  template <typename U> void pushBackValue(U &&data) {",
+            "    if (tail != nullptr && tail->end < ChunkSize) {",
+            "      tail->data[tail->end] = std::forward<U>(data);",
+            "      tail->end++;",
+            "    } else {",
+            "      Chunk<T, ChunkSize> *chunk = takeChunk(0);",
+            "      try {",
+            "        chunk->data[0] = std::forward<U>(data);",
+            "      } catch (...) {",
+            "        release(chunk);",
+            "        throw;",
+            "      }",
+            "      chunk->end = 1;",
+            "      linkBack(chunk);",
+            "    }",
+            "    size++;",
+            "  }",
+            "",
+            "  // Mirror of pushBackValue.",
+            "  template <typename U> void pushForwardValue(U &&data) {",
+            "    if (head != nullptr && head->begin > 0) {",
+            "      head->data[head->begin - 1] = std::forward<U>(data);",
+            "      head->begin--;",
+            "    } else {",
+            "      Chunk<T, ChunkSize> *chunk = takeChunk(ChunkSize);",
+            "      try {",
+            "        chunk->data[ChunkSize - 1] = std::forward<U>(data);",
+            "      } catch (...) {",
+            "        release(chunk);",
+            "        throw;",
+            "      }",
+            "      chunk->begin = ChunkSize - 1;",
+            "      linkForward(chunk);",
             "    }",
+            "    size++;",
             "  }",
             "",
-            "  void print(int index, int depth) const {",
-            "    if (index >= static_cast<int>(arr.size()))",
-            "      return;",
-            "",
-            "    int right = 2 * index + 2;",
-            "    int left = 2 * index + 1;",
-            "",
-            "    print(right, depth + 1);",
+            "  // Returns an empty chunk with begin = end = at, reusing a spare if any.",
+            "  Chunk<T, ChunkSize> *takeChunk(int at) {",
+            "    Chunk<T, ChunkSize> *chunk = spare;",
+            "    if (chunk != nullptr) {",
+            "      spare = chunk->next;",
+            "      spareCount--;",
+            "    } else {",
+            "      chunk = new Chunk<T, ChunkSize>;",
+            "    }",
+            "    chunk->begin = at;",
+            "    chunk->end = at;",
+            "    chunk->next = nullptr;",
+            "    chunk->prev = nullptr;",
+            "    return chunk;",
+            "  }",
             "",
-            "    for (int i = 0; i < depth; ++i) {",
-            "      std::cout << \"   \";",
+            "  void linkBack(Chunk<T, ChunkSize> *chunk) {",
+            "    chunk->prev = tail;",
+            "    if (tail == nullptr) {",
+            "      head = chunk;",
+            "    } else {",
+            "      tail->next = chunk;",
             "    }",
+            "    tail = chunk;",
+            "  }",
             "",
-            "    std::cout << arr[index] << std::endl;",
-            "    print(left, depth + 1);",
+            "  void linkForward(Chunk<T, ChunkSize> *chunk) {",
+            "    chunk->next = head;",
+            "    if (head == nullptr) {",
+            "      tail = chunk;",
+            "    } else {",
+            "      head->prev = chunk;",
+            "    }",
+            "    head = chunk;",
             "  }",
-            "};",
             "",
-            "template <typename T> bool minCompare(const T &a, const T &b) { return a < b; }",
-            "template <typename T> bool maxCompare(const T &a, const T &b) { return a > b; }",
+            "  // Removes an empty chunk from the list and keeps or frees it.",
+            "  void unlink(Chunk<T, ChunkSize> *chunk) {",
+            "    if (chunk->prev) {",
+            "      chunk->prev->next = chunk->next;",
+            "    } else {",
+            "      head = chunk->next;",
+            "    }",
+            "    if (chunk->next) {",
+            "      chunk->next->prev = chunk->prev;",
+            "    } else {",
+            "      tail = chunk->prev;",
+            "    }",
+            "    release(chunk);",
+            "  }",
             "",
-            "template <typename T = int> using MinHeap = Heap<T, minCompare<T>>;",
-            "template <typename T = int> using MaxHeap = Heap<T, maxCompare<T>>;",
+            "  // Keeps an unlinked chunk as a spare, or frees it.",
+            "  void release(Chunk<T, ChunkSize> *chunk) {",
+            "    if (spareCount < MAX_SPARE) {",
+            "      chunk->next = spare;",
+            "      spare = chunk;",
+            "      spareCount++;",
+            "    } else {",
+            "      delete chunk;",
+            "    }",
+            "  }",
             "",
-            "$1"
+            "  static void freeList(Chunk<T, ChunkSize> *chunk) {",
+            "    while (chunk != nullptr) {",
+            "      Chunk<T, ChunkSize> *next = chunk->next;",
+            "      delete chunk;",
+            "      chunk = next;",
+            "    }",
+            "  }",
+            "};"
         ]
     },
     {
-        "label": "Deque",
+        "label": "Hash Set",
         "body": [
+            "#include <cstdint>",
+            "#include <functional>",
             "#include <iostream>",
-            "",
-            "template <typename T> struct Node {",
-            "  T data;",
-            "  Node<T> *next;",
-            "  Node<T> *prev;",
-            "",
-            "  Node(T v) {",
-            "    data = v;",
-            "    next = nullptr;",
-            "    prev = nullptr;",
+            "#include <sstream>",
+            "#include <utility>",
+            "#include <vector>",
+            "#if defined(__SSE2__)",
+            "#include <emmintrin.h>",
+            "#endif",
+            "",
+            "// Control byte per slot: EMPTY, DELETED, or the low 7 bits of the key hash",
+            "// for a full slot. Slots are probed in aligned groups of 16 control bytes,",
+            "// compared all at once with SSE2 when available.",
+            "const int8_t CTRL_EMPTY = -128;",
+            "const int8_t CTRL_DELETED = -2;",
+            "const int GROUP_SIZE = 16;",
+            "",
+            "// Bit i is set when ctrl[i] == value, for the 16 bytes of a group.",
+            "inline uint32_t matchGroup(const int8_t *ctrl, int8_t value) {",
+            "#if defined(__SSE2__)",
+            "  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));",
+            "  return static_cast<uint32_t>(",
+            "      _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));",
+            "#else",
+            "  uint32_t mask = 0;",
+            "  for (int i = 0; i < GROUP_SIZE; i++) {",
+            "    if (ctrl[i] == value)",
+            "      mask |= 1u << i;",
             "  }",
-            "};",
-            "",
-            "template <typename T>",
-            "class Deque {",
+            "  return mask;",
+            "#endif",
+            "}",
+            "",
+            "// Bit i is set when slot i of the group is EMPTY or DELETED.",
+            "inline uint32_t matchFree(const int8_t *ctrl) {",
+            "#if defined(__SSE2__)",
+            "  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));",
+            "  return static_cast<uint32_t>(_mm_movemask_epi8(group));",
+            "#else",
+            "  uint32_t mask = 0;",
+            "  for (int i = 0; i < GROUP_SIZE; i++) {",
+            "    if (ctrl[i] < 0)",
+            "      mask |= 1u << i;",
+            "  }",
+            "  return mask;",
+            "#endif",
+            "}",
+            "",
+            "inline int lowestBit(uint32_t mask) {",
+            "#if defined(__GNUC__) || defined(__clang__)",
+            "  return __builtin_ctz(mask);",
+            "#else",
+            "  int i = 0;",
+            "  while (!(mask & 1)) {",
+            "    mask >>= 1;",
+            "    i++;",
+            "  }",
+            "  return i;",
+            "#endif",
+            "}",
+            "",
+            "// Open-addressing table shared by HashSetAbstract and HashMapAbstract. Slot",
+            "// must have a `key` member; keys are compared with ==. Slots are stored flat",
+            "// in one vector, so Slot must be default constructible, and the implicit",
+            "// copy and move operations copy or steal the whole table.",
+            "template <typename Slot, typename K, size_t (*Hash)(const K &)>",
+            "class SwissTable {",
             "public:",
-            "  Node<T> *head;",
-            "  Node<T> *tail;",
-            "  int size;",
-            "  Deque() {",
-            "    head = nullptr;",
-            "    tail = nullptr;",
-            "    size = 0;",
+            "  SwissTable() {",
+            "    count = 0;",
+            "    used = 0;",
             "  }",
             "",
-            "  ~Deque() {",
-            "    Node<T> *current = this->head;",
-            "    while (current != nullptr) {",
-            "      Node<T> *next = current->next;",
-            "      delete current;",
-            "      current = next;",
+            "  Slot *find(const K &key) {",
+            "    if (slots.empty())",
+            "      return nullptr;",
+            "",
+            "    uint64_t h = mix(key);",
+            "    int8_t h2 = static_cast<int8_t>(h & 0x7F);",
+            "    size_t groupMask = slots.size() / GROUP_SIZE - 1;",
+            "    size_t group = (h >> 7) & groupMask;",
+            "",
+            "    for (size_t step = 1;; step++) {",
+            "      const int8_t *ctrl = &control[group * GROUP_SIZE];",
+            "      for (uint32_t m = matchGroup(ctrl, h2); m; m &= m - 1) {",
+            "        Slot &slot = slots[group * GROUP_SIZE + lowestBit(m)];",
+            "        if (slot.key == key)",
+            "          return &slot;",
+            "      }",
+            "      if (matchGroup(ctrl, CTRL_EMPTY))",
+            "        return nullptr;",
+            "      group = (group + step) & groupMask;",
             "    }",
             "  }",
             "",
-            "  T popBack() {",
-            "    if (tail == nullptr) {",
-            "      throw std::runtime_error(\"Deque is empty\");",
+            "  // Returns the slot holding key, claiming a free one if key is new. U is K",
+            "  // or const K&; a new key is moved into its slot.",
+            "  template <typename U> Slot *findOrInsert(U &&key, bool &inserted) {",
+            "    Slot *slot = find(key);",
+            "    if (slot) {",
+            "      inserted = false;",
+            "      return slot;",
             "    }",
             "",
-            "    Node<T> *nodeToDelete = tail;",
-            "    T data = tail->data;",
+            "    if ((used + 1) * 8 > slots.size() * 7)",
+            "      rehash(count * 2 >= slots.size() ? slots.size() * 2 : slots.size());",
+            "",
+            "    uint64_t h = mix(key);",
+            "    size_t i = freeSlot(h);",
+            "    if (control[i] == CTRL_EMPTY)",
+            "      used++;",
+            "    control[i] = static_cast<int8_t>(h & 0x7F);",
+            "    slots[i].key = std::forward<U>(key);",
+            "    count++;",
+            "    inserted = true;",
+            "    return &slots[i];",
+            "  }",
             "",
-            "    if (head == tail) {",
-            "      head = nullptr;",
-            "      tail = nullptr;",
+            "  bool erase(const K &key) {",
+            "    Slot *slot = find(key);",
+            "    if (!slot)",
+            "      return false;",
+            "",
+            "    size_t i = static_cast<size_t>(slot - slots.data());",
+            "    // Probes never pass a group that has an EMPTY slot, so the slot can go",
+            "    // back to EMPTY instead of leaving a tombstone.",
+            "    if (matchGroup(&control[i / GROUP_SIZE * GROUP_SIZE], CTRL_EMPTY)) {",
+            "      control[i] = CTRL_EMPTY;",
+            "      used--;",
             "    } else {",
-            "      tail = tail->prev;",
-            "      tail->next = nullptr;",
+            "      control[i] = CTRL_DELETED;",
             "    }",
+            "    slots[i] = Slot();",
+            "    count--;",
+            "    return true;",
+            "  }",
             "",
-            "    delete nodeToDelete;",
-            "    size--;",
-            "    return data;",
+            "  void clear() {",
+            "    slots.clear();",
+            "    control.clear();",
+            "    count = 0;",
+            "    used = 0;",
             "  }",
             "",
-            "  T popForward() {",
-            "    if (head == nullptr) {",
-            "      throw std::runtime_error(\"Deque is empty\");",
-            "    }",
+            "  void reserve(size_t n) {",
+            "    size_t capacity = GROUP_SIZE;",
+            "    while (capacity * 7 < n * 8)",
+            "      capacity *= 2;",
+            "    if (capacity > slots.size())",
+            "      rehash(capacity);",
+            "  }",
             "",
-            "    Node<T> *nodeToDelete = head;",
-            "    T data = head->data;",
+            "  size_t size() const { return count; }",
             "",
-            "    if (head == tail) {",
-            "      head = nullptr;",
-            "      tail = nullptr;",
-            "    } else {",
-            "      head = head->next;",
-            "      head->prev = nullptr;",
+            "  void swap(SwissTable &other) noexcept {",
+            "    slots.swap(other.slots);",
+            "    control.swap(other.control);",
+            "    std::swap(count, other.count);",
+            "    std::swap(used, other.used);",
+            "  }",
+            "",
+            "  template <typename Fn> void visit(Fn fn) const {",
+            "    for (size_t i = 0; i < slots.size(); i++) {",
+            "      if (control[i] >= 0)",
+            "        fn(slots[i]);",
             "    }",
+            "  }",
             "",
-            "    delete nodeToDelete;",
-            "    size--;",
-            "    return data;",
+            "private:",
+            "  std::vector<Slot> slots;",
+            "  std::vector<int8_t> control;",
+            "  size_t count; // full slots",
+            "  size_t used;  // full plus DELETED slots",
+            "",
+            "  static uint64_t mix(const K &key) {",
+            "    uint64_t h = static_cast<uint64_t>(Hash(key)) * 0x9E3779B97F4A7C15ull;",
+            "    return h ^ (h >> 32);",
             "  }",
             "",
-            "  void pushBack(T data) {",
-            "    Node<T> *node = new Node<T>(data);",
+            "  size_t freeSlot(uint64_t h) const {",
+            "    size_t groupMask = slots.size() / GROUP_SIZE - 1;",
+            "    size_t group = (h >> 7) & groupMask;",
+            "    for (size_t step = 1;; step++) {",
+            "      uint32_t m = matchFree(&control[group * GROUP_SIZE]);",
+            "      if (m)",
+            "        return group * GROUP_SIZE + lowestBit(m);",
+            "      group = (group + step) & groupMask;",
+            "    }",
+            "  }",
             "",
-            "    if (tail == nullptr) {",
-            "      head = node;",
-            "      tail = node;",
-            "    } else {",
-            "      tail->next = node;",
-            "      node->prev = tail;",
-            "      tail = node;",
+            "  void rehash(size_t capacity) {",
+            "    if (capacity < GROUP_SIZE)",
+            "      capacity = GROUP_SIZE;",
+            "",
+            "    std::vector<Slot> oldSlots(capacity);",
+            "    std::vector<int8_t> oldControl(capacity, CTRL_EMPTY);",
+            "    oldSlots.swap(slots);",
+            "    oldControl.swap(control);",
+            "    used = count;",
+            "",
+            "    for (size_t i = 0; i < oldSlots.size(); i++) {",
+            "      if (oldControl[i] < 0)",
+            "        continue;",
+            "      size_t j = freeSlot(mix(oldSlots[i].key));",
+            "      control[j] = oldControl[i];",
+            "      slots[j] = std::move(oldSlots[i]);",
             "    }",
-            "    size++;",
             "  }",
+            "};",
             "",
-            "  void pushForward(T data) {",
-            "    Node<T> *node = new Node<T>(data);",
+            "template <typename T> struct SetSlot {",
+            "  T key;",
+            "};",
             "",
-            "    if (head == nullptr) {",
-            "      head = node;",
-            "      tail = node;",
-            "    } else {",
-            "      head->prev = node;",
-            "      node->next = head;",
-            "      head = node;",
-            "    }",
-            "    size++;",
+            "template <typename K, typename V> struct MapSlot {",
+            "  K key;",
+            "  V val;",
+            "};",
+            "",
+            "template <typename T, size_t (*Hash)(const T &)>",
+            "class HashSetAbstract {",
+            "public:",
+            "  void insert(const T &val) {",
+            "    bool inserted;",
+            "    table.findOrInsert(val, inserted);",
+            "  }",
+            "  void insert(T &&val) {",
+            "    bool inserted;",
+            "    table.findOrInsert(std::move(val), inserted);",
+            "  }",
+            "  T *search(const T &val) {",
+            "    SetSlot<T> *slot = table.find(val);",
+            "    return slot ? &(slot->key) : nullptr;",
+            "  }",
+            "  bool remove(const T &val) { return table.erase(val); }",
+            "  void clear() { table.clear(); }",
+            "  void swap(HashSetAbstract &other) noexcept { table.swap(other.table); }",
+            "  void reserve(int n) { table.reserve(n); }",
+            "  int size() const { return static_cast<int>(table.size()); }",
+            "",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"HashSet (size=\" << size() << \"): \";",
+            "    table.visit(",
+            "        [&buffer](const SetSlot<T> &slot) { buffer << slot.key << \" \"; });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
             "  }",
             "",
-            "  void print() {",
-            "    Node<T> *current = head;",
-            "    std::cout << \"Deque (size=\" << size << \"): \";",
-            "    while (current != nullptr) {",
-            "      std::cout << current->data << \" \";",
-            "      current = current->next;",
-            "    }",
-            "    std::cout << std::endl;",
+            "private:",
+            "  SwissTable<SetSlot<T>, T, Hash> table;",
+            "};",
+            "",
+            "template <typename K, typename V, size_t (*Hash)(const K &)>",
+            "class HashMapAbstract {",
+            "public:",
+            "  // Inserts key or overwrites its value. Both are taken by value and moved",
+            "  // into the slot, so rvalues are never copied.",
+            "  void insert(K key, V val) {",
+            "    bool inserted;",
+            "    table.findOrInsert(std::move(key), inserted)->val = std::move(val);",
+            "  }",
+            "  V *search(const K &key) {",
+            "    MapSlot<K, V> *slot = table.find(key);",
+            "    return slot ? &(slot->val) : nullptr;",
             "  }",
+            "  bool remove(const K &key) { return table.erase(key); }",
+            "  void clear() { table.clear(); }",
+            "  void swap(HashMapAbstract &other) noexcept { table.swap(other.table); }",
+            "  void reserve(int n) { table.reserve(n); }",
+            "  int size() const { return static_cast<int>(table.size()); }",
+            "",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"HashMap (size=\" << size() << \"): \";",
+            "    table.visit([&buffer](const MapSlot<K, V> &slot) {",
+            "      buffer << slot.key << \"=\" << slot.val << \" \";",
+            "    });",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
+            "",
+            "private:",
+            "  SwissTable<MapSlot<K, V>, K, Hash> table;",
             "};",
             "",
-            "$1"
-        ]
+            "template <typename T> size_t stdHash(const T &val) {",
+            "  return std::hash<T>()(val);",
+            "}",
+            "",
+            "template <typename T> using HashSet = HashSetAbstract<T, stdHash<T>>;",
+            "template <typename K, typename V>",
+            "using HashMap = HashMapAbstract<K, V, stdHash<K>>;"
+        ],
+        "threadSafe": true
     },
     {
-        "label": "Queue",
+        "label": "Intrusive Containers",
         "body": [
             "#include <iostream>",
+            "#include <sstream>",
+            "#include <stdexcept>",
+            "#include <utility>",
+            "",
+            "// Link hook embedded in the user's type. The containers below never allocate",
+            "// or copy: they splice the object itself through its hook, so an object can",
+            "// sit in at most one container per hook at a time, and moving it from one",
+            "// container to another is two O(1) pointer splices.",
+            "template <typename T> struct ListHook {",
+            "  T *next = nullptr;",
+            "  T *prev = nullptr;",
+            "};",
             "",
-            "template <typename T>",
-            "struct Node {",
-            "  T data;",
-            "  Node<T> *next;",
+            "// LIFO list over objects owned by the caller, see Stack.",
+            "template <typename T, ListHook<T> T::*Hook> class IntrusiveStack {",
+            "public:",
+            "  IntrusiveStack() {",
+            "    head = nullptr;",
+            "    size = 0;",
+            "  }",
+            "",
+            "  // Each object has one hook, so the links cannot be copied. Moving hands",
+            "  // the chain over and leaves other empty.",
+            "  IntrusiveStack(const IntrusiveStack &) = delete;",
+            "  IntrusiveStack &operator=(const IntrusiveStack &) = delete;",
+            "",
+            "  IntrusiveStack(IntrusiveStack &&other) noexcept : IntrusiveStack() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  IntrusiveStack &operator=(IntrusiveStack &&other) noexcept {",
+            "    clear();",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~IntrusiveStack() { clear(); }",
+            "",
+            "  void swap(IntrusiveStack &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void push(T &item) {",
+            "    size++;",
+            "    (item.*Hook).next = head;",
+            "    head = &item;",
+            "  }",
+            "",
+            "  T &pop() {",
+            "    if (isEmpty()) {",
+            "      throw std::runtime_error(\"Stack is empty\");",
+            "    }",
+            "",
+            "    size--;",
+            "    T *item = head;",
+            "    head = (item->*Hook).next;",
+            "    (item->*Hook).next = nullptr;",
+            "    return *item;",
+            "  }",
+            "",
+            "  // Unlinks every object; the objects themselves are not touched otherwise.",
+            "  void clear() {",
+            "    while (!isEmpty()) {",
+            "      pop();",
+            "    }",
+            "  }",
+            "",
+            "  bool isEmpty() const { return size == 0; }",
+            "",
+            "  int getSize() const { return size; }",
+            "",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Stack (size=\" << size << \"): \";",
+            "    for (T *current = head; current != nullptr;",
+            "         current = (current->*Hook).next) {",
+            "      buffer << *current << \" \";",
+            "    }",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
+            "  }",
             "",
-            "  Node(T data, Node<T> *next = nullptr) : data(data), next(next) {}",
+            "private:",
+            "  T *head;",
+            "  int size;",
             "};",
             "",
-            "template <typename T>",
-            "class Queue {",
+            "// FIFO list over objects owned by the caller, see Queue.",
+            "template <typename T, ListHook<T> T::*Hook> class IntrusiveQueue {",
             "public:",
-            "  Queue() {",
+            "  IntrusiveQueue() {",
             "    head = nullptr;",
             "    tail = nullptr;",
             "    size = 0;",
             "  }",
             "",
-            "  ~Queue() {",
-            "    Node<T> *current = this->head;",
-            "    while (current != nullptr) {",
-            "      Node<T> *next = current->next;",
-            "      delete current;",
-            "      current = next;",
-            "    }",
+            "  IntrusiveQueue(const IntrusiveQueue &) = delete;",
+            "  IntrusiveQueue &operator=(const IntrusiveQueue &) = delete;",
+            "",
+            "  IntrusiveQueue(IntrusiveQueue &&other) noexcept : IntrusiveQueue() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  IntrusiveQueue &operator=(IntrusiveQueue &&other) noexcept {",
+            "    clear();",
+            "    swap(other);",
+            "    return *this;",
             "  }",
             "",
-            "  void enqueue(T data) {",
+            "  ~IntrusiveQueue() { clear(); }",
+            "",
+            "  void swap(IntrusiveQueue &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(tail, other.tail);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void enqueue(T &item) {",
             "    size++;",
-            "    Node<T> *node = new Node<T>(data);",
+            "    (item.*Hook).next = nullptr;",
             "    if (tail == nullptr) {",
-            "      head = tail = node;",
+            "      head = tail = &item;",
             "    } else {",
-            "      tail->next = node;",
-            "      tail = node;",
+            "      (tail->*Hook).next = &item;",
+            "      tail = &item;",
             "    }",
             "  }",
             "",
-            "  T dequeue() {",
+            "  T &dequeue() {",
             "    if (size == 0) {",
             "      throw std::out_of_range(\"Queue is empty\");",
             "    }",
             "",
             "    size--;",
-            "    T data = head->data;",
-            "    Node<T> *oldHead = head;",
-            "    head = head->next;",
-            "    delete oldHead;",
+            "    T *item = head;",
+            "    head = (item->*Hook).next;",
+            "    (item->*Hook).next = nullptr;",
             "",
             "    if (head == nullptr) {",
             "      tail = nullptr;",
             "    }",
             "",
-            "    return data;",
+            "    return *item;",
             "  }",
             "",
-            "  bool isEmpty() { return size == 0; }",
+            "  void clear() {",
+            "    while (!isEmpty()) {",
+            "      dequeue();",
+            "    }",
+            "  }",
             "",
-            "  int getSize() { return size; }",
+            "  bool isEmpty() const { return size == 0; }",
             "",
-            "  void print() {",
-            "    Node<T> *current = head;",
-            "    std::cout << \"Queue (size=\" << size << \"): \";",
-            "    while (current != nullptr) {",
-            "      std::cout << current->data << \" \";",
-            "      current = current->next;",
+            "  int getSize() const { return size; }",
+            "",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Queue (size=\" << size << \"): \";",
+            "    for (T *current = head; current != nullptr;",
+            "         current = (current->*Hook).next) {",
+            "      buffer << *current << \" \";",
             "    }",
-            "    std::cout << std::endl;",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
             "  }",
             "",
             "private:",
-            "  Node<T> *head;",
-            "  Node<T> *tail;",
+            "  T *head;",
+            "  T *tail;",
             "  int size;",
             "};",
             "",
-            "$1"
-        ]
-    },
-    {
-        "label": "Stack",
-        "body": [
-            "#include <iostream>",
-            "",
-            "template <typename T>",
-            "struct Node {",
-            "  T data;",
-            "  Node<T> *next;",
-            "};",
-            "",
-            "template <typename T>",
-            "class Stack {",
+            "// Double-ended list over objects owned by the caller, see the deque Queue.",
+            "// Being doubly linked, it can also unlink any object in O(1) with remove().",
+            "template <typename T, ListHook<T> T::*Hook> class IntrusiveDeque {",
             "public:",
-            "  Stack() {",
+            "  IntrusiveDeque() {",
             "    head = nullptr;",
+            "    tail = nullptr;",
             "    size = 0;",
             "  }",
             "",
-            "  ~Stack() {",
-            "    Node<T> *current = head;",
-            "    while (current != nullptr) {",
-            "      Node<T> *next = current->next;",
-            "      delete current;",
-            "      current = next;",
+            "  IntrusiveDeque(const IntrusiveDeque &) = delete;",
+            "  IntrusiveDeque &operator=(const IntrusiveDeque &) = delete;",
+            "",
+            "  IntrusiveDeque(IntrusiveDeque &&other) noexcept : IntrusiveDeque() {",
+            "    swap(other);",
+            "  }",
+            "",
+            "  IntrusiveDeque &operator=(IntrusiveDeque &&other) noexcept {",
+            "    clear();",
+            "    swap(other);",
+            "    return *this;",
+            "  }",
+            "",
+            "  ~IntrusiveDeque() { clear(); }",
+            "",
+            "  void swap(IntrusiveDeque &other) noexcept {",
+            "    std::swap(head, other.head);",
+            "    std::swap(tail, other.tail);",
+            "    std::swap(size, other.size);",
+            "  }",
+            "",
+            "  void pushBack(T &item) {",
+            "    (item.*Hook).next = nullptr;",
+            "    (item.*Hook).prev = tail;",
+            "    if (tail == nullptr) {",
+            "      head = &item;",
+            "    } else {",
+            "      (tail->*Hook).next = &item;",
             "    }",
+            "    tail = &item;",
+            "    size++;",
             "  }",
             "",
-            "  T pop() {",
-            "    if (isEmpty()) {",
-            "      throw std::runtime_error(\"Stack is empty\");",
+            "  void pushForward(T &item) {",
+            "    (item.*Hook).prev = nullptr;",
+            "    (item.*Hook).next = head;",
+            "    if (head == nullptr) {",
+            "      tail = &item;",
+            "    } else {",
+            "      (head->*Hook).prev = &item;",
+            "    }",
+            "    head = &item;",
+            "    size++;",
+            "  }",
+            "",
+            "  T &popBack() {",
+            "    if (tail == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
+            "    }",
+            "    T *item = tail;",
+            "    remove(*item);",
+            "    return *item;",
+            "  }",
+            "",
+            "  T &popForward() {",
+            "    if (head == nullptr) {",
+            "      throw std::runtime_error(\"Deque is empty\");",
             "    }",
+            "    T *item = head;",
+            "    remove(*item);",
+            "    return *item;",
+            "  }",
             "",
+            "  // Unlinks item, which must currently be in this deque.",
+            "  void remove(T &item) {",
+            "    ListHook<T> &hook = item.*Hook;",
+            "    if (hook.prev) {",
+            "      (hook.prev->*Hook).next = hook.next;",
+            "    } else {",
+            "      head = hook.next;",
+            "    }",
+            "    if (hook.next) {",
+            "      (hook.next->*Hook).prev = hook.prev;",
+            "    } else {",
+            "      tail = hook.prev;",
+            "    }",
+            "    hook.next = nullptr;",
+            "    hook.prev = nullptr;",
             "    size--;",
-            "    T data = head->data;",
-            "    head = head->next;",
-            "    delete head;",
-            "    return data;",
             "  }",
             "",
-            "  void push(T data) {",
-            "    size++;",
-            "    Node<T> *node = new Node<T>(data);",
-            "    node->next = head;",
-            "    head = node;",
+            "  void clear() {",
+            "    while (head != nullptr) {",
+            "      popForward();",
+            "    }",
             "  }",
             "",
-            "  bool isEmpty() { return size == 0; }",
+            "  bool isEmpty() const { return size == 0; }",
             "",
-            "  int getSize() { return size; }",
+            "  int getSize() const { return size; }",
             "",
-            "  void print() {",
-            "    Node<T> *current = head;",
-            "    std::cout << \"Stack (size=\" << size << \"): \";",
-            "    while (current != nullptr) {",
-            "      std::cout << current->data << \" \";",
-            "      current = current->next;",
+            "  void print(std::ostream &out = std::cout) const {",
+            "    std::ostringstream buffer;",
+            "    buffer << \"Deque (size=\" << size << \"): \";",
+            "    for (T *current = head; current != nullptr;",
+            "         current = (current->*Hook).next) {",
+            "      buffer << *current << \" \";",
             "    }",
-            "    std::cout << std::endl;",
+            "    buffer << '\\n';",
+            "    out << buffer.str() << std::flush;",
             "  }",
             "",
             "private:",
-            "  Node<T> *head;",
+            "  T *head;",
+            "  T *tail;",
             "  int size;",
-            "};",
-            "",
-            "$1"
-        ]
+            "};"
+        ],
+        "threadSafe": true
     }
-];
\ No newline at end of file
+];
+
+export const fragments: Fragments = {
+    "nodePool": [
+        "#include <cstddef>",
+        "#include <mutex>",
+        "#include <new>",
+        "",
+        "// Free-list allocator for one node size, hooked into Node by operator new",
+        "// and delete. Nodes are carved from blocks of BLOCK_NODES and recycled",
+        "// through an intrusive free list, so steady-state inserts and removes never",
+        "// reach malloc. Blocks are kept for the life of the program. With",
+        "// ThreadSafe the list is guarded by a mutex; otherwise the pool must only be",
+        "// used from one thread.",
+        "template <size_t Size, size_t Align, bool ThreadSafe> class NodePool {",
+        "public:",
+        "  static void *allocate() {",
+        "    State &s = state();",
+        "    std::unique_lock<std::mutex> lock(s.mutex, std::defer_lock);",
+        "    if (ThreadSafe)",
+        "      lock.lock();",
+        "    if (s.free == nullptr)",
+        "      refill(s);",
+        "    FreeSlot *slot = s.free;",
+        "    s.free = slot->next;",
+        "    return slot;",
+        "  }",
+        "",
+        "  static void release(void *p) {",
+        "    State &s = state();",
+        "    std::unique_lock<std::mutex> lock(s.mutex, std::defer_lock);",
+        "    if (ThreadSafe)",
+        "      lock.lock();",
+        "    FreeSlot *slot = static_cast<FreeSlot *>(p);",
+        "    slot->next = s.free;",
+        "    s.free = slot;",
+        "  }",
+        "",
+        "private:",
+        "  static_assert(Align <= alignof(std::max_align_t),",
+        "                \"NodePool does not support over-aligned nodes\");",
+        "",
+        "  static const size_t BLOCK_NODES = 1024;",
+        "",
+        "  struct FreeSlot {",
+        "    FreeSlot *next;",
+        "  };",
+        "",
+        "  // Slot stride: large enough for a node or a free-list link, and a",
+        "  // multiple of the fundamental alignment.",
+        "  static const size_t SLOT =",
+        "      ((Size > sizeof(FreeSlot) ? Size : sizeof(FreeSlot)) +",
+        "       alignof(std::max_align_t) - 1) /",
+        "      alignof(std::max_align_t) * alignof(std::max_align_t);",
+        "",
+        "  struct State {",
+        "    FreeSlot *free = nullptr;",
+        "    std::mutex mutex;",
+        "  };",
+        "",
+        "  // Never destroyed, so nodes freed by static containers at exit still",
+        "  // find the pool.",
+        "  static State &state() {",
+        "    static State *s = new State;",
+        "    return *s;",
+        "  }",
+        "",
+        "  static void refill(State &s) {",
+        "    unsigned char *block =",
+        "        static_cast<unsigned char *>(::operator new(SLOT * BLOCK_NODES));",
+        "    for (size_t i = BLOCK_NODES; i-- > 0;) {",
+        "      FreeSlot *slot = reinterpret_cast<FreeSlot *>(block + i * SLOT);",
+        "      slot->next = s.free;",
+        "      s.free = slot;",
+        "    }",
+        "  }",
+        "};"
+    ],
+    "locked": [
+        "#include <mutex>",
+        "#include <utility>",
+        "",
+        "// Container behind a mutex. withLock(fn) runs fn(container) under the lock",
+        "// and returns its result, so several calls made inside one fn happen as one",
+        "// atomic step. Pointers and references into the container must not escape",
+        "// fn.",
+        "template <typename Container> class Locked {",
+        "public:",
+        "  template <typename... Args>",
+        "  explicit Locked(Args &&...args) : container(std::forward<Args>(args)...) {}",
+        "",
+        "  Locked(const Locked &) = delete;",
+        "  Locked &operator=(const Locked &) = delete;",
+        "",
+        "  template <typename Fn> auto withLock(Fn fn) {",
+        "    std::lock_guard<std::mutex> lock(mutex);",
+        "    return fn(container);",
+        "  }",
+        "",
+        "  template <typename Fn> auto withLock(Fn fn) const {",
+        "    std::lock_guard<std::mutex> lock(mutex);",
+        "    return fn(static_cast<const Container &>(container));",
+        "  }",
+        "",
+        "private:",
+        "  mutable std::mutex mutex;",
+        "  Container container;",
+        "};"
+    ],
+    "instrumentation": [
+        "#include <atomic>",
+        "#include <iostream>",
+        "",
+        "// Process-wide counters summed over every container in the snippet: key",
+        "// comparisons made through the comparator, and node allocations and frees.",
+        "// Counting is relaxed-atomic, so instrumented containers stay usable from",
+        "// several threads.",
+        "struct Instrumentation {",
+        "  static inline std::atomic<long long> comparisons{0};",
+        "  static inline std::atomic<long long> allocations{0};",
+        "  static inline std::atomic<long long> releases{0};",
+        "",
+        "  static void reset() {",
+        "    comparisons = 0;",
+        "    allocations = 0;",
+        "    releases = 0;",
+        "  }",
+        "",
+        "  static void print(std::ostream &out = std::cout) {",
+        "    out << \"comparisons: \" << comparisons << \", allocations: \" << allocations",
+        "        << \", releases: \" << releases << \", live nodes: \"",
+        "        << allocations - releases << std::endl;",
+        "  }",
+        "};"
+    ]
+};
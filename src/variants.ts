@@ -0,0 +1,180 @@
+// Assembles the code inserted for a snippet from its generated template and
+// the performance options picked for it.
+import { fragments } from './snippets';
+
+export interface SnippetTemplate {
+	label: string;
+	// Source file without its demo main().
+	body: string[];
+	// Offer the Locked wrapper.
+	threadSafe: boolean;
+	// Alternative body with array-backed storage, when there is one.
+	arrayBacked?: string[];
+}
+
+export interface Fragments {
+	nodePool: string[];
+	locked: string[];
+	instrumentation: string[];
+}
+
+export type OptionId = 'pool' | 'threadSafe' | 'arrayBacked' | 'instrumentation';
+
+export interface SnippetOption {
+	id: OptionId;
+	label: string;
+	description: string;
+}
+
+const allOptions: SnippetOption[] = [
+	{ id: 'pool', label: 'Pool allocator', description: 'Recycle nodes through a free-list pool instead of new/delete; locks if the code uses threads' },
+	{ id: 'threadSafe', label: 'Thread-safe variant', description: 'Add a Locked<Container> wrapper; the pool takes a mutex' },
+	{ id: 'arrayBacked', label: 'Array-backed storage', description: 'Store elements in arrays instead of one allocation per node' },
+	{ id: 'instrumentation', label: 'Instrumentation', description: 'Count comparisons and node allocations' },
+];
+
+const NODE_STRUCT = /^(template <typename T> )?struct Node \{$/;
+const NODE_NEW = /new Node<T>[({]/;
+// Code that allocates nodes from several threads on its own, so the pool
+// must lock even without the Locked wrapper.
+const CONCURRENT = /\b(ThreadPool|BlockingQueue)\b/;
+const COMPARATOR = /^template <typename T> bool (\w+Compare)\(const T &a, const T &b\) \{ return (.+); \}$/;
+
+function bodyFor(template: SnippetTemplate, picked: Set<OptionId>): string[] {
+	return picked.has('arrayBacked') && template.arrayBacked ? template.arrayBacked : template.body;
+}
+
+// Options that change something for this snippet. Pool and node counters
+// need nodes allocated with `new Node<T>`; comparison counters need one of
+// the shared comparator functions.
+export function availableOptions(template: SnippetTemplate): SnippetOption[] {
+	const bodies = [template.body, ...(template.arrayBacked ? [template.arrayBacked] : [])];
+	const allocates = bodies.some(body => body.some(line => NODE_NEW.test(line)));
+	const compares = bodies.some(body => body.some(line => COMPARATOR.test(line)));
+	return allOptions.filter(option => {
+		switch (option.id) {
+			case 'pool': return allocates;
+			case 'threadSafe': return template.threadSafe;
+			case 'arrayBacked': return template.arrayBacked !== undefined;
+			case 'instrumentation': return allocates || compares;
+		}
+	});
+}
+
+// Node::operator new/delete routing allocations through the pool and the
+// counters. The pool is shared by every container of the type, so it locks
+// when the snippet is made thread-safe or runs node code on other threads.
+function nodeHooks(picked: Set<OptionId>, concurrent: boolean): string[] {
+	const pool = 'NodePool<sizeof(Node), alignof(Node), ' + (picked.has('threadSafe') || concurrent ? 'true' : 'false') + '>';
+	const count = picked.has('instrumentation');
+	const allocate = picked.has('pool') ? `return ${pool}::allocate();` : 'return ::operator new(size);';
+	const release = picked.has('pool') ? `${pool}::release(p);` : '::operator delete(p);';
+	return [
+		'',
+		picked.has('pool') ? '  static void *operator new(size_t) {' : '  static void *operator new(size_t size) {',
+		...(count ? ['    Instrumentation::allocations.fetch_add(1, std::memory_order_relaxed);'] : []),
+		'    ' + allocate,
+		'  }',
+		'',
+		'  static void operator delete(void *p) {',
+		...(count ? ['    Instrumentation::releases.fetch_add(1, std::memory_order_relaxed);'] : []),
+		'    ' + release,
+		'  }',
+	];
+}
+
+function hookNodes(lines: string[], picked: Set<OptionId>): string[] {
+	const concurrent = lines.some(line => CONCURRENT.test(line));
+	const out: string[] = [];
+	let inNode = false;
+	for (const line of lines) {
+		if (NODE_STRUCT.test(line)) {
+			inNode = true;
+		} else if (inNode && line === '};') {
+			out.push(...nodeHooks(picked, concurrent));
+			inNode = false;
+		}
+		out.push(line);
+	}
+	return out;
+}
+
+function countComparisons(lines: string[]): string[] {
+	return lines.flatMap(line => {
+		const match = COMPARATOR.exec(line);
+		if (!match) {
+			return [line];
+		}
+		return [
+			`template <typename T> bool ${match[1]}(const T &a, const T &b) {`,
+			'  Instrumentation::comparisons.fetch_add(1, std::memory_order_relaxed);',
+			`  return ${match[2]};`,
+			'}',
+		];
+	});
+}
+
+// Splits a fragment into its #include lines and the code after them.
+function splitIncludes(lines: string[]): [string[], string[]] {
+	const includes = lines.filter(line => line.startsWith('#include '));
+	const code = lines.filter(line => !line.startsWith('#include '));
+	while (code.length > 0 && code[0].trim() === '') {
+		code.shift();
+	}
+	return [includes, code];
+}
+
+// Merges includes into the leading block of plain includes, which stays
+// sorted, and puts `code` right after that block.
+function addPrelude(lines: string[], includes: string[], code: string[]): string[] {
+	let end = 0;
+	while (end < lines.length && lines[end].startsWith('#include ')) {
+		end++;
+	}
+	const merged = [...new Set([...lines.slice(0, end), ...includes])].sort();
+	let rest = lines.slice(end);
+	const conditional: string[] = [];
+	while (rest.length > 0 && /^(#if |#include |#endif)/.test(rest[0])) {
+		conditional.push(rest[0]);
+		rest = rest.slice(1);
+	}
+	const prelude = code.length > 0 ? ['', ...code] : [];
+	return [...merged, ...conditional, ...prelude, ...rest];
+}
+
+export function buildSnippet(template: SnippetTemplate, picked: Set<OptionId>): string {
+	const available = new Set(availableOptions(template).map(option => option.id));
+	const options = new Set([...picked].filter(id => available.has(id)));
+
+	let lines = bodyFor(template, options);
+	const allocates = lines.some(line => NODE_NEW.test(line));
+	const hooked = allocates && (options.has('pool') || options.has('instrumentation'));
+
+	if (hooked) {
+		lines = hookNodes(lines, options);
+	}
+	if (options.has('instrumentation')) {
+		lines = countComparisons(lines);
+	}
+
+	const includes: string[] = hooked ? ['#include <cstddef>'] : [];
+	const code: string[] = [];
+	for (const [enabled, fragment] of [
+		[options.has('instrumentation'), fragments.instrumentation],
+		[hooked && options.has('pool'), fragments.nodePool],
+	] as [boolean, string[]][]) {
+		if (enabled) {
+			const [fragmentIncludes, fragmentCode] = splitIncludes(fragment);
+			includes.push(...fragmentIncludes);
+			code.push(...fragmentCode, '');
+		}
+	}
+	if (options.has('threadSafe')) {
+		const [lockedIncludes, lockedCode] = splitIncludes(fragments.locked);
+		includes.push(...lockedIncludes);
+		lines = [...lines, '', ...lockedCode];
+	}
+
+	lines = addPrelude(lines, includes, code.slice(0, -1));
+	return lines.join('\n') + '\n';
+}